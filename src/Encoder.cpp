@@ -0,0 +1,147 @@
+
+#include <string.h>
+#include <strings.h>
+#include "Encoder.h"
+#include "Encoder_Wav.h"
+#include "Encoder_Flac.h"
+
+Encoder::Encoder( FILE * _fp, unsigned int _rate ) : fp( _fp ), rate( _rate ), written( 0 ), failed( false ),
+    running( false ), finishing( false ), head( 0 ), queued( 0 ) {
+    queue = new short[ QUEUE_SIZE ];
+    pthread_mutex_init( &lock, 0 );
+    pthread_cond_init( &changed, 0 );
+}
+
+Encoder::~Encoder() {
+    finish();
+    pthread_cond_destroy( &changed );
+    pthread_mutex_destroy( &lock );
+    delete[] queue;
+}
+
+// the encoder for a codec, 0 for unknown codecs; "pcm" is a plain WAV file,
+// raw samples need no encoder
+Encoder * Encoder::create( const char * codec, FILE * fp, unsigned int rate ) {
+    if ( strcmp( codec, "pcm" ) == 0 )
+        return new Encoder_Wav( fp, rate, Encoder_Wav::PCM );
+    if ( strcmp( codec, "ulaw" ) == 0 )
+        return new Encoder_Wav( fp, rate, Encoder_Wav::ULAW );
+    if ( strcmp( codec, "alaw" ) == 0 )
+        return new Encoder_Wav( fp, rate, Encoder_Wav::ALAW );
+    if ( strcmp( codec, "adpcm" ) == 0 )
+        return new Encoder_Wav( fp, rate, Encoder_Wav::IMA_ADPCM );
+    if ( strcmp( codec, "flac" ) == 0 )
+        return new Encoder_Flac( fp, rate );
+    return 0;
+}
+
+bool Encoder::known( const char * codec ) {
+    return strcmp( codec, "pcm" ) == 0 || strcmp( codec, "ulaw" ) == 0 || strcmp( codec, "alaw" ) == 0
+        || strcmp( codec, "adpcm" ) == 0 || strcmp( codec, "flac" ) == 0;
+}
+
+// the codec a filename asks for, 0 if the extension doesn't say
+const char * Encoder::codecForFilename( const char * filename ) {
+    const char * ext = filename ? strrchr( filename, '.' ) : 0;
+    if ( ext && strcasecmp( ext, ".flac" ) == 0 )
+        return "flac";
+    return 0;
+}
+
+const char * Encoder::suffix( const char * codec ) {
+    return strcmp( codec, "flac" ) == 0 ? ".flac" : ".wav";
+}
+
+int Encoder::start() {
+    if ( pthread_create( &thread, 0, &Encoder::run, this ) != 0 ) {
+        fprintf( stderr, "error: couldn't start the encoder\n" );
+        return -1;
+    }
+    running = true;
+    return 0;
+}
+
+// queue samples for encoding, waits while the queue is full
+void Encoder::submit( const short * samples, unsigned int count ) {
+    pthread_mutex_lock( &lock );
+    while ( count > 0 ) {
+        while ( queued == QUEUE_SIZE ) {
+            pthread_cond_wait( &changed, &lock );
+        }
+        unsigned int tail = (head + queued) % QUEUE_SIZE;
+        unsigned int n = QUEUE_SIZE - tail;
+        if ( n > QUEUE_SIZE - queued )
+            n = QUEUE_SIZE - queued;
+        if ( n > count )
+            n = count;
+        memcpy( queue + tail, samples, n * sizeof(short) );
+        queued += n;
+        samples += n;
+        count -= n;
+        pthread_cond_broadcast( &changed );
+    }
+    pthread_mutex_unlock( &lock );
+}
+
+// encode what is queued, complete the output and stop the thread
+int Encoder::finish() {
+    if ( !running )
+        return failed ? -1 : 0;
+
+    pthread_mutex_lock( &lock );
+    finishing = true;
+    pthread_cond_broadcast( &changed );
+    pthread_mutex_unlock( &lock );
+
+    pthread_join( thread, 0 );
+    running = false;
+    fflush( fp );
+    return failed ? -1 : 0;
+}
+
+void * Encoder::run( void * arg ) {
+    Encoder * self = (Encoder *) arg;
+
+    self->writeHeader();
+
+    pthread_mutex_lock( &self->lock );
+    while ( 1 ) {
+        while ( self->queued == 0 && !self->finishing ) {
+            pthread_cond_wait( &self->changed, &self->lock );
+        }
+        if ( self->queued == 0 )
+            break;
+
+        // encode a contiguous part of the queue without holding the lock,
+        // submit() only writes behind it
+        unsigned int n = QUEUE_SIZE - self->head;
+        if ( n > self->queued )
+            n = self->queued;
+        const short * samples = self->queue + self->head;
+        pthread_mutex_unlock( &self->lock );
+
+        self->encode( samples, n );
+
+        pthread_mutex_lock( &self->lock );
+        self->head = (self->head + n) % QUEUE_SIZE;
+        self->queued -= n;
+        pthread_cond_broadcast( &self->changed );
+    }
+    pthread_mutex_unlock( &self->lock );
+
+    self->writeTrailer();
+    return 0;
+}
+
+void Encoder::put( const void * data, size_t size ) {
+    if ( fwrite( data, 1, size, fp ) != size && !failed ) {
+        fprintf( stderr, "error: writing encoded output failed\n" );
+        failed = true;
+    }
+    written += size;
+}
+
+// headers can be completed at the end, not so for a pipe
+bool Encoder::seekable() {
+    return fseek( fp, 0, SEEK_CUR ) == 0;
+}
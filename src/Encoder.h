@@ -0,0 +1,67 @@
+#ifndef __Encoder__
+#define __Encoder__
+
+#include <stdio.h>
+#include <pthread.h>
+
+/*
+================================================
+Encoder
+
+compresses the 16-bit mono output of pico into a file or stream, at the
+output rate (16 kHz unless resampled).
+The samples are queued by submit() and encoded on a thread of their own,
+so writing the output doesn't hold up the synthesis.
+
+Codecs: "pcm" (16-bit WAV; on stdout the samples go out as they are,
+without an encoder), "ulaw" and "alaw" (G.711 in WAV), "adpcm" (IMA ADPCM in
+WAV) and "flac".
+================================================
+*/
+class Encoder {
+public:
+    static Encoder * create( const char * codec, FILE * fp, unsigned int rate );
+    static bool known( const char * codec );
+    static const char * codecForFilename( const char * filename );
+    static const char * suffix( const char * codec );
+    static const char * names() { return "pcm, ulaw, alaw, adpcm, flac"; }
+
+    virtual ~Encoder();
+
+    int start();
+    void submit( const short * samples, unsigned int count );
+    int finish();
+    size_t bytesWritten() const { return written; }
+
+protected:
+    Encoder( FILE * fp, unsigned int rate );
+
+    // called on the encoding thread
+    virtual void writeHeader() = 0;
+    virtual void encode( const short * samples, unsigned int count ) = 0;
+    virtual void writeTrailer() = 0;
+
+    void put( const void * data, size_t size );
+    bool seekable();
+
+    FILE *          fp;
+    unsigned int    rate;               // samples a second
+    size_t          written;
+    bool            failed;
+
+private:
+    enum { QUEUE_SIZE = 1 << 16 };      // samples, 4 s
+
+    static void * run( void * );
+
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  changed;
+    bool            running;
+    bool            finishing;
+    short *         queue;
+    unsigned int    head;               // next sample to encode
+    unsigned int    queued;
+};
+
+#endif // __Encoder__
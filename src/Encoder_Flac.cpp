@@ -0,0 +1,281 @@
+
+// FLAC: frames of 4096 samples, each one a constant, verbatim or fixed
+// predictor subframe, whichever is smallest. The residuals are Rice coded
+// in up to 256 partitions with a parameter each. The MD5 in the STREAMINFO
+// is left at 0, which means "not computed".
+#include <string.h>
+#include "Encoder_Flac.h"
+
+static unsigned char crc8( const unsigned char * data, unsigned int len ) {
+    unsigned char crc = 0;
+    while ( len-- ) {
+        crc ^= *data++;
+        for ( int i = 0; i < 8; i++ )
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    return crc;
+}
+
+static unsigned short crc16( const unsigned char * data, unsigned int len ) {
+    unsigned short crc = 0;
+    while ( len-- ) {
+        crc ^= *data++ << 8;
+        for ( int i = 0; i < 8; i++ )
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x8005 : crc << 1;
+    }
+    return crc;
+}
+
+// the frame header code of a sample rate; 0 means "see STREAMINFO"
+static unsigned int rate_code( unsigned int rate ) {
+    static const unsigned int rates[] = { 0, 88200, 176400, 192000, 8000, 16000, 22050,
+                                          24000, 32000, 44100, 48000, 96000 };
+    for ( unsigned int i = 1; i < sizeof(rates) / sizeof(rates[0]); i++ )
+        if ( rates[i] == rate )
+            return i;
+    return 0;
+}
+
+static inline unsigned int fold( int residual ) {
+    return residual >= 0 ? (unsigned int) residual << 1 : ((unsigned int) -residual << 1) - 1;
+}
+
+Encoder_Flac::Encoder_Flac( FILE * fp, unsigned int rate ) : Encoder( fp, rate ), patch_info( false ),
+    block_used( 0 ), frame_number( 0 ), total_samples( 0 ),
+    min_frame_size( 0 ), max_frame_size( 0 ), frame_bytes( 0 ), bit_buffer( 0 ), bit_count( 0 ) {
+}
+
+Encoder_Flac::~Encoder_Flac() {
+    finish();
+}
+
+// append the low 'count' bits of value (at most 24), most significant first
+void Encoder_Flac::bits( unsigned int value, int count ) {
+    bit_buffer = (bit_buffer << count) | (value & ((1u << count) - 1));
+    bit_count += count;
+    while ( bit_count >= 8 ) {
+        bit_count -= 8;
+        frame[ frame_bytes++ ] = bit_buffer >> bit_count;
+    }
+}
+
+void Encoder_Flac::alignBits() {
+    if ( bit_count > 0 )
+        bits( 0, 8 - bit_count );
+}
+
+void Encoder_Flac::writeHeader() {
+    // the totals are only known at the end
+    patch_info = seekable();
+
+    put( "fLaC", 4 );
+    unsigned char block_header[4] = { 0x80, 0, 0, 34 };     // last metadata block, STREAMINFO
+    put( block_header, 4 );
+    streamInfo();
+    put( frame, frame_bytes );
+}
+
+// the STREAMINFO block, into frame[]
+void Encoder_Flac::streamInfo() {
+    frame_bytes = 0;
+    bits( BLOCK_SIZE, 16 );                     // min block size
+    bits( BLOCK_SIZE, 16 );                     // max block size
+    bits( min_frame_size, 24 );
+    bits( max_frame_size, 24 );
+    bits( rate, 20 );
+    bits( 0, 3 );                               // channels - 1
+    bits( 15, 5 );                              // bits per sample - 1
+    bits( total_samples >> 32, 4 );
+    bits( total_samples >> 16, 16 );
+    bits( total_samples, 16 );
+    for ( int i = 0; i < 16; i++ )
+        bits( 0, 8 );                           // MD5 unknown
+}
+
+void Encoder_Flac::encode( const short * in, unsigned int count ) {
+    while ( count > 0 ) {
+        unsigned int n = BLOCK_SIZE - block_used;
+        if ( n > count )
+            n = count;
+        memcpy( block + block_used, in, n * sizeof(short) );
+        block_used += n;
+        in += n;
+        count -= n;
+        if ( block_used == BLOCK_SIZE )
+            encodeFrame();
+    }
+}
+
+void Encoder_Flac::encodeFrame() {
+    int n = block_used;
+
+    frame_bytes = 0;
+    bits( 0x3ffe, 14 );                         // sync
+    bits( 0, 1 );
+    bits( 0, 1 );                               // fixed block size
+    bits( n == BLOCK_SIZE ? 12 : 7, 4 );        // 4096, or 16 bits at the end of the header
+    bits( rate_code( rate ), 4 );
+    bits( 0, 4 );                               // mono
+    bits( 4, 3 );                               // 16 bits a sample
+    bits( 0, 1 );
+
+    // frame number, UTF-8 coded
+    if ( frame_number < 0x80 ) {
+        bits( frame_number, 8 );
+    } else {
+        int extra = frame_number < 0x800 ? 1 : frame_number < 0x10000 ? 2 : frame_number < 0x200000 ? 3
+                  : frame_number < 0x4000000 ? 4 : 5;
+        bits( (0xff00 >> (extra + 1)) | (frame_number >> (6 * extra)), 8 );
+        for ( int i = extra - 1; i >= 0; i-- )
+            bits( 0x80 | ((frame_number >> (6 * i)) & 0x3f), 8 );
+    }
+    if ( n != BLOCK_SIZE )
+        bits( n - 1, 16 );
+    bits( crc8( frame, frame_bytes ), 8 );
+
+    encodeSubframe( n );
+
+    alignBits();
+    unsigned short crc = crc16( frame, frame_bytes );
+    bits( crc, 16 );
+
+    put( frame, frame_bytes );
+    if ( min_frame_size == 0 || frame_bytes < min_frame_size )
+        min_frame_size = frame_bytes;
+    if ( frame_bytes > max_frame_size )
+        max_frame_size = frame_bytes;
+
+    total_samples += n;
+    frame_number++;
+    block_used = 0;
+}
+
+void Encoder_Flac::encodeSubframe( int n ) {
+    int i, order;
+
+    // constant
+    for ( i = 1; i < n && block[i] == block[0]; i++ )
+        ;
+    if ( i == n ) {
+        bits( 0, 8 );
+        bits( (unsigned short) block[0], 16 );
+        return;
+    }
+
+    // the fixed predictor with the fewest bits
+    int best_order = -1;
+    int best_partition_order = 0;
+    unsigned int best_bits = 16 * n;            // verbatim
+    int parameters[ 1 << MAX_PARTITION_ORDER ];
+
+    for ( order = 0; order <= MAX_ORDER && order < n; order++ ) {
+        int * r = residual[ order ];
+        const short * x = block;
+        for ( i = order; i < n; i++ ) {
+            switch ( order ) {
+            case 0: r[i] = x[i]; break;
+            case 1: r[i] = x[i] - x[i-1]; break;
+            case 2: r[i] = x[i] - 2 * x[i-1] + x[i-2]; break;
+            case 3: r[i] = x[i] - 3 * x[i-1] + 3 * x[i-2] - x[i-3]; break;
+            case 4: r[i] = x[i] - 4 * x[i-1] + 6 * x[i-2] - 4 * x[i-3] + x[i-4]; break;
+            }
+        }
+        for ( int p = 0; p <= MAX_PARTITION_ORDER; p++ ) {
+            if ( (n & ((1 << p) - 1)) || (n >> p) <= order )
+                break;
+            unsigned int size = 16 * order + residualBits( r, n, order, p, parameters );
+            if ( size < best_bits ) {
+                best_bits = size;
+                best_order = order;
+                best_partition_order = p;
+            }
+        }
+    }
+
+    if ( best_order < 0 ) {
+        bits( 1 << 1, 8 );                      // verbatim
+        for ( i = 0; i < n; i++ )
+            bits( (unsigned short) block[i], 16 );
+        return;
+    }
+
+    order = best_order;
+    int * r = residual[ order ];
+    residualBits( r, n, order, best_partition_order, parameters );
+
+    bits( (8 | order) << 1, 8 );                // fixed, no wasted bits
+    for ( i = 0; i < order; i++ )
+        bits( (unsigned short) block[i], 16 );
+
+    bits( 0, 2 );                               // Rice, 4-bit parameters
+    bits( best_partition_order, 4 );
+    int partitions = 1 << best_partition_order;
+    int start = order;
+    for ( int p = 0; p < partitions; p++ ) {
+        int end = (p + 1) * (n >> best_partition_order);
+        int k = parameters[p];
+        bits( k, 4 );
+        for ( i = start; i < end; i++ ) {
+            unsigned int u = fold( r[i] );
+            unsigned int q = u >> k;
+            while ( q >= 24 ) {
+                bits( 0, 24 );
+                q -= 24;
+            }
+            bits( 1, q + 1 );
+            if ( k )
+                bits( u, k );
+        }
+        start = end;
+    }
+}
+
+// size of the Rice coded residuals of a subframe, with the best parameter
+// for each partition
+unsigned int Encoder_Flac::residualBits( const int * r, int n, int order,
+                                         int partition_order, int * parameters ) {
+    unsigned int total = 2 + 4;
+    int partitions = 1 << partition_order;
+    int start = order;
+
+    for ( int p = 0; p < partitions; p++ ) {
+        int end = (p + 1) * (n >> partition_order);
+        int count = end - start;
+        unsigned long long sum = 0;
+        for ( int i = start; i < end; i++ )
+            sum += fold( r[i] );
+
+        // the parameter is near log2 of the mean, try its neighbours too
+        int guess = 0;
+        while ( guess < MAX_RICE_PARAMETER && ((unsigned long long) count << (guess + 1)) <= sum )
+            guess++;
+
+        unsigned long long best = ~0ull;
+        for ( int k = guess > 0 ? guess - 1 : 0; k <= guess + 1 && k <= MAX_RICE_PARAMETER; k++ ) {
+            unsigned long long size = (unsigned long long) count * (k + 1);
+            for ( int i = start; i < end; i++ )
+                size += fold( r[i] ) >> k;
+            if ( size < best ) {
+                best = size;
+                parameters[p] = k;
+            }
+        }
+
+        total += 4 + best;
+        start = end;
+    }
+    return total;
+}
+
+void Encoder_Flac::writeTrailer() {
+    if ( block_used > 0 )
+        encodeFrame();
+
+    if ( !patch_info )
+        return;
+
+    streamInfo();
+    fseek( fp, 8, SEEK_SET );
+    fwrite( frame, 1, frame_bytes, fp );
+    fseek( fp, 0, SEEK_END );
+}
@@ -0,0 +1,52 @@
+#ifndef __Encoder_Flac__
+#define __Encoder_Flac__
+
+#include "Encoder.h"
+
+// FLAC stream, 16 bits mono; fixed predictors and Rice coded residuals
+class Encoder_Flac : public Encoder {
+public:
+    Encoder_Flac( FILE * fp, unsigned int rate );
+    ~Encoder_Flac();
+
+protected:
+    void writeHeader();
+    void encode( const short * samples, unsigned int count );
+    void writeTrailer();
+
+private:
+    enum {
+        BLOCK_SIZE          = 4096,
+        MAX_ORDER           = 4,
+        MAX_PARTITION_ORDER = 8,
+        MAX_RICE_PARAMETER  = 14,
+        MAX_FRAME_SIZE      = BLOCK_SIZE * 2 + 64
+    };
+
+    // bit writer for one frame
+    void bits( unsigned int value, int count );
+    void alignBits();
+
+    void streamInfo();
+    void encodeFrame();
+    void encodeSubframe( int n );
+    unsigned int residualBits( const int * residual, int n, int order,
+                               int partition_order, int * parameters );
+
+    bool            patch_info;         // STREAMINFO gets the totals at the end
+    short           block[ BLOCK_SIZE ];
+    unsigned int    block_used;
+    unsigned int    frame_number;
+    unsigned long long total_samples;
+    unsigned int    min_frame_size;
+    unsigned int    max_frame_size;
+
+    unsigned char   frame[ MAX_FRAME_SIZE ];
+    unsigned int    frame_bytes;
+    unsigned int    bit_buffer;
+    int             bit_count;
+
+    int             residual[ MAX_ORDER + 1 ][ BLOCK_SIZE ];
+};
+
+#endif // __Encoder_Flac__
@@ -0,0 +1,255 @@
+
+// G.711 and IMA ADPCM, in a WAV container
+#include <string.h>
+#include "Encoder_Wav.h"
+
+static const int ima_step_table[ 89 ] = {
+        7,     8,     9,    10,    11,    12,    13,    14,    16,    17,
+       19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+       50,    55,    60,    66,    73,    80,    88,    97,   107,   118,
+      130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+      337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+      876,   963,  1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+     2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+     5894,  6484,  7132,  7845,  8630,  9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int ima_index_table[ 8 ] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+static unsigned char linear_to_ulaw( int sample ) {
+    const int BIAS = 0x84;
+    const int CLIP = 32635;
+    int sign = 0;
+
+    if ( sample < 0 ) {
+        sign = 0x80;
+        sample = -sample;
+    }
+    if ( sample > CLIP )
+        sample = CLIP;
+    sample += BIAS;
+
+    int exponent = 7;
+    for ( int mask = 0x4000; (sample & mask) == 0 && exponent > 0; mask >>= 1 )
+        exponent--;
+    int mantissa = (sample >> (exponent + 3)) & 0x0f;
+    return ~(sign | (exponent << 4) | mantissa);
+}
+
+static unsigned char linear_to_alaw( int sample ) {
+    int mask;
+
+    sample >>= 3;                       // 13 bits
+    if ( sample >= 0 ) {
+        mask = 0xd5;
+    } else {
+        mask = 0x55;
+        sample = -sample - 1;
+    }
+
+    int segment = 0;
+    while ( segment < 8 && sample >= (0x20 << segment) )
+        segment++;
+    if ( segment >= 8 )
+        return 0x7f ^ mask;
+
+    int value = segment << 4;
+    value |= (sample >> (segment < 2 ? 1 : segment)) & 0x0f;
+    return value ^ mask;
+}
+
+static void put_le( unsigned char * p, unsigned int value, int bytes ) {
+    for ( int i = 0; i < bytes; i++ )
+        p[i] = value >> (8 * i);
+}
+
+Encoder_Wav::Encoder_Wav( FILE * fp, unsigned int rate, Format _format ) : Encoder( fp, rate ), format( _format ),
+    patch_sizes( false ), fact_offset( 0 ), data_offset( 0 ), samples( 0 ), data_size( 0 ),
+    block_used( 0 ), step_index( 0 ) {
+}
+
+Encoder_Wav::~Encoder_Wav() {
+    finish();
+}
+
+void Encoder_Wav::writeHeader() {
+    bool adpcm = format == IMA_ADPCM;
+    bool pcm = format == PCM;
+    unsigned int fmt_size = pcm ? 16 : adpcm ? 20 : 18;
+    unsigned int block_align = pcm ? 2 : adpcm ? ADPCM_BLOCK_SIZE : 1;
+    unsigned int byte_rate = adpcm ? rate * ADPCM_BLOCK_SIZE / ADPCM_BLOCK_SAMPLES : rate * block_align;
+    unsigned char header[ 60 ];
+    unsigned char * p = header;
+
+    // sizes are unknown until the end; a pipe keeps the "unknown" values
+    patch_sizes = seekable();
+
+    memcpy( p, "RIFF", 4 );             put_le( p + 4, 0xffffffff, 4 );
+    memcpy( p + 8, "WAVE", 4 );         p += 12;
+
+    memcpy( p, "fmt ", 4 );             put_le( p + 4, fmt_size, 4 );
+    put_le( p + 8, format, 2 );
+    put_le( p + 10, 1, 2 );             // mono
+    put_le( p + 12, rate, 4 );
+    put_le( p + 16, byte_rate, 4 );
+    put_le( p + 20, block_align, 2 );
+    put_le( p + 22, pcm ? 16 : adpcm ? 4 : 8, 2 );     // bits per sample
+    if ( !pcm )
+        put_le( p + 24, adpcm ? 2 : 0, 2 );             // extra format bytes
+    if ( adpcm )
+        put_le( p + 26, ADPCM_BLOCK_SAMPLES, 2 );
+    p += 8 + fmt_size;
+
+    // PCM needs no fact chunk
+    if ( !pcm ) {
+        memcpy( p, "fact", 4 );         put_le( p + 4, 4, 4 );
+        put_le( p + 8, 0, 4 );
+        fact_offset = p + 8 - header;   p += 12;
+    }
+    data_offset = p + 4 - header;
+
+    memcpy( p, "data", 4 );             put_le( p + 4, 0xffffffff, 4 );
+    p += 8;
+
+    put( header, p - header );
+}
+
+void Encoder_Wav::encode( const short * in, unsigned int count ) {
+    unsigned char out[ 1024 ];
+
+    samples += count;
+
+    if ( format == PCM ) {
+        while ( count > 0 ) {
+            unsigned int n = count < sizeof(out) / 2 ? count : sizeof(out) / 2;
+            for ( unsigned int i = 0; i < n; i++ )
+                put_le( out + 2 * i, (unsigned short) in[i], 2 );
+            put( out, 2 * n );
+            data_size += 2 * n;
+            in += n;
+            count -= n;
+        }
+        return;
+    }
+
+    if ( format != IMA_ADPCM ) {
+        while ( count > 0 ) {
+            unsigned int n = count < sizeof(out) ? count : sizeof(out);
+            for ( unsigned int i = 0; i < n; i++ )
+                out[i] = format == ULAW ? linear_to_ulaw( in[i] ) : linear_to_alaw( in[i] );
+            put( out, n );
+            data_size += n;
+            in += n;
+            count -= n;
+        }
+        return;
+    }
+
+    while ( count > 0 ) {
+        unsigned int n = ADPCM_BLOCK_SAMPLES - block_used;
+        if ( n > count )
+            n = count;
+        memcpy( block + block_used, in, n * sizeof(short) );
+        block_used += n;
+        in += n;
+        count -= n;
+        if ( block_used == ADPCM_BLOCK_SAMPLES )
+            encodeAdpcmBlock();
+    }
+}
+
+// a block starts with a sample and the step index, the other samples
+// follow as 4-bit codes, the first one in the low nibble
+void Encoder_Wav::encodeAdpcmBlock() {
+    unsigned char out[ ADPCM_BLOCK_SIZE ];
+    int predicted = block[0];
+
+    put_le( out, (unsigned short) block[0], 2 );
+    out[2] = step_index;
+    out[3] = 0;
+    memset( out + 4, 0, ADPCM_BLOCK_SIZE - 4 );
+
+    for ( unsigned int i = 1; i < ADPCM_BLOCK_SAMPLES; i++ ) {
+        int step = ima_step_table[ step_index ];
+        int diff = block[i] - predicted;
+        int code = 0;
+        int change = step >> 3;
+
+        if ( diff < 0 ) {
+            code = 8;
+            diff = -diff;
+        }
+        if ( diff >= step ) {
+            code |= 4;
+            diff -= step;
+            change += step;
+        }
+        step >>= 1;
+        if ( diff >= step ) {
+            code |= 2;
+            diff -= step;
+            change += step;
+        }
+        step >>= 1;
+        if ( diff >= step ) {
+            code |= 1;
+            change += step;
+        }
+
+        predicted += (code & 8) ? -change : change;
+        if ( predicted > 32767 )
+            predicted = 32767;
+        else if ( predicted < -32768 )
+            predicted = -32768;
+
+        step_index += ima_index_table[ code & 7 ];
+        if ( step_index < 0 )
+            step_index = 0;
+        else if ( step_index > 88 )
+            step_index = 88;
+
+        out[ 4 + (i - 1) / 2 ] |= (i & 1) ? code : code << 4;
+    }
+
+    put( out, ADPCM_BLOCK_SIZE );
+    data_size += ADPCM_BLOCK_SIZE;
+    block_used = 0;
+}
+
+void Encoder_Wav::writeTrailer() {
+    // the last ADPCM block is padded with its last sample, the fact chunk
+    // holds the real length
+    if ( format == IMA_ADPCM && block_used > 0 ) {
+        short last = block[ block_used - 1 ];
+        while ( block_used < ADPCM_BLOCK_SAMPLES )
+            block[ block_used++ ] = last;
+        encodeAdpcmBlock();
+    }
+
+    // chunks have an even size
+    if ( data_size & 1 ) {
+        unsigned char pad = 0;
+        put( &pad, 1 );
+    }
+
+    if ( !patch_sizes )
+        return;
+
+    unsigned char size[4];
+    put_le( size, written - 8, 4 );
+    fseek( fp, 4, SEEK_SET );
+    fwrite( size, 1, 4, fp );
+
+    if ( format != PCM ) {
+        put_le( size, samples, 4 );
+        fseek( fp, fact_offset, SEEK_SET );
+        fwrite( size, 1, 4, fp );
+    }
+
+    put_le( size, data_size, 4 );
+    fseek( fp, data_offset, SEEK_SET );
+    fwrite( size, 1, 4, fp );
+
+    fseek( fp, 0, SEEK_END );
+}
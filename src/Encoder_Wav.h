@@ -0,0 +1,45 @@
+#ifndef __Encoder_Wav__
+#define __Encoder_Wav__
+
+#include "Encoder.h"
+
+// WAV file with 16-bit PCM, G.711 (8 bits a sample) or IMA ADPCM (4 bits a sample)
+class Encoder_Wav : public Encoder {
+public:
+    enum Format {                       // WAVE format tags
+        PCM         = 0x0001,
+        ALAW        = 0x0006,
+        ULAW        = 0x0007,
+        IMA_ADPCM   = 0x0011
+    };
+
+    Encoder_Wav( FILE * fp, unsigned int rate, Format format );
+    ~Encoder_Wav();
+
+protected:
+    void writeHeader();
+    void encode( const short * samples, unsigned int count );
+    void writeTrailer();
+
+private:
+    enum {
+        ADPCM_BLOCK_SIZE        = 512,                          // bytes
+        ADPCM_BLOCK_SAMPLES     = (ADPCM_BLOCK_SIZE - 4) * 2 + 1
+    };
+
+    void encodeAdpcmBlock();
+
+    Format          format;
+    bool            patch_sizes;        // the header gets its sizes at the end
+    unsigned int    fact_offset;        // file offset of the sample count
+    unsigned int    data_offset;        // file offset of the data size
+    unsigned int    samples;
+    size_t          data_size;
+
+    // IMA ADPCM state
+    short           block[ ADPCM_BLOCK_SAMPLES ];
+    unsigned int    block_used;
+    int             step_index;
+};
+
+#endif // __Encoder_Wav__
@@ -0,0 +1,403 @@
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "Pico.h"
+#include "nanotts.h"
+
+/* string-ify a macro */
+#define STRR(X) #X
+#define STR(X) STRR(X)
+
+#ifndef PICO_ROOT
+#define PICO_ROOT /usr
+#endif
+
+namespace nanotts {
+
+// searching these paths
+static const char * lingware_paths[ 2 ] = { "./lang", STR(PICO_ROOT) "/share/pico/lang" };
+
+BufferSink::BufferSink( short * _buffer, size_t _capacity ) : buffer( _buffer ), capacity( _capacity ),
+    used( 0 ), lost( 0 ) {
+}
+
+void BufferSink::write( const short * samples, unsigned int count ) {
+    size_t n = capacity - used;
+    if ( n > count )
+        n = count;
+    memcpy( buffer + used, samples, n * sizeof(short) );
+    used += n;
+    lost += count - n;
+}
+
+// counts the samples on their way to the caller's sink
+class counting_sink_t : public Sink {
+public:
+    counting_sink_t( Sink & _sink ) : sink( _sink ), samples( 0 ) {}
+    void write( const short * data, unsigned int count ) { samples += count; sink.write( data, count ); }
+    void sentence() { sink.sentence(); }
+    void mark( const Mark & m ) { sink.mark( m ); }
+
+    Sink &              sink;
+    unsigned long long  samples;
+};
+//////////////////////////////////////////////////////////////////
+
+
+Engine::Engine( const char * voice, const Options & options ) : pico( new Pico() ), ok( false ), from_image( false ) {
+    const char * dir = options.lingware_dir ? options.lingware_dir : defaultLingwareDir();
+
+    if ( !dir ) {
+        fprintf( stderr, "Lingware not found, looking in: %s, %s\n", lingware_paths[0], lingware_paths[1] );
+        return;
+    }
+    if ( pico->setVoice( voice ) < 0 ) {
+        fprintf( stderr, "unknown voice: %s\n", voice );
+        return;
+    }
+
+    pico->setLangFilePath( dir );
+    pico->lazyInit( options.lazy_init );
+    pico->expandPdfs( options.expand_pdfs );
+    if ( options.mem_size )
+        pico->memSize( options.mem_size );
+
+    if ( options.image && pico->restoreSystem( options.image ) == 0 )
+        from_image = true;
+    else if ( pico->initializeSystem() < 0 )
+        return;
+    ok = true;
+}
+
+Engine::~Engine() {
+    delete pico;
+}
+
+const char * Engine::voice() const {
+    return pico->getVoice();
+}
+
+int Engine::synthesize( const char * text, size_t length, const Params & params, Sink & sink ) {
+    pico->sendTextForProcessing( (const unsigned char *) text, length );
+    return speak( params, sink );
+}
+
+int Engine::synthesize( const char * text, const Params & params, Sink & sink ) {
+    return synthesize( text, strlen( text ), params, sink );
+}
+
+// the file is read a window at a time while it is spoken
+int Engine::synthesizeFile( const char * filename, const Params & params, Sink & sink ) {
+    mmfile_t file( filename );
+    if ( !file.fp )
+        return -1;
+
+    pico->sendFileForProcessing( &file );
+    return speak( params, sink );
+}
+
+int Engine::speak( const Params & params, Sink & sink ) {
+    if ( !ok )
+        return -1;
+    if ( params.rate < 4000 || params.rate > 192000 ) {
+        fprintf( stderr, "sample rate not supported: %u\n", params.rate );
+        return -1;
+    }
+
+    struct timespec start, end;
+    clock_gettime( CLOCK_MONOTONIC, &start );
+
+    Boilerplate modifiers( params.speed, params.pitch, params.volume );
+    counting_sink_t counted( sink );
+    pico->addModifiers( modifiers.isChanged() ? &modifiers : 0 );
+    pico->setOutputRate( params.rate, (Resampler::Quality) params.quality );
+    pico->setMarks( params.marks );
+    pico->setSink( &counted );
+
+    int res = pico->process();
+
+    clock_gettime( CLOCK_MONOTONIC, &end );
+    totals.texts++;
+    totals.audio_ms += counted.samples * 1000.0 / params.rate;
+    totals.busy_ms += (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0;
+
+    pico->setSink( 0 );
+    pico->addModifiers( 0 );
+    pico->sendTextForProcessing( 0, 0 );
+    return res == Pico::PROCESS_CANCELLED ? CANCELLED : res;
+}
+
+void Engine::cancel() {
+    pico->cancel();
+}
+
+int Engine::saveImage( const char * filename ) {
+    return ok ? pico->saveImage( filename ) : -1;
+}
+
+unsigned int Engine::recommendedMemSize() {
+    return pico->recommendedMemSize();
+}
+
+void Engine::printStats() {
+    pico->printStats();
+}
+//////////////////////////////////////////////////////////////////
+
+
+EnginePool::EnginePool( const Engine::Options & _options, unsigned int _per_voice ) : options( _options ),
+    lingware_dir( 0 ), per_voice( _per_voice ? _per_voice : 1 ), cpu_sets( 0 ), cpu_set_count( 0 ),
+    slots( 0 ), slot_count( 0 ), slot_capacity( 0 ) {
+    // the pool outlives the caller's strings
+    if ( options.lingware_dir ) {
+        lingware_dir = new char[ strlen( options.lingware_dir ) + 1 ];
+        strcpy( lingware_dir, options.lingware_dir );
+    }
+    options.lingware_dir = lingware_dir;
+    options.image = 0;
+
+    pthread_mutex_init( &lock, 0 );
+    pthread_cond_init( &released, 0 );
+}
+
+EnginePool::~EnginePool() {
+    for ( unsigned int i = 0; i < slot_count; i++ )
+        delete slots[i].engine;
+    delete[] slots;
+    delete[] lingware_dir;
+    delete[] cpu_sets;
+    pthread_cond_destroy( &released );
+    pthread_mutex_destroy( &lock );
+}
+
+void EnginePool::setCpuSets( const cpu_set_t * sets, unsigned int count ) {
+    pthread_mutex_lock( &lock );
+    delete[] cpu_sets;
+    cpu_sets = count ? new cpu_set_t[ count ] : 0;
+    cpu_set_count = count;
+    memcpy( cpu_sets, sets, count * sizeof(cpu_set_t) );
+    pthread_mutex_unlock( &lock );
+}
+
+// run the calling thread on the CPUs of the slot's engine
+void EnginePool::pin( slot_t & slot ) {
+    if ( slot.cpus < 0 )
+        return;
+    pthread_getaffinity_np( pthread_self(), sizeof(cpu_set_t), &slot.saved );
+    pthread_setaffinity_np( pthread_self(), sizeof(cpu_set_t), &cpu_sets[ slot.cpus ] );
+}
+
+void EnginePool::unpin( slot_t & slot ) {
+    if ( slot.cpus >= 0 )
+        pthread_setaffinity_np( pthread_self(), sizeof(cpu_set_t), &slot.saved );
+}
+
+Engine * EnginePool::acquire( const char * voice ) {
+    unsigned int i, count;
+
+    if ( strlen( voice ) >= sizeof(slots[0].voice) )
+        return 0;
+
+    pthread_mutex_lock( &lock );
+    while ( 1 ) {
+        count = 0;
+        for ( i = 0; i < slot_count; i++ ) {
+            if ( strcmp( slots[i].voice, voice ) != 0 )
+                continue;
+            if ( slots[i].engine && !slots[i].busy ) {
+                slots[i].busy = true;
+                pin( slots[i] );
+                pthread_mutex_unlock( &lock );
+                return slots[i].engine;
+            }
+            count++;
+        }
+        if ( count < per_voice )
+            break;
+        pthread_cond_wait( &released, &lock );
+    }
+
+    // take a slot for a new engine, an unused one or a new one at the end
+    for ( i = 0; i < slot_count && slots[i].voice[0]; i++ )
+        ;
+    if ( i == slot_capacity ) {
+        slot_capacity = slot_capacity ? slot_capacity * 2 : 8;
+        slot_t * grown = new slot_t[ slot_capacity ];
+        memcpy( grown, slots, slot_count * sizeof(slot_t) );
+        delete[] slots;
+        slots = grown;
+    }
+    if ( i == slot_count )
+        slot_count++;
+    strcpy( slots[i].voice, voice );
+    slots[i].engine = 0;
+    slots[i].busy = true;
+    slots[i].cpus = cpu_set_count ? i % cpu_set_count : -1;
+    slots[i].stats = Engine::Stats();
+    pin( slots[i] );
+    pthread_mutex_unlock( &lock );
+
+    // loading the voice takes a while, the other voices carry on meanwhile;
+    // on the CPUs of the engine, its memory is on their node
+    Engine * engine = new Engine( voice, options );
+
+    pthread_mutex_lock( &lock );
+    if ( engine->ready() ) {
+        slots[i].engine = engine;
+    } else {
+        delete engine;
+        engine = 0;
+        unpin( slots[i] );
+        slots[i].voice[0] = 0;
+        slots[i].busy = false;
+        pthread_cond_broadcast( &released );
+    }
+    pthread_mutex_unlock( &lock );
+    return engine;
+}
+
+void EnginePool::release( Engine * engine ) {
+    pthread_mutex_lock( &lock );
+    for ( unsigned int i = 0; i < slot_count; i++ ) {
+        if ( slots[i].engine == engine ) {
+            unpin( slots[i] );
+            slots[i].stats = engine->stats();
+            slots[i].busy = false;
+            pthread_cond_broadcast( &released );
+            break;
+        }
+    }
+    pthread_mutex_unlock( &lock );
+}
+
+// throughput of each engine, as of its last release
+void EnginePool::printStats() {
+    fprintf( stderr, "engines:\n" );
+    pthread_mutex_lock( &lock );
+    for ( unsigned int i = 0; i < slot_count; i++ ) {
+        const Engine::Stats & s = slots[i].stats;
+        if ( !slots[i].engine )
+            continue;
+        fprintf( stderr, "  %-8s cpus %-3d %7lu texts %10.3f s audio %10.3f s busy", slots[i].voice,
+                 slots[i].cpus, s.texts, s.audio_ms / 1000, s.busy_ms / 1000 );
+        if ( s.busy_ms > 0 )
+            fprintf( stderr, " %7.1fx real time", s.audio_ms / s.busy_ms );
+        fprintf( stderr, "\n" );
+    }
+    pthread_mutex_unlock( &lock );
+}
+//////////////////////////////////////////////////////////////////
+
+
+// the names, copied out of PicoVoices_t once
+struct voice_names_t {
+    char    name[ 8 ][ 16 ];
+    int     count;
+
+    voice_names_t() : count( 0 ) {
+        PicoVoices_t voices;
+        while ( count < 8 && voices.setVoice( count ) == 0 ) {
+            snprintf( name[count], sizeof(name[count]), "%s", voices.getVoice() );
+            count++;
+        }
+    }
+};
+
+const char * voiceName( int index ) {
+    static voice_names_t voices;
+    return index >= 0 && index < voices.count ? voices.name[ index ] : 0;
+}
+
+const char * findVoice( const char * voice ) {
+    PicoVoices_t voices;
+    int index = voices.setVoice( voice );
+    return index < 0 ? 0 : voiceName( index );
+}
+
+bool hasLingware( const char * dir, const char * voice ) {
+    PicoVoices_t    voices;
+    char            path[ 1024 ];
+    struct stat     ss;
+
+    if ( voices.setVoice( voice ) < 0 )
+        return false;
+    snprintf( path, sizeof(path), "%s/%s", dir, voices.getTaName() );
+    if ( -1 == stat( path, &ss ) || !S_ISREG( ss.st_mode ) )
+        return false;
+    snprintf( path, sizeof(path), "%s/%s", dir, voices.getSgName() );
+    if ( -1 == stat( path, &ss ) || !S_ISREG( ss.st_mode ) )
+        return false;
+    return true;
+}
+
+const char * defaultLingwareDir() {
+    for ( unsigned int i = 0; i < sizeof(lingware_paths)/sizeof(lingware_paths[0]); ++i ) {
+        for ( int v = 0; voiceName( v ); v++ ) {
+            if ( hasLingware( lingware_paths[i], voiceName( v ) ) )
+                return lingware_paths[i];
+        }
+    }
+    return 0;
+}
+
+bool parseResampleQuality( const char * name, ResampleQuality * quality ) {
+    Resampler::Quality q;
+    if ( !Resampler::parseQuality( name, &q ) )
+        return false;
+    *quality = (ResampleQuality) q;
+    return true;
+}
+
+// a cpulist of sysfs, e.g. "0-3,8-11"
+static void parse_cpu_list( const char * list, cpu_set_t * set ) {
+    CPU_ZERO( set );
+    while ( *list ) {
+        char * end;
+        long first = strtol( list, &end, 10 ), last = first;
+        if ( end == list )
+            break;
+        if ( *end == '-' )
+            last = strtol( end + 1, &end, 10 );
+        for ( long cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++ )
+            CPU_SET( cpu, set );
+        list = *end == ',' ? end + 1 : end;
+    }
+}
+
+unsigned int nodeCpuSets( cpu_set_t * sets, unsigned int max ) {
+    cpu_set_t   allowed;
+    char        path[ 64 ], list[ 4096 ];
+    unsigned int count = 0;
+
+    if ( max == 0 || sched_getaffinity( 0, sizeof(allowed), &allowed ) < 0 )
+        return 0;
+
+    for ( int node = 0; node < 1024 && count < max; node++ ) {
+        snprintf( path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node );
+        FILE * fp = fopen( path, "r" );
+        if ( !fp )
+            continue;
+        bool read = fgets( list, sizeof(list), fp ) != 0;
+        fclose( fp );
+        if ( !read )
+            continue;
+
+        // the CPUs of the node this process may use; nodes of only memory have none
+        parse_cpu_list( list, &sets[count] );
+        CPU_AND( &sets[count], &sets[count], &allowed );
+        if ( CPU_COUNT( &sets[count] ) > 0 )
+            count++;
+    }
+
+    if ( count == 0 ) {
+        sets[0] = allowed;
+        count = 1;
+    }
+    return count;
+}
+
+}
@@ -0,0 +1,984 @@
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "svoxpico/picoapi.h"
+#include "svoxpico/picoapid.h"
+#include "svoxpico/picoextapi.h"
+#include "svoxpico/picoos.h"
+
+#include "Pico.h"
+#include "Trace.h"
+
+// milliseconds elapsed since 'since' (monotonic clock)
+static double elapsed_ms( const struct timespec & since ) {
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return (now.tv_sec - since.tv_sec) * 1000.0 + (now.tv_nsec - since.tv_nsec) / 1000000.0;
+}
+
+// a part of the text for the engine, in memory or in a mapped file
+struct text_source_t {
+    const pico_Char *   text;
+    size_t              length;
+    mmfile_t *          file;
+};
+
+// the text of a source from pos on, and how many bytes of it are contiguous
+static const pico_Char * source_text( const text_source_t & source, size_t pos, size_t * available )
+{
+    if ( source.file )
+        return (const pico_Char *) source.file->window( pos, available );
+
+    *available = source.length - pos;
+    return source.text + pos;
+}
+
+// length of the next piece of text for pico_putTextUtf8(), which takes at
+// most 32767 bytes: up to the end of the last sentence or clause that fits,
+// else the last space, and never inside a UTF-8 sequence
+static pico_Int16 text_piece_length( const pico_Char * text, size_t length )
+{
+    const size_t MAX_PIECE = 32767;
+    size_t end;
+
+    if ( length <= MAX_PIECE )
+        return length;
+
+    for ( end = MAX_PIECE; end > 1; end-- ) {
+        if ( text[end-1] == '\n' )
+            return end;
+        if ( isspace( text[end-1] ) && text[end-2] && strchr( ".!?;:", text[end-2] ) )
+            return end;
+    }
+    for ( end = MAX_PIECE; end > 0; end-- ) {
+        if ( isspace( text[end-1] ) )
+            return end;
+    }
+    for ( end = MAX_PIECE; end > 0; end-- ) {
+        if ( (text[end] & 0xc0) != 0x80 )
+            return end;
+    }
+    return MAX_PIECE;
+}
+
+// the marks put before the words of the text: offset and length of the word
+static const char text_mark_format[] = "<mark name=\"nanotts:%zu:%zu\"/>";
+static const char text_mark_scan[] = "nanotts:%zu:%zu";
+
+// the Pico whose process() runs in this thread, with Params::marks
+static __thread Pico * timing_pico;
+
+static void timing_hook( pico_Int16 kind, pico_Int16 phone, const pico_Char * name, pico_Uint32 sample )
+{
+    if ( timing_pico )
+        timing_pico->timing( kind, phone, (const char *) name, sample );
+}
+
+static pthread_once_t timing_once = PTHREAD_ONCE_INIT;
+
+static void set_timing_hook()
+{
+    picoext_setTimingHook( timing_hook );
+}
+
+// process() of a Pico in this thread, while it is in scope
+struct TimingScope {
+    TimingScope( Pico * pico ) { timing_pico = pico; }
+    ~TimingScope() { timing_pico = 0; }
+};
+
+static nanotts::Mark new_mark( nanotts::Mark::Type type, unsigned long start )
+{
+    nanotts::Mark mark;
+    memset( &mark, 0, sizeof(mark) );
+    mark.type = type;
+    mark.start = mark.end = start;
+    return mark;
+}
+
+Boilerplate::Boilerplate( float speed, float pitch, float volume ) {
+    static const struct {
+        const char * ofmt;
+        const char * cfmt;
+    } pads[] = {
+        { "<speed level=\"%d\">",     "</speed>" },
+        { "<pitch level=\"%d\">",     "</pitch>" },
+        { "<volume level=\"%d\">",    "</volume>" }
+    };
+    const float values[] = { speed, pitch, volume };
+    char buf[50];
+
+    memset( plate_begin, 0, sizeof(plate_begin) );
+    memset( plate_end, 0, sizeof(plate_end) );
+    for ( unsigned int i = 0; i < sizeof(pads)/sizeof(pads[0]); i++ ) {
+        if ( values[i] != -1 ) {
+            // begin plate
+            sprintf( buf, pads[i].ofmt, (int) ceilf( values[i] * 100.0f ) );
+            strcat( plate_begin, buf );
+            // end plate := reverse order to match tag order
+            strcpy( buf, plate_end );
+            sprintf( plate_end, "%s%s", pads[i].cfmt, buf );
+            // </volume></pitch></speed>
+        }
+    }
+}
+//////////////////////////////////////////////////////////////////
+
+
+Pico::Pico() {
+    picoSystem              = 0;
+    picoTaResource          = 0;
+    picoSgResource          = 0;
+    picoEngine              = 0;
+    picoLingwarePath        = 0;
+
+    strcpy( picoVoiceName, "PicoVoice" );
+
+    local_text              = 0;
+    total_text_length       = 0;
+    text_file               = 0;
+    sink                    = 0;
+    modifiers               = 0;
+
+    picoMemArea             = 0;
+    picoMemSize             = PICO_MEM_SIZE;
+    picoMemSizeSet          = false;
+    picoImage               = 0;
+    picoTaFileName          = 0;
+    picoSgFileName          = 0;
+    picoTaResourceName      = 0;
+    picoSgResourceName      = 0;
+
+    pico_lazyInit           = false;
+    pico_expandPdfs         = false;
+
+    stat_mark               = 0;
+    stat_initialize         = 0;
+    stat_load_ta            = 0;
+    stat_load_sg            = 0;
+    stat_voice              = 0;
+    stat_engine             = 0;
+    stat_image              = -1;
+    stat_first_sample       = -1;
+    stat_synthesis          = 0;
+    stat_cancel             = -1;
+
+    cancel_requested        = 0;
+
+    output_rate             = SAMPLE_FREQ_16KHZ;
+    output_quality          = Resampler::MEDIUM;
+    resampler               = 0;
+    resampled               = 0;
+
+    marks                   = false;
+    engine_samples          = 0;
+    text_start              = 0;
+    speech_end              = 0;
+    phone_open              = false;
+    word_open               = false;
+    text_open               = false;
+    text_spoken             = false;
+    mark_tag_length         = 0;
+    mark_tag_fed            = mark_tag;
+    clock_gettime( CLOCK_MONOTONIC, &stat_start );
+}
+
+Pico::~Pico() {
+    if ( picoLingwarePath ) {
+        delete[] picoLingwarePath;
+    }
+    delete resampler;
+    delete[] resampled;
+
+    cleanup();
+
+    if ( picoImage )
+        delete picoImage;
+    else if ( picoMemArea )
+        munmap( picoMemArea, picoMemSize );
+    if ( picoTaFileName )
+        free( picoTaFileName );
+    if ( picoSgFileName )
+        free( picoSgFileName );
+    if ( picoTaResourceName )
+        free( picoTaResourceName );
+    if ( picoSgResourceName )
+        free( picoSgResourceName );
+}
+
+void Pico::setLangFilePath( const char * path ) {
+    delete[] picoLingwarePath;
+    unsigned int len = strlen( path ) + 1;
+    picoLingwarePath = new char[ len ];
+    strcpy( picoLingwarePath, path );
+}
+
+// full path of a Lingware file, malloc'd
+pico_Char * Pico::lingwareFile( const char * name )
+{
+    pico_Char * fileName = (pico_Char *) malloc( PICO_MAX_DATAPATH_NAME_SIZE + PICO_MAX_FILE_NAME_SIZE );
+
+    // path
+    if ( !picoLingwarePath )
+        setLangFilePath( "." );
+    strcpy((char *) fileName, picoLingwarePath);
+
+    // check for connecting slash
+    unsigned int len = strlen( (const char*)fileName );
+    if ( fileName[len-1] != '/' )
+        strcat((char*) fileName, "/");
+
+    // langfile name
+    strcat( (char *) fileName, name );
+    return fileName;
+}
+
+int Pico::initializeSystem()
+{
+    pico_Retstring  outMessage;
+    int             ret;
+    pico_Uint32     engineSize;
+
+    clock_gettime( CLOCK_MONOTONIC, &stat_start );
+    stat_mark = 0;
+
+    // zeroed, so that images (see saveImage) of equal systems are equal. The
+    // pages are mapped on first use, on the NUMA node of the thread that
+    // loads the Lingware into them
+    picoMemArea = mmap( 0, picoMemSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if ( MAP_FAILED == picoMemArea ) {
+        picoMemArea = 0;
+        fprintf( stderr, "Cannot allocate %u bytes for pico\n", picoMemSize );
+        return -1;
+    }
+
+    if ( (ret = pico_initialize( picoMemArea, picoMemSize, &picoSystem )) ) {
+        pico_getSystemStatusMessage(picoSystem, ret, outMessage);
+        fprintf( stderr, "Cannot initialize pico (%i): %s\n", ret, outMessage );
+
+        pico_terminate(&picoSystem);
+        picoSystem = 0;
+        return -1;
+    }
+    stat_initialize = statLap();
+
+    if ( pico_expandPdfs )
+        picoext_setExpandPdfs( picoSystem, 1 );
+
+    /* Load the text analysis Lingware resource file.   */
+    picoTaFileName = lingwareFile( voices.getTaName() );
+
+    // attempt to load it
+    if ( (ret = pico_loadResource(picoSystem, picoTaFileName, &picoTaResource)) ) {
+        pico_getSystemStatusMessage(picoSystem, ret, outMessage);
+        fprintf( stderr, "Cannot load text analysis resource file (%i): %s\n", ret, outMessage );
+        goto unloadTaResource;
+    }
+    stat_load_ta = statLap();
+
+    /* Load the signal generation Lingware resource file.   */
+    picoSgFileName = lingwareFile( voices.getSgName() );
+
+    if ( (ret = pico_loadResource(picoSystem, picoSgFileName, &picoSgResource)) ) {
+        pico_getSystemStatusMessage(picoSystem, ret, outMessage);
+        fprintf( stderr, "Cannot load signal generation Lingware resource file (%i): %s\n", ret, outMessage );
+        goto unloadSgResource;
+    }
+    stat_load_sg = statLap();
+
+    /* Get the text analysis resource name.     */
+    picoTaResourceName = (pico_Char *) malloc( PICO_MAX_RESOURCE_NAME_SIZE );
+    if((ret = pico_getResourceName( picoSystem, picoTaResource, (char *) picoTaResourceName ))) {
+        pico_getSystemStatusMessage(picoSystem, ret, outMessage);
+        fprintf( stderr, "Cannot get the text analysis resource name (%i): %s\n", ret, outMessage );
+        goto unloadSgResource;
+    }
+
+    /* Get the signal generation resource name. */
+    picoSgResourceName = (pico_Char *) malloc( PICO_MAX_RESOURCE_NAME_SIZE );
+    if((ret = pico_getResourceName( picoSystem, picoSgResource, (char *) picoSgResourceName ))) {
+        pico_getSystemStatusMessage(picoSystem, ret, outMessage);
+        fprintf( stderr, "Cannot get the signal generation resource name (%i): %s\n", ret, outMessage );
+        goto unloadSgResource;
+    }
+
+    /* Create a voice definition.   */
+    if((ret = pico_createVoiceDefinition( picoSystem, (const pico_Char *) picoVoiceName ))) {
+        pico_getSystemStatusMessage(picoSystem, ret, outMessage);
+        fprintf( stderr, "Cannot create voice definition (%i): %s\n", ret, outMessage );
+        goto unloadSgResource;
+    }
+
+    /* Add the text analysis resource to the voice. */
+    if((ret = pico_addResourceToVoiceDefinition( picoSystem, (const pico_Char *) picoVoiceName, picoTaResourceName ))) {
+        pico_getSystemStatusMessage(picoSystem, ret, outMessage);
+        fprintf( stderr, "Cannot add the text analysis resource to the voice (%i): %s\n", ret, outMessage );
+        goto unloadSgResource;
+    }
+
+    /* Add the signal generation resource to the voice. */
+    if((ret = pico_addResourceToVoiceDefinition( picoSystem, (const pico_Char *) picoVoiceName, picoSgResourceName ))) {
+        pico_getSystemStatusMessage(picoSystem, ret, outMessage);
+        fprintf( stderr, "Cannot add the signal generation resource to the voice (%i): %s\n", ret, outMessage );
+        goto unloadSgResource;
+    }
+
+    stat_voice = statLap();
+
+    /* With an explicit memory size, the engine gets what the Lingware leaves;
+       not its peak, a pdf that could not be expanded was freed again */
+    engineSize = 0;
+    if ( picoMemSizeSet ) {
+        pico_Int32 used, incr, max;
+        picoext_getSystemMemUsage( picoSystem, 0, &used, &incr, &max );
+        if ( (long) picoMemSize - used - PICO_MEM_RESERVE < PICO_MIN_ENGINE_SIZE ) {
+            fprintf( stderr, "Memory size too small: the Lingware needs %d bytes and the engine %d, "
+                     "use a --mem-size of at least %ld\n", used, PICO_MIN_ENGINE_SIZE,
+                     (long) used + PICO_MEM_RESERVE + PICO_MIN_ENGINE_SIZE );
+            goto unloadSgResource;
+        }
+        engineSize = picoMemSize - used - PICO_MEM_RESERVE;
+    }
+
+    /* Create a new Pico engine. */
+    if((ret = picoext_newEngine( picoSystem, (const pico_Char *) picoVoiceName, pico_lazyInit, engineSize, &picoEngine ))) {
+        pico_getSystemStatusMessage(picoSystem, ret, outMessage);
+        fprintf( stderr, "Cannot create a new pico engine (%i): %s\n", ret, outMessage );
+        goto disposeEngine;
+    }
+    stat_engine = statLap();
+
+    /* success */
+    return 0;
+
+
+    //
+    // partial shutdowns below this line
+    //  for pico cleanup in case of startup abort
+    //
+disposeEngine:
+    if (picoEngine) {
+        pico_disposeEngine( picoSystem, &picoEngine );
+        pico_releaseVoiceDefinition( picoSystem, (pico_Char *) picoVoiceName );
+        picoEngine = 0;
+    }
+unloadSgResource:
+    if (picoSgResource) {
+        pico_unloadResource( picoSystem, &picoSgResource );
+        picoSgResource = 0;
+    }
+unloadTaResource:
+    if (picoTaResource) {
+        pico_unloadResource( picoSystem, &picoTaResource );
+        picoTaResource = 0;
+    }
+
+    if (picoSystem) {
+        pico_terminate(&picoSystem);
+        picoSystem = 0;
+    }
+
+    return -1;
+}
+
+// identifies the Lingware (and memory size and pdf expansion) an image is made from
+void Pico::imageKey( char * key, size_t len )
+{
+    pico_Char *     ta = lingwareFile( voices.getTaName() );
+    pico_Char *     sg = lingwareFile( voices.getSgName() );
+    struct stat     ta_st, sg_st;
+
+    memset( &ta_st, 0, sizeof(ta_st) );
+    memset( &sg_st, 0, sizeof(sg_st) );
+    stat( (const char *) ta, &ta_st );
+    stat( (const char *) sg, &sg_st );
+
+    snprintf( key, len, "%s|%s %lld %lld|%s %lld %lld|mem %u|expand %d", voices.getVoice(),
+              ta, (long long) ta_st.st_size, (long long) ta_st.st_mtime,
+              sg, (long long) sg_st.st_size, (long long) sg_st.st_mtime, picoMemSize, pico_expandPdfs );
+
+    free( ta );
+    free( sg );
+}
+
+// Write the freshly initialized system to an image file. A second system
+// is initialized the same way at another address, for PicoImage to tell
+// pointers from data. Must be called before any text is processed.
+int Pico::saveImage( const char * filename )
+{
+    char            key[ 512 ];
+
+    if ( !picoEngine )
+        return -1;
+
+    Pico twin;
+    twin.voices.setVoice( voices.getVoice() );
+    twin.setLangFilePath( picoLingwarePath );
+    twin.lazyInit( pico_lazyInit );
+    twin.expandPdfs( pico_expandPdfs );
+    twin.picoMemSize = picoMemSize;
+    twin.picoMemSizeSet = picoMemSizeSet;
+    if ( twin.initializeSystem() < 0 )
+        return -1;
+
+    void * handles[]      = { picoSystem, picoTaResource, picoSgResource, picoEngine };
+    void * twin_handles[] = { twin.picoSystem, twin.picoTaResource, twin.picoSgResource, twin.picoEngine };
+
+    imageKey( key, sizeof(key) );
+    return PicoImage::save( filename, key, picoMemArea, twin.picoMemArea, picoMemSize,
+                            handles, twin_handles, 4 );
+}
+
+// Map a system written by saveImage() instead of initializing one.
+int Pico::restoreSystem( const char * filename )
+{
+    char            key[ 512 ];
+
+    clock_gettime( CLOCK_MONOTONIC, &stat_start );
+    stat_mark = 0;
+
+    imageKey( key, sizeof(key) );
+    PicoImage * image = new PicoImage();
+    if ( image->load( filename, key, picoMemSize, 4 ) < 0 ) {
+        delete image;
+        return -1;
+    }
+
+    picoImage       = image;
+    picoMemArea     = image->area;
+    picoSystem      = (pico_System) image->handles[0];
+    picoTaResource  = (pico_Resource) image->handles[1];
+    picoSgResource  = (pico_Resource) image->handles[2];
+    picoEngine      = (pico_Engine) image->handles[3];
+
+    // images are made with lazily constructed processing units
+    pico_lazyInit   = true;
+    stat_image      = statLap();
+    return 0;
+}
+
+void Pico::cleanup()
+{
+    if (picoEngine) {
+        pico_disposeEngine( picoSystem, &picoEngine );
+        pico_releaseVoiceDefinition( picoSystem, (pico_Char *) picoVoiceName );
+        picoEngine = 0;
+    }
+
+    if (picoSgResource) {
+        pico_unloadResource( picoSystem, &picoSgResource );
+        picoSgResource = 0;
+    }
+
+    if (picoTaResource) {
+        pico_unloadResource( picoSystem, &picoTaResource );
+        picoTaResource = 0;
+    }
+
+    if (picoSystem) {
+        pico_terminate(&picoSystem);
+        picoSystem = 0;
+    }
+}
+
+void Pico::sendTextForProcessing( const unsigned char * words, size_t word_len )
+{
+    local_text          = (const pico_Char *) words;
+    total_text_length   = word_len;
+    text_file           = 0;
+}
+
+// the text is read from the file a window at a time while it is spoken
+void Pico::sendFileForProcessing( mmfile_t * file )
+{
+    local_text          = 0;
+    total_text_length   = 0;
+    text_file           = file;
+}
+
+int Pico::process()
+{
+    const int       MAX_OUTBUF_SIZE     = 128;
+    pico_Int16      bytes_sent, bytes_recv, out_data_type;
+    short           outbuf[MAX_OUTBUF_SIZE/2];
+    pico_Retstring  outMessage;
+    char            pcm_buffer[ PCM_BUFFER_SIZE ];
+    int             ret, getstatus;
+
+    struct timespec process_start;
+    clock_gettime( CLOCK_MONOTONIC, &process_start );
+    TraceScope trace( "synthesize" );
+
+    // the text goes to the engine in this order; pads are optional, but can
+    // be provided to set pico-modifiers. The '\0' makes the engine flush.
+    static const pico_Char flush[] = "";
+    text_source_t source[4];
+    int sources = 0;
+    int text_source;
+
+    memset( source, 0, sizeof(source) );
+
+    if ( modifiers ) {
+        unsigned int len;
+        source[sources].text = (pico_Char *) modifiers->getOpener( &len );
+        source[sources++].length = len;
+    }
+    text_source = sources;
+    source[sources].text = local_text;
+    source[sources].file = text_file;
+    source[sources++].length = text_file ? text_file->size : total_text_length;
+    source[sources].text = flush;
+    source[sources++].length = 1;
+    if ( modifiers ) {
+        unsigned int len;
+        source[sources].text = (pico_Char *) modifiers->getCloser( &len );
+        source[sources++].length = len;
+    }
+
+    unsigned int bufused = 0;
+    memset( pcm_buffer, 0, PCM_BUFFER_SIZE );
+
+    int             current             = 0;    // source being fed
+    size_t          pos                 = 0;    // position in it
+    pico_Int16      piece               = 0;    // bytes of the piece not accepted yet
+    const pico_Char * text;
+    size_t          available;
+
+    bool            cancelled           = false;
+    bool            sentence_fed        = false;    // the engine has the end of a sentence
+    pico_Char       last_fed            = ' ';
+
+    // the timing of this text, see timing()
+    if ( marks )
+        pthread_once( &timing_once, set_timing_hook );
+    TimingScope timing_scope( marks ? this : 0 );
+    text_start = speech_end = engine_samples;
+    phone_open = word_open = text_open = text_spoken = false;
+    mark_tag_length = 0;
+    scan_space = true;
+    scan_tag = false;
+    scan_abbreviation = false;
+    scan_token = 0;
+    scan_capital = false;
+    scan_dotted = false;
+
+    // a cancel only stops the text it came during, not this one
+    cancel_requested = 0;
+
+    Trace::begin( "sentence" );
+
+    /* synthesis loop: keep the engine's text buffer topped up, one step at a time */
+    while(1)
+    {
+        if ( cancel_requested ) {
+            // barge-in: drop the text and the samples not passed on yet, the
+            // resources stay loaded and the engine takes the next text at once
+            pico_resetEngine( picoEngine, PICO_RESET_SOFT );
+            bufused = 0;
+            engine_samples = 0;
+            if ( resampler )
+                resampler->reset();
+            cancel_requested = 0;
+            cancelled = true;
+            stat_cancel = elapsed_ms( cancel_time );
+            break;
+        }
+
+        // a point to pause at, e.g. for a scheduler to run other text first
+        if ( sentence_fed ) {
+            sentence_fed = false;
+            if ( sink )
+                sink->sentence();
+        }
+
+        while ( piece == 0 && current < sources ) {
+            if ( pos == source[current].length ) {
+                current++;
+                pos = 0;
+            } else if ( (text = source_text( source[current], pos, &available )) ) {
+                piece = text_piece_length( text, available );
+                if ( marks && current == text_source )
+                    piece = markWord( text, piece, pos );
+            } else {
+                fprintf( stderr, "Cannot read Text at %zu\n", pos );
+                Trace::end( "sentence" );
+                return -2;
+            }
+        }
+
+        /* Feed the text into the engine, as much as fits; a mark before a word first. */
+        if ( mark_tag_length > 0 ) {
+            ret = pico_putTextUtf8( picoEngine, mark_tag_fed, mark_tag_length, &bytes_sent );
+            if ( ret ) {
+                pico_getSystemStatusMessage(picoSystem, ret, outMessage);
+                fprintf( stderr, "Cannot put Text (%i): %s\n", ret, outMessage );
+                Trace::end( "sentence" );
+                return -2;
+            }
+            mark_tag_fed += bytes_sent;
+            mark_tag_length -= bytes_sent;
+        } else if ( piece > 0 ) {
+            text = source_text( source[current], pos, &available );
+            Trace::begin( "putTextUtf8" );
+            ret = pico_putTextUtf8(picoEngine, text, piece, &bytes_sent);
+            Trace::end( "putTextUtf8" );
+            if ( ret ) {
+                pico_getSystemStatusMessage(picoSystem, ret, outMessage);
+                fprintf( stderr, "Cannot put Text (%i): %s\n", ret, outMessage );
+                Trace::end( "sentence" );
+                return -2;
+            }
+            for ( pico_Int16 i = 0; i < bytes_sent; i++ ) {
+                if ( text[i] == '\n' || (isspace( text[i] ) && strchr( ".!?", last_fed )) ) {
+                    sentence_fed = true;
+                    Trace::end( "sentence" );
+                    Trace::begin( "sentence" );
+                }
+                last_fed = text[i] ? text[i] : ' ';
+            }
+            if ( marks && current == text_source )
+                scanFed( text, bytes_sent );
+            pos += bytes_sent;
+            piece -= bytes_sent;
+            if ( source[current].file )
+                source[current].file->release( pos );
+        }
+
+        /* Retrieve the samples */
+        Trace::begin( "getData" );
+        getstatus = pico_getData( picoEngine, (void *) outbuf, MAX_OUTBUF_SIZE, &bytes_recv, &out_data_type );
+        Trace::end( "getData" );
+        if ( (getstatus !=PICO_STEP_BUSY) && (getstatus !=PICO_STEP_IDLE) ) {
+            pico_getSystemStatusMessage(picoSystem, getstatus, outMessage);
+            fprintf( stderr, "Cannot get Data (%i): %s\n", getstatus, outMessage );
+            Trace::end( "sentence" );
+            return -4;
+        }
+
+        /* copy partial encoding and get more bytes */
+        if ( bytes_recv > 0 )
+        {
+            engine_samples += bytes_recv / 2;
+            if ( stat_first_sample < 0 ) {
+                stat_first_sample = elapsed_ms( stat_start );
+                Trace::instant( "first sample" );
+            }
+            if ( (bufused + bytes_recv) <= PCM_BUFFER_SIZE ) {
+                memcpy( pcm_buffer+bufused, (int8_t *)outbuf, bytes_recv );
+                bufused += bytes_recv;
+            }
+
+            /* or write the buffer to wavefile, and retrieve any leftover decoding bytes */
+            else
+            {
+                passSamples( (short*)pcm_buffer, bufused/2 );
+                bufused = 0;
+                memcpy( pcm_buffer, (int8_t *)outbuf, bytes_recv );
+                bufused += bytes_recv;
+            }
+        }
+
+        if ( getstatus == PICO_STEP_IDLE ) {
+            /* The engine ran out of text; pass the remaining samples. */
+            passSamples( (short*)pcm_buffer, bufused/2 );
+            bufused = 0;
+
+            if ( piece == 0 && current >= sources )
+                break; /* done */
+        }
+    }
+
+    // what the resampler holds back
+    if ( resampler && !cancelled ) {
+        unsigned int count = resampler->flush( resampled );
+        if ( sink ) {
+            TraceScope trace( "write" );
+            sink->write( resampled, count );
+        }
+    }
+
+    // the marks still open end with the text
+    if ( marks && !cancelled ) {
+        closeMarks( engine_samples, true );
+        if ( text_open ) {
+            text_mark.end = speech_end > text_mark.start ? speech_end : text_mark.start;
+            passMark( text_mark );
+            text_open = false;
+        }
+    }
+
+    Trace::end( "sentence" );
+    stat_synthesis = elapsed_ms( process_start );
+
+    return cancelled ? PROCESS_CANCELLED : 0;
+}
+
+// hand samples of the engine on to the sink, at the output rate
+void Pico::passSamples( short * samples, unsigned int count )
+{
+    if ( resampler ) {
+        count = resampler->process( samples, count, resampled );
+        samples = resampled;
+    }
+    if ( sink ) {
+        TraceScope trace( "write" );
+        sink->write( samples, count );
+    }
+}
+
+// the timing of the engine's speech, with Params::marks: the start of each
+// phone, word and pause, and the marks of the text, at the number of samples
+// the engine put out before. A phone ends where the next one starts, a word
+// where the next one or a pause does. The marks put in before the words of
+// the text (see markWord()) open a TEXT, from its first phone to its last.
+void Pico::timing( int kind, int phone, const char * name, unsigned long sample )
+{
+    if ( kind == PICOEXT_TIMING_MARK ) {
+        size_t offset, length;
+        if ( sscanf( name, text_mark_scan, &offset, &length ) != 2 ) {
+            nanotts::Mark named = new_mark( nanotts::Mark::NAMED, sample );
+            named.name = name;
+            passMark( named );
+            return;
+        }
+        if ( phone_open && phone_mark.type == nanotts::Mark::PHONE )
+            speech_end = sample;
+        if ( text_open ) {
+            text_mark.end = speech_end > text_mark.start ? speech_end : text_mark.start;
+            passMark( text_mark );
+        }
+        text_mark = new_mark( nanotts::Mark::TEXT, sample );
+        text_mark.offset = offset;
+        text_mark.length = length;
+        text_open = true;
+        text_spoken = false;
+        return;
+    }
+
+    closeMarks( sample, kind != PICOEXT_TIMING_PHONE );
+    if ( kind == PICOEXT_TIMING_WORD ) {
+        word_mark = new_mark( nanotts::Mark::WORD, sample );
+        word_open = true;
+    }
+    phone_mark = new_mark( kind == PICOEXT_TIMING_PAUSE ? nanotts::Mark::PAUSE : nanotts::Mark::PHONE, sample );
+    phone_mark.phone = phone;
+    phone_open = true;
+    if ( text_open && !text_spoken && kind != PICOEXT_TIMING_PAUSE ) {
+        text_mark.start = sample;
+        text_spoken = true;
+    }
+}
+
+// ends the open phone at an engine sample, and the word with it
+void Pico::closeMarks( unsigned long sample, bool word )
+{
+    if ( phone_open ) {
+        phone_mark.end = sample;
+        if ( phone_mark.type == nanotts::Mark::PHONE )
+            speech_end = sample;
+        passMark( phone_mark );
+        phone_open = false;
+    }
+    if ( word && word_open ) {
+        word_mark.end = sample;
+        passMark( word_mark );
+        word_open = false;
+    }
+}
+
+// a mark in engine samples to the sink, in samples of the text at the output rate
+void Pico::passMark( nanotts::Mark & mark )
+{
+    nanotts::Mark out = mark;
+    out.start = (unsigned long long) (mark.start - text_start) * output_rate / SAMPLE_FREQ_16KHZ;
+    out.end = (unsigned long long) (mark.end - text_start) * output_rate / SAMPLE_FREQ_16KHZ;
+    if ( sink )
+        sink->mark( out );
+}
+
+// the piece of text up to the start of the next word; a word that starts
+// the piece gets a mark before it, in mark_tag, with its offset and length.
+// Not inside tags, and not after what may be an abbreviation, short with a
+// capital or another '.': a mark between "Dr." and "Smith" makes the engine
+// read "Dr." as a word of its own.
+pico_Int16 Pico::markWord( const pico_Char * text, pico_Int16 length, size_t pos )
+{
+    bool space = scan_space, tag = scan_tag;
+
+    for ( pico_Int16 i = 0; i < length; i++ ) {
+        if ( tag ) {
+            tag = text[i] != '>';
+            space = !tag;
+        } else if ( text[i] == '<' ) {
+            tag = true;
+        } else if ( isspace( text[i] ) ) {
+            space = true;
+        } else if ( space ) {
+            if ( i > 0 )
+                return i;
+            if ( !scan_abbreviation ) {
+                pico_Int16 end = 0;
+                while ( end < length && !isspace( text[end] ) && text[end] != '<' )
+                    end++;
+                mark_tag_length = snprintf( (char *) mark_tag, sizeof(mark_tag), text_mark_format, pos, (size_t) end );
+                mark_tag_fed = mark_tag;
+            }
+            space = false;
+        }
+    }
+    return length;
+}
+
+// follows the text fed to the engine, for markWord()
+void Pico::scanFed( const pico_Char * text, pico_Int16 length )
+{
+    for ( pico_Int16 i = 0; i < length; i++ ) {
+        if ( scan_tag ) {
+            scan_tag = text[i] != '>';
+            scan_space = !scan_tag;
+        } else if ( text[i] == '<' ) {
+            scan_tag = true;
+        } else if ( isspace( text[i] ) ) {
+            scan_space = true;
+            scan_token = 0;
+        } else {
+            if ( scan_token == 0 ) {
+                scan_capital = isupper( text[i] );
+                scan_dotted = false;
+            }
+            scan_space = false;
+            scan_token++;
+            scan_abbreviation = text[i] == '.' && scan_token <= 4 && (scan_capital || scan_dotted);
+            scan_dotted = scan_dotted || text[i] == '.';
+        }
+    }
+}
+
+// convert the output from the engine's 16 kHz to another rate
+void Pico::setOutputRate( unsigned int rate, Resampler::Quality quality )
+{
+    if ( rate == output_rate && (rate == SAMPLE_FREQ_16KHZ || quality == output_quality) )
+        return;
+
+    delete resampler;
+    delete[] resampled;
+    resampler = 0;
+    resampled = 0;
+
+    output_rate = rate;
+    output_quality = quality;
+    if ( rate == SAMPLE_FREQ_16KHZ )
+        return;
+
+    resampler = new Resampler( SAMPLE_FREQ_16KHZ, rate, quality );
+    unsigned int size = resampler->maxOutput( PCM_BUFFER_SIZE / 2 );
+    if ( size < resampler->maxOutput( resampler->delay() ) )
+        size = resampler->maxOutput( resampler->delay() );
+    resampled = new short[ size ];
+}
+
+// stop process() within one synthesis step; safe to call from a signal
+// handler or another thread. A cancel while idle does nothing.
+void Pico::cancel()
+{
+    clock_gettime( CLOCK_MONOTONIC, &cancel_time );
+    cancel_requested = 1;
+}
+
+// expand the mul pdfs of the Lingware when it is loaded; the default arena
+// grows by what they take
+void Pico::expandPdfs( bool new_setting )
+{
+    pico_expandPdfs = new_setting;
+    if ( !picoMemSizeSet )
+        picoMemSize = new_setting ? PICO_MEM_SIZE + PICO_EXPANDED_PDF_SIZE : PICO_MEM_SIZE;
+}
+
+int Pico::setVoice( const char * v ) {
+    return voices.setVoice( v );
+}
+
+// time since the previous lap, in ms
+double Pico::statLap() {
+    double now = elapsed_ms( stat_start );
+    double lap = now - stat_mark;
+    stat_mark = now;
+    return lap;
+}
+
+void Pico::printStats() {
+    pico_Retstring  name;
+    pico_Int16      constructed;
+    pico_Uint32     usec;
+
+    fprintf( stderr, "startup:\n" );
+    if ( stat_image >= 0 ) {
+        fprintf( stderr, "  %-28s %9.3f ms\n", "restore engine image", stat_image );
+    } else {
+        fprintf( stderr, "  %-28s %9.3f ms\n", "system initialization", stat_initialize );
+        fprintf( stderr, "  %-28s %9.3f ms\n", "load text analysis", stat_load_ta );
+        fprintf( stderr, "  %-28s %9.3f ms\n", "load signal generation", stat_load_sg );
+        fprintf( stderr, "  %-28s %9.3f ms\n", "voice definition", stat_voice );
+        fprintf( stderr, "  %-28s %9.3f ms%s\n", "engine creation", stat_engine, pico_lazyInit ? " (lazy)" : "" );
+    }
+    if ( picoEngine ) {
+        for ( pico_Int16 i = 0; PICO_OK == picoext_getEngineStartupProfile( picoEngine, i, name, &constructed, &usec ); i++ ) {
+            if ( constructed ) {
+                fprintf( stderr, "    %-26s %9.3f ms cpu\n", name, usec / 1000.0 );
+            } else {
+                fprintf( stderr, "    %-26s %12s\n", name, "not used" );
+            }
+        }
+    }
+    fprintf( stderr, "synthesis:\n" );
+    if ( stat_first_sample >= 0 ) {
+        fprintf( stderr, "  %-28s %9.3f ms\n", "first sample after", stat_first_sample );
+    }
+    fprintf( stderr, "  %-28s %9.3f ms\n", "text to speech", stat_synthesis );
+    if ( stat_cancel >= 0 ) {
+        fprintf( stderr, "  %-28s %9.3f ms\n", "cancel to ready", stat_cancel );
+    }
+
+    pico_Int32      used, incr, sys_max, eng_max;
+    pico_Uint32     eng_size;
+    if ( picoEngine
+            && PICO_OK == picoext_getSystemMemUsage( picoSystem, 0, &used, &incr, &sys_max )
+            && PICO_OK == picoext_getEngineMemUsage( picoEngine, 0, &used, &incr, &eng_max )
+            && PICO_OK == picoext_getEngineMemSize( picoEngine, &eng_size ) ) {
+        fprintf( stderr, "memory:\n" );
+        fprintf( stderr, "  %-28s %9u bytes\n", "arena", picoMemSize );
+        fprintf( stderr, "  %-28s %9u bytes\n", "Lingware and voice", sys_max - eng_size );
+        fprintf( stderr, "  %-28s %9d bytes of %u\n", "engine peak", eng_max, eng_size );
+        fprintf( stderr, "  %-28s %9u bytes\n", "recommended --mem-size", recommendedMemSize() );
+        // the default is a fixed size for all voices, not measured for this one
+        unsigned int default_size = pico_expandPdfs ? PICO_MEM_SIZE + PICO_EXPANDED_PDF_SIZE : PICO_MEM_SIZE;
+        if ( recommendedMemSize() > default_size )
+            fprintf( stderr, "  %-28s (above the default of %u, which is too small for this voice)\n", "", default_size );
+    }
+}
+
+// arena size that holds the Lingware and the engine's peak use so far, with
+// the headroom of PICO_MIN_ENGINE_SIZE
+unsigned int Pico::recommendedMemSize()
+{
+    pico_Int32      used, incr, sys_max, eng_max;
+    pico_Uint32     eng_size;
+
+    if ( !picoEngine
+            || PICO_OK != picoext_getSystemMemUsage( picoSystem, 0, &used, &incr, &sys_max )
+            || PICO_OK != picoext_getEngineMemUsage( picoEngine, 0, &used, &incr, &eng_max )
+            || PICO_OK != picoext_getEngineMemSize( picoEngine, &eng_size ) ) {
+        return 0;
+    }
+
+    unsigned int size = sys_max - eng_size + PICO_MEM_RESERVE + eng_max + PICO_ENGINE_HEADROOM;
+    if ( size < sys_max - eng_size + PICO_MEM_RESERVE + PICO_MIN_ENGINE_SIZE )
+        size = sys_max - eng_size + PICO_MEM_RESERVE + PICO_MIN_ENGINE_SIZE;
+    return (size + 4095) / 4096 * 4096;
+}
@@ -0,0 +1,166 @@
+#ifndef __Pico__
+#define __Pico__
+
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+
+#include "svoxpico/picoapi.h"
+#include "PicoVoices.h"
+#include "PicoImage.h"
+#include "Resampler.h"
+#include "mmfile.h"
+#include "nanotts.h"
+
+#define PICO_MEM_SIZE 2500000
+#define PICO_MEM_RESERVE 16384      // for the voice and engine objects, with --mem-size
+#define PICO_EXPANDED_PDF_SIZE 2250000   // the expanded pdfs of a voice, 1560032 to 2220032 bytes in lang/
+// the processing units take their buffers when the engine is created, its
+// peak (983648 to 986048 bytes for the voices in lang/) is reached then and
+// no text measured adds to it
+#define PICO_ENGINE_PEAK 986048
+#define PICO_ENGINE_HEADROOM 16384  // over the peak, for texts and voices not measured
+#define PICO_MIN_ENGINE_SIZE (PICO_ENGINE_PEAK + PICO_ENGINE_HEADROOM)
+
+/*
+================================================
+Boilerplate
+
+adds padding text around input to set various parameters in pico
+================================================
+*/
+class Boilerplate {
+    char plate_begin[100];
+    char plate_end[50];
+
+public:
+    Boilerplate( float speed, float pitch, float volume );     // -1 leaves one out
+
+    bool isChanged() const { return plate_begin[0] != 0; }
+
+    const char * getOpener( unsigned int * l ) const { *l = strlen(plate_begin); return plate_begin; }
+    const char * getCloser( unsigned int * l ) const { *l = strlen(plate_end); return plate_end; }
+};
+
+/*
+================================================
+Pico
+
+class to encapsulate the workings of the SVox PicoTTS System
+================================================
+*/
+class Pico {
+private:
+    PicoVoices_t        voices;
+
+    pico_System         picoSystem;
+    pico_Resource       picoTaResource;
+    pico_Resource       picoSgResource;
+    pico_Engine         picoEngine;
+
+    const pico_Char *   local_text;
+    size_t              total_text_length;
+    mmfile_t *          text_file;
+    char *              picoLingwarePath;
+
+    char                picoVoiceName[10];
+    nanotts::Sink *     sink;
+    const Boilerplate * modifiers;
+
+    void *              picoMemArea;
+    unsigned int        picoMemSize;
+    bool                picoMemSizeSet;     // the engine takes what the Lingware leaves
+    PicoImage *         picoImage;
+    pico_Char *         picoTaFileName;
+    pico_Char *         picoSgFileName;
+    pico_Char *         picoTaResourceName;
+    pico_Char *         picoSgResourceName;
+    bool                pico_lazyInit;
+    bool                pico_expandPdfs;
+
+    // --stats: startup phases and synthesis, in ms
+    struct timespec     stat_start;
+    double              stat_mark;
+    double              stat_initialize;
+    double              stat_load_ta;
+    double              stat_load_sg;
+    double              stat_voice;
+    double              stat_engine;
+    double              stat_image;
+    double              stat_first_sample;
+    double              stat_synthesis;
+    double              stat_cancel;        // from cancel() to the engine being ready
+    double              statLap();
+
+    volatile sig_atomic_t cancel_requested;
+    struct timespec     cancel_time;
+
+    enum { PCM_BUFFER_SIZE = 256 };     // bytes passed on at a time
+    unsigned int        output_rate;
+    Resampler::Quality  output_quality;
+    Resampler *         resampler;      // 0 at the engine's own rate
+    short *             resampled;
+    void passSamples( short * samples, unsigned int count );
+
+    // Params::marks: the engine's timing (see timing()) as nanotts::Marks,
+    // and marks put in before the words of the text for their offsets
+    bool                marks;
+    unsigned long       engine_samples;     // since the engine was reset
+    unsigned long       text_start;         // engine_samples when the text started
+    unsigned long       speech_end;         // of the last phone that isn't a pause
+    nanotts::Mark       phone_mark;         // the open ones
+    nanotts::Mark       word_mark;
+    nanotts::Mark       text_mark;
+    bool                phone_open;
+    bool                word_open;
+    bool                text_open;
+    bool                text_spoken;        // a phone of the open TEXT started
+    pico_Char           mark_tag[ 80 ];     // being fed before a word
+    pico_Int16          mark_tag_length;
+    const pico_Char *   mark_tag_fed;
+    bool                scan_space;         // the text fed so far ends with a space
+    bool                scan_tag;           // ... inside a tag
+    bool                scan_abbreviation;  // ... with an abbreviation, "Dr. " or "e.g. "
+    size_t              scan_token;         // length of its last token
+    bool                scan_capital;       // which starts with a capital
+    bool                scan_dotted;        // and has a '.'
+    void                passMark( nanotts::Mark & mark );
+    void                closeMarks( unsigned long sample, bool word );
+    pico_Int16          markWord( const pico_Char * text, pico_Int16 length, size_t pos );
+    void                scanFed( const pico_Char * text, pico_Int16 length );
+
+    pico_Char * lingwareFile( const char * name );
+    void imageKey( char * key, size_t len );
+
+public:
+    enum { PROCESS_CANCELLED = 1 };
+
+    Pico() ;
+    virtual ~Pico() ;
+
+    void setLangFilePath( const char * path );
+    int initializeSystem() ;
+    int saveImage( const char * filename );
+    int restoreSystem( const char * filename );
+    void cleanup() ;
+    void sendTextForProcessing( const unsigned char *, size_t ) ;
+    void sendFileForProcessing( mmfile_t * ) ;
+    int process();
+    void cancel();
+
+    int setVoice( const char * );
+
+    void setSink( nanotts::Sink * sink ) { this->sink = sink; }
+    void addModifiers( const Boilerplate * modifiers ) { this->modifiers = modifiers; }
+    const char * getVoice() { return voices.getVoice(); }
+    void lazyInit( bool new_setting = true ) { pico_lazyInit = new_setting; }
+    void expandPdfs( bool new_setting = true );
+    void setOutputRate( unsigned int rate, Resampler::Quality quality );
+    void setMarks( bool on ) { marks = on; }
+    void timing( int kind, int phone, const char * name, unsigned long sample );
+    void memSize( unsigned int size ) { picoMemSize = size; picoMemSizeSet = true; }
+    unsigned int recommendedMemSize();
+    void printStats();
+};
+
+#endif // __Pico__
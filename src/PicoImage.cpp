@@ -0,0 +1,396 @@
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <link.h>
+#include <sys/utsname.h>
+
+#include <vector>
+
+#include "PicoImage.h"
+
+#define IMAGE_MAGIC     "NANOIMG"
+#define IMAGE_VERSION   2
+#define IMAGE_KEY_SIZE  1024
+#define IMAGE_PAGE_SIZE 4096
+
+struct image_header_t {
+    char        magic[ 8 ];
+    uint32_t    version;
+    uint32_t    num_handles;
+    char        key[ IMAGE_KEY_SIZE ];
+    uint64_t    size;               // size of the memory area
+    uint64_t    data_offset;        // file offset of the area, page aligned
+    uint64_t    handles[ PicoImage::MAX_HANDLES ];  // offsets into the area
+    uint32_t    num_data;           // words pointing into the area
+    uint32_t    num_code;           // words pointing into the executable
+    uint32_t    num_self;           // 32-bit magics: own address ^ mask
+    uint32_t    reserved;
+    uint64_t    checksum;           // of everything after the header
+};
+
+struct self_reloc_t {
+    uint32_t    offset;
+    uint32_t    mask;
+};
+
+struct exe_range_t {
+    uintptr_t   base;
+    uintptr_t   lo;
+    uintptr_t   hi;
+};
+
+// address range of the executable (the first object reported is the program itself)
+static int exe_range_cb( struct dl_phdr_info * info, size_t, void * data )
+{
+    exe_range_t * r = (exe_range_t *) data;
+    r->base = info->dlpi_addr;
+    r->lo = ~(uintptr_t)0;
+    r->hi = 0;
+    for ( int i = 0; i < info->dlpi_phnum; i++ ) {
+        if ( info->dlpi_phdr[i].p_type != PT_LOAD )
+            continue;
+        uintptr_t lo = info->dlpi_addr + info->dlpi_phdr[i].p_vaddr;
+        uintptr_t hi = lo + info->dlpi_phdr[i].p_memsz;
+        if ( lo < r->lo ) r->lo = lo;
+        if ( hi > r->hi ) r->hi = hi;
+    }
+    return 1;
+}
+
+static void exe_range( exe_range_t * r )
+{
+    memset( r, 0, sizeof(*r) );
+    dl_iterate_phdr( exe_range_cb, r );
+}
+
+// image key: caller's key plus the identity of this executable and machine
+static void full_key( char * dst, const char * key )
+{
+    struct stat     ss;
+    struct utsname  un;
+    memset( dst, 0, IMAGE_KEY_SIZE );
+    if ( -1 == stat( "/proc/self/exe", &ss ) ) {
+        memset( &ss, 0, sizeof(ss) );
+    }
+    if ( -1 == uname( &un ) ) {
+        strcpy( un.machine, "unknown" );
+    }
+    snprintf( dst, IMAGE_KEY_SIZE, "%s|exe %lld %lld|%s ptr %u",
+              key, (long long) ss.st_size, (long long) ss.st_mtime, un.machine, (unsigned) sizeof(void*) );
+}
+
+// FNV-style checksum over four interleaved 64-bit lanes; cheap enough to
+// verify a whole image on every load
+static uint64_t image_checksum( const unsigned char * p, size_t n, uint64_t seed )
+{
+    const uint64_t  prime   = 0x100000001b3ULL;
+    uint64_t        h[ 4 ]  = { seed, seed + 1, seed + 2, seed + 3 };
+    size_t          i       = 0;
+
+    for ( ; i + 32 <= n; i += 32 ) {
+        for ( int k = 0; k < 4; k++ ) {
+            uint64_t w;
+            memcpy( &w, p + i + 8 * k, 8 );
+            h[k] = (h[k] ^ w) * prime;
+        }
+    }
+    uint64_t r = n;
+    for ( ; i < n; i++ ) {
+        r = (r ^ p[i]) * prime;
+    }
+    for ( int k = 0; k < 4; k++ ) {
+        r = (r ^ h[k]) * prime;
+    }
+    return r;
+}
+
+// is p inside any mapping of this process (other than the executable)?
+static bool is_foreign_pointer( const std::vector<uintptr_t> & maps, const exe_range_t & exe, uintptr_t p )
+{
+    if ( p >= exe.lo && p < exe.hi )
+        return false;
+    for ( size_t i = 0; i + 1 < maps.size(); i += 2 ) {
+        if ( p >= maps[i] && p < maps[i+1] )
+            return true;
+    }
+    return false;
+}
+
+static void read_maps( std::vector<uintptr_t> & maps )
+{
+    FILE * fp = fopen( "/proc/self/maps", "r" );
+    if ( !fp )
+        return;
+    char line[ 512 ];
+    while ( fgets( line, sizeof(line), fp ) ) {
+        unsigned long lo, hi;
+        if ( 2 == sscanf( line, "%lx-%lx", &lo, &hi ) ) {
+            maps.push_back( lo );
+            maps.push_back( hi );
+        }
+    }
+    fclose( fp );
+}
+
+PicoImage::PicoImage() : area(0), size(0), map(0), map_size(0) {
+    memset( handles, 0, sizeof(handles) );
+}
+
+PicoImage::~PicoImage() {
+    close();
+}
+
+void PicoImage::close() {
+    if ( map ) {
+        munmap( map, map_size );
+        map = 0;
+        map_size = 0;
+    }
+    area = 0;
+    size = 0;
+}
+
+int PicoImage::save( const char * filename, const char * key,
+                     const void * area_a, const void * area_b, size_t size,
+                     void * const * handles_a, void * const * handles_b, int num_handles )
+{
+    const unsigned char *   a       = (const unsigned char *) area_a;
+    const unsigned char *   b       = (const unsigned char *) area_b;
+    const uintptr_t         base_a  = (uintptr_t) a;
+    const uintptr_t         base_b  = (uintptr_t) b;
+
+    std::vector<uint32_t>       data_relocs;
+    std::vector<uint32_t>       code_relocs;
+    std::vector<self_reloc_t>   self_relocs;
+    std::vector<uintptr_t>      maps;
+    exe_range_t                 exe;
+
+    if ( num_handles > MAX_HANDLES || (base_a % 16) != (base_b % 16) || (size % 8) != 0 ) {
+        fprintf( stderr, "image: unsupported memory layout\n" );
+        return -1;
+    }
+
+    image_header_t hdr;
+    memset( &hdr, 0, sizeof(hdr) );
+    memcpy( hdr.magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC) );
+    hdr.version = IMAGE_VERSION;
+    hdr.num_handles = num_handles;
+    full_key( hdr.key, key );
+    hdr.size = size;
+    for ( int i = 0; i < num_handles; i++ ) {
+        uintptr_t ha = (uintptr_t) handles_a[i];
+        uintptr_t hb = (uintptr_t) handles_b[i];
+        if ( ha < base_a || ha >= base_a + size || ha - base_a != hb - base_b ) {
+            fprintf( stderr, "image: handle %d differs between the two systems\n", i );
+            return -1;
+        }
+        hdr.handles[i] = ha - base_a;
+    }
+
+    exe_range( &exe );
+    read_maps( maps );
+
+    // classify every word that would not survive a move of the area
+    unsigned char * image = (unsigned char *) malloc( size );
+    if ( !image ) {
+        fprintf( stderr, "image: out of memory\n" );
+        return -1;
+    }
+    memcpy( image, a, size );
+
+    for ( size_t off = 0; off < size; off += 8 ) {
+        uint64_t wa, wb;
+        memcpy( &wa, a + off, 8 );
+        memcpy( &wb, b + off, 8 );
+
+        if ( wa == wb ) {
+            if ( wa >= exe.lo && wa < exe.hi ) {
+                code_relocs.push_back( off );
+                uint64_t rel = wa - exe.base;
+                memcpy( image + off, &rel, 8 );
+            } else if ( is_foreign_pointer( maps, exe, wa ) ) {
+                fprintf( stderr, "image: pointer outside the memory area at offset %lu\n", (unsigned long) off );
+                free( image );
+                return -1;
+            }
+            continue;
+        }
+
+        if ( wa >= base_a && wa <= base_a + size && wa - base_a == wb - base_b ) {
+            data_relocs.push_back( off );
+            uint64_t rel = wa - base_a;
+            memcpy( image + off, &rel, 8 );
+            continue;
+        }
+
+        for ( size_t half = 0; half < 8; half += 4 ) {
+            uint32_t ha, hb;
+            memcpy( &ha, a + off + half, 4 );
+            memcpy( &hb, b + off + half, 4 );
+            if ( ha == hb )
+                continue;
+            uint32_t mask = ha ^ (uint32_t) (base_a + off + half);
+            if ( mask != (hb ^ (uint32_t) (base_b + off + half)) ) {
+                fprintf( stderr, "image: state is not reproducible at offset %lu\n", (unsigned long) (off + half) );
+                free( image );
+                return -1;
+            }
+            self_reloc_t r = { (uint32_t) (off + half), mask };
+            self_relocs.push_back( r );
+            memcpy( image + off + half, &mask, 4 );
+        }
+    }
+
+    hdr.num_data = data_relocs.size();
+    hdr.num_code = code_relocs.size();
+    hdr.num_self = self_relocs.size();
+
+    size_t tables = sizeof(hdr) + (hdr.num_data + hdr.num_code) * sizeof(uint32_t)
+                  + hdr.num_self * sizeof(self_reloc_t);
+    hdr.data_offset = (tables + IMAGE_PAGE_SIZE - 1) / IMAGE_PAGE_SIZE * IMAGE_PAGE_SIZE;
+
+    // relocation tables and padding, as they follow the header in the file
+    std::vector<unsigned char> body( hdr.data_offset - sizeof(hdr), 0 );
+    unsigned char * pos = body.data();
+    memcpy( pos, data_relocs.data(), hdr.num_data * sizeof(uint32_t) );
+    pos += hdr.num_data * sizeof(uint32_t);
+    memcpy( pos, code_relocs.data(), hdr.num_code * sizeof(uint32_t) );
+    pos += hdr.num_code * sizeof(uint32_t);
+    memcpy( pos, self_relocs.data(), hdr.num_self * sizeof(self_reloc_t) );
+
+    hdr.checksum = image_checksum( body.data(), body.size(), image_checksum( image, size, 0 ) );
+
+    // write to a temporary name, so a concurrent load never sees a partial image
+    size_t tmplen = strlen( filename ) + 16;
+    char * tmpname = new char[ tmplen ];
+    snprintf( tmpname, tmplen, "%s.%d", filename, (int) getpid() );
+
+    FILE * fp = fopen( tmpname, "wb" );
+    bool ok = fp != 0;
+    if ( ok ) {
+        ok = ok && 1 == fwrite( &hdr, sizeof(hdr), 1, fp );
+        ok = ok && body.size() == fwrite( body.data(), 1, body.size(), fp );
+        ok = ok && size == fwrite( image, 1, size, fp );
+        ok = (0 == fclose( fp )) && ok;
+    }
+    if ( ok ) {
+        ok = 0 == rename( tmpname, filename );
+    }
+    if ( !ok ) {
+        fprintf( stderr, "image: cannot write \"%s\"\n", filename );
+        unlink( tmpname );
+    } else {
+        fprintf( stderr, "wrote image \"%s\" (%u relocations)\n", filename,
+                 hdr.num_data + hdr.num_code + hdr.num_self );
+    }
+
+    delete[] tmpname;
+    free( image );
+    return ok ? 0 : -1;
+}
+
+int PicoImage::load( const char * filename, const char * key, size_t expected_size, int num_handles )
+{
+    close();
+
+    int fd = open( filename, O_RDONLY );
+    if ( fd < 0 ) {
+        fprintf( stderr, "image: cannot open \"%s\"\n", filename );
+        return -1;
+    }
+
+    struct stat ss;
+    if ( fstat( fd, &ss ) < 0 || (size_t) ss.st_size < sizeof(image_header_t) ) {
+        fprintf( stderr, "image: \"%s\" is not an image\n", filename );
+        ::close( fd );
+        return -1;
+    }
+
+    // private mapping, read in at once for the checksum; made writable
+    // afterwards, so relocation only copies the pages holding pointers
+    map_size = ss.st_size;
+    map = mmap( 0, map_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0 );
+    ::close( fd );
+    if ( MAP_FAILED == map ) {
+        map = 0;
+        map_size = 0;
+        fprintf( stderr, "image: cannot map \"%s\"\n", filename );
+        return -1;
+    }
+
+    const image_header_t * hdr = (const image_header_t *) map;
+    char key_here[ IMAGE_KEY_SIZE ];
+    full_key( key_here, key );
+
+    if ( memcmp( hdr->magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC) ) || hdr->version != IMAGE_VERSION ) {
+        fprintf( stderr, "image: \"%s\" is not an image\n", filename );
+        close();
+        return -1;
+    }
+    if ( strncmp( hdr->key, key_here, IMAGE_KEY_SIZE ) || hdr->size != expected_size
+            || (int) hdr->num_handles != num_handles ) {
+        fprintf( stderr, "image: \"%s\" was made for another voice, lingware or build\n", filename );
+        close();
+        return -1;
+    }
+
+    uint64_t tables = sizeof(image_header_t) + ((uint64_t) hdr->num_data + hdr->num_code) * sizeof(uint32_t)
+                    + (uint64_t) hdr->num_self * sizeof(self_reloc_t);
+    if ( tables > hdr->data_offset || hdr->data_offset + hdr->size > map_size ) {
+        fprintf( stderr, "image: \"%s\" is truncated\n", filename );
+        close();
+        return -1;
+    }
+    if ( hdr->checksum != image_checksum( (const unsigned char *) (hdr + 1), hdr->data_offset - sizeof(*hdr),
+                                          image_checksum( (const unsigned char *) map + hdr->data_offset, hdr->size, 0 ) ) ) {
+        fprintf( stderr, "image: \"%s\" is corrupt\n", filename );
+        close();
+        return -1;
+    }
+    if ( -1 == mprotect( map, map_size, PROT_READ | PROT_WRITE ) ) {
+        fprintf( stderr, "image: cannot map \"%s\"\n", filename );
+        close();
+        return -1;
+    }
+
+    unsigned char *         base    = (unsigned char *) map + hdr->data_offset;
+    const uint32_t *        data    = (const uint32_t *) (hdr + 1);
+    const uint32_t *        code    = data + hdr->num_data;
+    const self_reloc_t *    self    = (const self_reloc_t *) (code + hdr->num_code);
+    exe_range_t             exe;
+    exe_range( &exe );
+
+    for ( uint32_t i = 0; i < hdr->num_data; i++ ) {
+        if ( data[i] + 8 > hdr->size ) goto corrupt;
+        *(uint64_t *) (base + data[i]) += (uintptr_t) base;
+    }
+    for ( uint32_t i = 0; i < hdr->num_code; i++ ) {
+        if ( code[i] + 8 > hdr->size ) goto corrupt;
+        *(uint64_t *) (base + code[i]) += exe.base;
+    }
+    for ( uint32_t i = 0; i < hdr->num_self; i++ ) {
+        if ( self[i].offset + 4 > hdr->size ) goto corrupt;
+        *(uint32_t *) (base + self[i].offset) = (uint32_t) ((uintptr_t) base + self[i].offset) ^ self[i].mask;
+    }
+    for ( int i = 0; i < num_handles; i++ ) {
+        if ( hdr->handles[i] >= hdr->size ) goto corrupt;
+        handles[i] = base + hdr->handles[i];
+    }
+
+    area = base;
+    size = hdr->size;
+    return 0;
+
+corrupt:
+    fprintf( stderr, "image: \"%s\" is corrupt\n", filename );
+    close();
+    return -1;
+}
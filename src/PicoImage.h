@@ -0,0 +1,48 @@
+#ifndef __PicoImage__
+#define __PicoImage__
+
+#include <stddef.h>
+
+/*
+================================================
+PicoImage
+
+snapshot of a freshly initialized pico memory area (system, resources,
+voice and engine), written to a file and later mapped back in place of
+loading the lingware.
+
+The pico memory area holds absolute pointers, so an image is made from two
+areas that were initialized identically at different addresses: every word
+that differs by exactly the distance of the two areas points into the area,
+words that point into the executable are equal in both, and the handle
+magics are 32-bit xors of their own address. All of these are written
+relative to their base and relocated on load. Any other difference (or a
+pointer to memory outside the area and the executable) means the state is
+not reproducible, and no image is written.
+================================================
+*/
+class PicoImage {
+public:
+    enum { MAX_HANDLES = 8 };
+
+    void *          area;       // relocated memory area, valid after load()
+    size_t          size;
+    void *          handles[ MAX_HANDLES ];
+
+public:
+    PicoImage();
+    ~PicoImage();
+
+    static int save( const char * filename, const char * key,
+                     const void * area_a, const void * area_b, size_t size,
+                     void * const * handles_a, void * const * handles_b, int num_handles );
+
+    int load( const char * filename, const char * key, size_t size, int num_handles );
+    void close();
+
+private:
+    void *          map;
+    size_t          map_size;
+};
+
+#endif // __PicoImage__
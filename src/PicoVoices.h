@@ -27,7 +27,7 @@ public:
 };
     
 
-PicoVoices_t::PicoVoices_t() {
+inline PicoVoices_t::PicoVoices_t() {
     
     /* supported voices
        Pico does not seperately specify the voice and locale.   */
@@ -71,7 +71,7 @@ PicoVoices_t::PicoVoices_t() {
     }
 }
 
-PicoVoices_t::~PicoVoices_t() {
+inline PicoVoices_t::~PicoVoices_t() {
     delete[] picoSupportedLangIso3[0];
     delete[] picoSupportedLangIso3;
     delete[] picoSupportedCountryIso3;
@@ -82,7 +82,7 @@ PicoVoices_t::~PicoVoices_t() {
     delete[] picoInternalUtppLingware;
 }
 
-int PicoVoices_t::setVoice( int i ) {
+inline int PicoVoices_t::setVoice( int i ) {
     if ( i >= 0 && i < 6 ) {
         voice = i;
         return 0;
@@ -90,7 +90,7 @@ int PicoVoices_t::setVoice( int i ) {
     return -1;
 }
 
-int PicoVoices_t::setVoice( const char * voc ) {
+inline int PicoVoices_t::setVoice( const char * voc ) {
     char ** matchable[] = { picoSupportedLang, picoSupportedLangIso3, picoSupportedCountryIso3, 0 };
     for ( int i = 0 ; i < 6; i++ ) {
         int j = 0;
@@ -106,15 +106,15 @@ int PicoVoices_t::setVoice( const char * voc ) {
     return -1;
 }
 
-const char * PicoVoices_t::getTaName() {
+inline const char * PicoVoices_t::getTaName() {
     return picoInternalTaLingware[ voice ];
 }
 
-const char * PicoVoices_t::getSgName() {
+inline const char * PicoVoices_t::getSgName() {
     return picoInternalSgLingware[ voice ];
 }
 
-const char * PicoVoices_t::getVoice() {
+inline const char * PicoVoices_t::getVoice() {
     return picoInternalLang[ voice ];
 }
 
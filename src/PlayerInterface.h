@@ -1,16 +1,47 @@
 #ifndef __PlayerInterface__
 #define __PlayerInterface__
 
+#include <string.h>
+
 enum {
     STREAM_OK       = 0,
     STREAM_ERROR    = -1
 };
 
+// --device, --latency, --period, --buffer, --no-mmap
+struct PlaybackOptions {
+    const char *    device;             // eg. "default", "hw:0", "null"
+    unsigned int    period_us;          // the device may round both
+    unsigned int    buffer_us;
+    bool            mmap;               // write into the device's ring, if it has one
+    bool            print_stats;        // at close; xruns are reported anyway
+
+    PlaybackOptions() : device( "default" ), period_us( 12500 ), buffer_us( 50000 ), mmap( true ), print_stats( false ) { }
+
+    // low: 5 ms periods, 20 ms buffer; normal: 12.5 and 50 ms; robust: 50 and 250 ms
+    bool setLatency( const char * profile ) {
+        if ( strcmp( profile, "low" ) == 0 ) {
+            period_us = 5000;
+            buffer_us = 20000;
+        } else if ( strcmp( profile, "normal" ) == 0 ) {
+            period_us = 12500;
+            buffer_us = 50000;
+        } else if ( strcmp( profile, "robust" ) == 0 ) {
+            period_us = 50000;
+            buffer_us = 250000;
+        } else {
+            return false;
+        }
+        return true;
+    }
+};
+
 class PlayerInterface {
 public:
     virtual ~PlayerInterface() { }
     virtual int StreamOpen()    = 0;
     virtual int SubmitFrames( unsigned char * frames, unsigned int frame_count )    = 0;
+    virtual int StreamDrop()    = 0;    // discard frames not played yet
     virtual int StreamClose()   = 0;
 };
 
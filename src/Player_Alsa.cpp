@@ -1,8 +1,19 @@
 
-// extremely basic Alsa stream device that has hardcoded PCM parameters
+// Alsa stream device, see Player_Alsa.h
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
 #include "Player_Alsa.h"
 
-Player_Alsa::Player_Alsa() : blocking_flag( 0 ), interface_started( false ) {
+static double now_ms() {
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+Player_Alsa::Player_Alsa( unsigned int _rate, const PlaybackOptions & _options ) : handle( 0 ), blocking_flag( 0 ), interface_started( false ), rate( _rate ), options( _options ), mmap_access( false ), period_size( 0 ), buffer_size( 0 ) {
+    memset( &stats, 0, sizeof(stats) );
 }
 
 Player_Alsa::~Player_Alsa() {
@@ -10,7 +21,6 @@ Player_Alsa::~Player_Alsa() {
 }
 
 int Player_Alsa::StreamOpen() {
-    const char * device = "default";
     int err;
 
     if ( interface_started ) {
@@ -18,19 +28,21 @@ int Player_Alsa::StreamOpen() {
     }
 
     // open the PCM device
-    if ( (err = snd_pcm_open( &handle, device, SND_PCM_STREAM_PLAYBACK, blocking_flag )) < 0 ) {
-        fprintf( stderr, "error: opening pcm device failed %s\n", snd_strerror(err) );
+    if ( (err = snd_pcm_open( &handle, options.device, SND_PCM_STREAM_PLAYBACK, blocking_flag )) < 0 ) {
+        fprintf( stderr, "error: opening pcm device \"%s\" failed: %s\n", options.device, snd_strerror(err) );
+        return STREAM_ERROR;
     }
 
-    // setup our pcm state (on the snd_pcm_t handle)
-    if ( (err = snd_pcm_set_params( handle,
-                                    SND_PCM_FORMAT_S16_LE,
-                                    SND_PCM_ACCESS_RW_INTERLEAVED,
-                                    1,
-                                    16000,
-                                    1,
-                                    50000 ) ) < 0 ) {   /* 0.05 sec */
+    // setup our pcm state (on the snd_pcm_t handle), mmap access if we can
+    mmap_access = options.mmap;
+    if ( mmap_access && SetHwParams( SND_PCM_ACCESS_MMAP_INTERLEAVED ) < 0 ) {
+        fprintf( stderr, "pcm device \"%s\" has no mmap access, writing to it instead\n", options.device );
+        mmap_access = false;
+    }
+    if ( (!mmap_access && (err = SetHwParams( SND_PCM_ACCESS_RW_INTERLEAVED )) < 0) || (err = SetSwParams()) < 0 ) {
         fprintf( stderr, "Playback open error: %s\n", snd_strerror(err) );
+        snd_pcm_close( handle );
+        return STREAM_ERROR;
     }
 
     interface_started = true;
@@ -38,36 +50,188 @@ int Player_Alsa::StreamOpen() {
     return STREAM_OK;
 }
 
+int Player_Alsa::SetHwParams( snd_pcm_access_t access ) {
+    snd_pcm_hw_params_t * hw;
+    unsigned int granted = rate;
+    unsigned int buffer_us = options.buffer_us;
+    unsigned int period_us = options.period_us;
+    int dir = 0;
+    int err;
+
+    snd_pcm_hw_params_alloca( &hw );
+    if ( (err = snd_pcm_hw_params_any( handle, hw )) < 0
+            || (err = snd_pcm_hw_params_set_rate_resample( handle, hw, 1 )) < 0
+            || (err = snd_pcm_hw_params_set_access( handle, hw, access )) < 0
+            || (err = snd_pcm_hw_params_set_format( handle, hw, SND_PCM_FORMAT_S16_LE )) < 0
+            || (err = snd_pcm_hw_params_set_channels( handle, hw, 1 )) < 0
+            || (err = snd_pcm_hw_params_set_rate_near( handle, hw, &granted, 0 )) < 0 ) {
+        return err;
+    }
+    if ( granted != rate ) {
+        fprintf( stderr, "error: pcm device \"%s\" plays %u Hz, not %u\n", options.device, granted, rate );
+        return -EINVAL;
+    }
+    if ( (err = snd_pcm_hw_params_set_buffer_time_near( handle, hw, &buffer_us, &dir )) < 0
+            || (err = snd_pcm_hw_params_set_period_time_near( handle, hw, &period_us, &dir )) < 0
+            || (err = snd_pcm_hw_params( handle, hw )) < 0 ) {
+        return err;
+    }
+
+    snd_pcm_hw_params_get_buffer_size( hw, &buffer_size );
+    snd_pcm_hw_params_get_period_size( hw, &period_size, &dir );
+    return 0;
+}
+
+int Player_Alsa::SetSwParams() {
+    snd_pcm_sw_params_t * sw;
+    int err;
+
+    // start when the buffer is full, wake up for a period
+    snd_pcm_sw_params_alloca( &sw );
+    if ( (err = snd_pcm_sw_params_current( handle, sw )) < 0
+            || (err = snd_pcm_sw_params_set_start_threshold( handle, sw, (buffer_size / period_size) * period_size )) < 0
+            || (err = snd_pcm_sw_params_set_avail_min( handle, sw, period_size )) < 0
+            || (err = snd_pcm_sw_params( handle, sw )) < 0 ) {
+        return err;
+    }
+    return 0;
+}
+
+// prepares the device again after an underrun or a suspend; err is what
+// the failed call returned
+int Player_Alsa::Recover( int err ) {
+    double start = now_ms();
+
+    if ( err == -EPIPE )
+        stats.xruns++;
+    else if ( err == -ESTRPIPE )
+        stats.suspends++;
+
+    if ( (err = snd_pcm_recover( handle, err, 1 )) < 0 ) {
+        stats.failed++;
+        fprintf( stderr, "error: pcm device \"%s\" not recovered: %s\n", options.device, snd_strerror( err ) );
+        return err;
+    }
+
+    double elapsed = now_ms() - start;
+    stats.recovery_ms += elapsed;
+    if ( elapsed > stats.max_recovery_ms )
+        stats.max_recovery_ms = elapsed;
+    return 0;
+}
+
+int Player_Alsa::WriteMmap( const short * samples, snd_pcm_uframes_t count ) {
+    int err;
+
+    while ( count > 0 ) {
+        snd_pcm_sframes_t avail = snd_pcm_avail_update( handle );
+        if ( avail < 0 ) {
+            if ( Recover( avail ) < 0 )
+                return STREAM_ERROR;
+            continue;
+        }
+
+        // the ring is full: wait for the device to play a period
+        if ( avail == 0 ) {
+            if ( snd_pcm_state( handle ) == SND_PCM_STATE_PREPARED && (err = snd_pcm_start( handle )) < 0 && Recover( err ) < 0 )
+                return STREAM_ERROR;
+            if ( (err = snd_pcm_wait( handle, 1000 )) < 0 && Recover( err ) < 0 )
+                return STREAM_ERROR;
+            continue;
+        }
+
+        const snd_pcm_channel_area_t * areas;
+        snd_pcm_uframes_t offset;
+        snd_pcm_uframes_t frames = count < (snd_pcm_uframes_t) avail ? count : avail;
+        if ( (err = snd_pcm_mmap_begin( handle, &areas, &offset, &frames )) < 0 ) {
+            if ( Recover( err ) < 0 )
+                return STREAM_ERROR;
+            continue;
+        }
+
+        // one channel, interleaved: the frames are contiguous
+        char * ring = (char *) areas[0].addr + areas[0].first / 8 + offset * (areas[0].step / 8);
+        memcpy( ring, samples, frames * sizeof(short) );
+
+        snd_pcm_sframes_t committed = snd_pcm_mmap_commit( handle, offset, frames );
+        if ( committed > 0 ) {
+            samples += committed;
+            count -= committed;
+        }
+        if ( committed < 0 || (snd_pcm_uframes_t) committed != frames ) {
+            if ( Recover( committed < 0 ? committed : -EPIPE ) < 0 )
+                return STREAM_ERROR;
+        }
+    }
+    return STREAM_OK;
+}
+
+int Player_Alsa::WriteRw( const short * samples, snd_pcm_uframes_t count ) {
+    while ( count > 0 ) {
+        snd_pcm_sframes_t written = snd_pcm_writei( handle, samples, count );
+        if ( written == -EAGAIN ) {
+            snd_pcm_wait( handle, 1000 );
+            continue;
+        }
+        if ( written < 0 ) {
+            if ( Recover( written ) < 0 )
+                return STREAM_ERROR;
+            continue;
+        }
+        samples += written;
+        count -= written;
+    }
+    return STREAM_OK;
+}
+
 int Player_Alsa::SubmitFrames( unsigned char * buffer, unsigned int frame_count )
 {
-    snd_pcm_sframes_t frames = snd_pcm_writei( handle, buffer, frame_count );
-
-    if ( frames < 0 ) {
-        fprintf( stderr, "error: snd_pcm_writei: %s\n", snd_strerror( frames ) );
-        fflush( stdout );
-        frames = snd_pcm_recover( handle, frames, 0 );
-        if ( frames < 0 ) {
-            fprintf( stderr, "error: snd_pcm_writei failed: %s\n", snd_strerror( frames ) );
-            fflush( stdout );
-            return STREAM_ERROR;
-        }
+    if ( !interface_started ) {
+        return STREAM_ERROR;
     }
 
-//    if ( frames > 0 ) {
-//        printf( "Played %li frames\n", frames );
-//    }
+    stats.submits++;
+    stats.frames += frame_count;
 
+    if ( mmap_access )
+        return WriteMmap( (const short *) buffer, frame_count );
+    return WriteRw( (const short *) buffer, frame_count );
+}
+
+// stop at once and discard the buffered frames, ready for new ones
+int Player_Alsa::StreamDrop()
+{
+    if ( !interface_started ) {
+        return STREAM_ERROR;
+    }
+    snd_pcm_drop( handle );
+    snd_pcm_prepare( handle );
     return STREAM_OK;
 }
 
+// plays what is buffered, then closes
 int Player_Alsa::StreamClose()
 {
     if ( interface_started ) {
+        snd_pcm_drain( handle );
         snd_pcm_close( handle );
         interface_started = false;
+        if ( options.print_stats || stats.xruns || stats.suspends || stats.failed )
+            PrintStats();
         return STREAM_OK;
     } else {
         return STREAM_ERROR;
     }
 }
 
+void Player_Alsa::PrintStats()
+{
+    fprintf( stderr, "playback: \"%s\", %s access, period %lu frames, buffer %lu frames (%.1f ms)\n",
+             options.device, mmap_access ? "mmap" : "rw", (unsigned long) period_size, (unsigned long) buffer_size,
+             1000.0 * buffer_size / rate );
+    fprintf( stderr, "playback: %llu frames in %lu submits, %lu xruns, %lu suspends, %lu failed recoveries\n",
+             stats.frames, stats.submits, stats.xruns, stats.suspends, stats.failed );
+    if ( stats.xruns || stats.suspends )
+        fprintf( stderr, "playback: recovery took %.2f ms in all, %.2f ms at most\n",
+                 stats.recovery_ms, stats.max_recovery_ms );
+}
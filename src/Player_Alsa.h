@@ -4,18 +4,59 @@
 #include "PlayerInterface.h"
 #include <alsa/asoundlib.h>
 
+/*
+================================================
+Player_Alsa
+
+plays mono S16 frames on an ALSA PCM. With mmap access the frames are
+copied straight into the device's ring (snd_pcm_mmap_begin/commit); a PCM
+without it, or --no-mmap, gets snd_pcm_writei(). Period and buffer sizes
+come from PlaybackOptions; playback starts once the buffer is full, like
+snd_pcm_set_params() did.
+
+Underruns and suspends are recovered and counted. The "null" PCM, or
+"file:'out.raw',raw" which writes what is played to a file, need no
+sound hardware.
+================================================
+*/
 class Player_Alsa : public PlayerInterface {
 public:
     snd_pcm_t *     handle;
     int             blocking_flag;          // 0 = blocking; SND_PCM_NONBLOCK = not blocking
     bool            interface_started;
+    unsigned int    rate;
+    PlaybackOptions options;
+
+    // what the device granted
+    bool                mmap_access;
+    snd_pcm_uframes_t   period_size;
+    snd_pcm_uframes_t   buffer_size;
+
+    struct Stats {
+        unsigned long       submits;        // SubmitFrames() calls
+        unsigned long long  frames;
+        unsigned long       xruns;          // underruns
+        unsigned long       suspends;
+        unsigned long       failed;         // recoveries that failed
+        double              recovery_ms;    // spent recovering, in all
+        double              max_recovery_ms;
+    } stats;
 
 public:
-    Player_Alsa();
+    Player_Alsa( unsigned int rate = 16000, const PlaybackOptions & options = PlaybackOptions() );
     ~Player_Alsa();
     int StreamOpen();
     int SubmitFrames( unsigned char * frames, unsigned int frame_count );
+    int StreamDrop();
     int StreamClose();
+    void PrintStats();
+
+private:
+    int SetHwParams( snd_pcm_access_t access );
+    int SetSwParams();
+    int Recover( int err );
+    int WriteMmap( const short * samples, snd_pcm_uframes_t count );
+    int WriteRw( const short * samples, snd_pcm_uframes_t count );
 };
 
 #endif // __Player_Alsa__
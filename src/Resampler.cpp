@@ -0,0 +1,172 @@
+
+#include <string.h>
+#include <math.h>
+#include "Resampler.h"
+
+#if defined(__SSE__)
+    #include <xmmintrin.h>
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>
+#endif
+
+static const struct {
+    const char *    name;
+    unsigned int    taps;
+    double          rolloff;            // pass band, of the lower Nyquist frequency
+    double          beta;               // Kaiser window
+} presets[] = {
+    { "fast",   8,  0.80, 5.0 },
+    { "medium", 16, 0.88, 7.0 },
+    { "best",   32, 0.92, 9.0 },
+};
+
+static unsigned int gcd( unsigned int a, unsigned int b ) {
+    while ( b ) {
+        unsigned int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// modified Bessel function of the first kind, order 0
+static double bessel_i0( double x ) {
+    double sum = 1, term = 1;
+    for ( int k = 1; k < 50 && term > 1e-12 * sum; k++ ) {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+static inline float dot( const float * a, const float * b, unsigned int n ) {
+#if defined(__SSE__)
+    __m128 acc = _mm_setzero_ps();
+    for ( unsigned int i = 0; i < n; i += 4 )
+        acc = _mm_add_ps( acc, _mm_mul_ps( _mm_loadu_ps( a + i ), _mm_loadu_ps( b + i ) ) );
+    acc = _mm_add_ps( acc, _mm_movehl_ps( acc, acc ) );
+    acc = _mm_add_ss( acc, _mm_shuffle_ps( acc, acc, 1 ) );
+    return _mm_cvtss_f32( acc );
+#elif defined(__ARM_NEON)
+    float32x4_t acc = vdupq_n_f32( 0 );
+    for ( unsigned int i = 0; i < n; i += 4 )
+        acc = vmlaq_f32( acc, vld1q_f32( a + i ), vld1q_f32( b + i ) );
+    float32x2_t sum = vadd_f32( vget_low_f32( acc ), vget_high_f32( acc ) );
+    return vget_lane_f32( vpadd_f32( sum, sum ), 0 );
+#else
+    float acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+    for ( unsigned int i = 0; i < n; i += 4 ) {
+        acc0 += a[i] * b[i];
+        acc1 += a[i+1] * b[i+1];
+        acc2 += a[i+2] * b[i+2];
+        acc3 += a[i+3] * b[i+3];
+    }
+    return (acc0 + acc1) + (acc2 + acc3);
+#endif
+}
+
+Resampler::Resampler( unsigned int in_rate, unsigned int out_rate, Quality quality ) {
+    unsigned int g = gcd( in_rate, out_rate );
+    up = out_rate / g;
+    down = in_rate / g;
+    // a lower output rate needs a longer filter for the same transition band
+    taps = presets[ quality ].taps * ((down + up - 1) / up);
+
+    // prototype low pass at in_rate * up, cut off below the lower Nyquist
+    // frequency, with a gain of 'up' to make up for the inserted zeros; it is
+    // centred on length / 2, a whole number of input samples
+    unsigned int length = taps * up;
+    double cutoff = presets[ quality ].rolloff * 0.5 * (in_rate < out_rate ? in_rate : out_rate)
+                    / ((double) in_rate * up);
+    double beta = presets[ quality ].beta;
+    double * proto = new double[ length ];
+    double sum = 0;
+    for ( unsigned int n = 0; n < length; n++ ) {
+        double t = n - length / 2.0;
+        double x = 2 * cutoff * t;
+        double sinc = x == 0 ? 1 : sin( M_PI * x ) / (M_PI * x);
+        double r = 2.0 * n / length - 1;
+        double window = bessel_i0( beta * sqrt( r < 1 ? 1 - r * r : 0 ) ) / bessel_i0( beta );
+        proto[n] = 2 * cutoff * sinc * window;
+        sum += proto[n];
+    }
+
+    coefs = new float[ up * taps ];
+    for ( unsigned int p = 0; p < up; p++ )
+        for ( unsigned int k = 0; k < taps; k++ )
+            coefs[ p * taps + k ] = proto[ (taps - 1 - k) * up + p ] * up / sum;
+    delete[] proto;
+
+    history = new float[ taps - 1 + CHUNK ];
+    reset();
+}
+
+Resampler::~Resampler() {
+    delete[] coefs;
+    delete[] history;
+}
+
+bool Resampler::parseQuality( const char * name, Quality * quality ) {
+    for ( unsigned int i = 0; i < sizeof(presets) / sizeof(presets[0]); i++ ) {
+        if ( strcmp( name, presets[i].name ) == 0 ) {
+            *quality = (Quality) i;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Resampler::reset() {
+    memset( history, 0, (taps - 1) * sizeof(float) );
+    // the first output sample is centred on the first input sample
+    phase = 0;
+    skip = delay();
+}
+
+// most output samples process() can make from in_count input samples
+unsigned int Resampler::maxOutput( unsigned int in_count ) const {
+    return (unsigned long long) in_count * up / down + 2;
+}
+
+unsigned int Resampler::process( const short * in, unsigned int in_count, short * out ) {
+    unsigned int produced = 0;
+
+    while ( in_count > 0 ) {
+        unsigned int n = in_count < CHUNK ? in_count : CHUNK;
+        float * x = history + taps - 1;
+        for ( unsigned int i = 0; i < n; i++ )
+            x[i] = in[i];
+
+        // newest input sample of the next output sample
+        unsigned int newest = skip;
+        while ( newest < n ) {
+            float y = dot( coefs + phase * taps, x + newest - (taps - 1), taps );
+            y = y >= 0 ? y + 0.5f : y - 0.5f;
+            out[ produced++ ] = y > 32767 ? 32767 : y < -32768 ? -32768 : (short) y;
+
+            phase += down;
+            newest += phase / up;
+            phase %= up;
+        }
+        skip = newest - n;
+
+        memmove( history, history + n, (taps - 1) * sizeof(float) );
+        in += n;
+        in_count -= n;
+    }
+    return produced;
+}
+
+// the output still held back by the filter delay, out takes maxOutput( delay() )
+unsigned int Resampler::flush( short * out ) {
+    static const short zeros[ 64 ] = { 0 };
+    unsigned int produced = 0;
+
+    for ( unsigned int left = delay(); left > 0; ) {
+        unsigned int n = left < 64 ? left : 64;
+        produced += process( zeros, n, out + produced );
+        left -= n;
+    }
+    reset();
+    return produced;
+}
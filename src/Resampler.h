@@ -0,0 +1,46 @@
+#ifndef __Resampler__
+#define __Resampler__
+
+/*
+================================================
+Resampler
+
+polyphase FIR sample rate converter for the 16 kHz output of pico.
+The rates are reduced to a ratio up/down; every output sample is the dot
+product of one of 'up' filter phases with the latest input samples. The
+filter is a Kaiser windowed sinc, its length and stop band set by the
+quality preset.
+================================================
+*/
+class Resampler {
+public:
+    enum Quality {                      // taps a phase, times the rate reduction
+        FAST,                           // 8
+        MEDIUM,                         // 16
+        BEST                            // 32
+    };
+
+    Resampler( unsigned int in_rate, unsigned int out_rate, Quality quality = MEDIUM );
+    ~Resampler();
+
+    static bool parseQuality( const char * name, Quality * quality );
+
+    unsigned int maxOutput( unsigned int in_count ) const;
+    unsigned int process( const short * in, unsigned int in_count, short * out );
+    unsigned int flush( short * out );
+    unsigned int delay() const { return taps / 2; }     // in input samples
+    void reset();
+
+private:
+    unsigned int    up;
+    unsigned int    down;
+    unsigned int    taps;               // per phase, a multiple of 4
+    float *         coefs;              // [up][taps], each phase reversed
+
+    enum { CHUNK = 1024 };
+    float *         history;            // taps - 1 older samples, then the input
+    unsigned int    phase;              // of the next output sample, 0..up-1
+    unsigned int    skip;               // input samples to wait for before it
+};
+
+#endif // __Resampler__
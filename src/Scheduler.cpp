@@ -0,0 +1,194 @@
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "nanotts.h"
+#include "Trace.h"
+
+namespace nanotts {
+
+static double now_ms() {
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+static int compare_ms( const void * a, const void * b ) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return x < y ? -1 : x > y;
+}
+
+// the caller's sink, with the pauses of a batch text between sentences
+class Scheduler::Slot : public Sink {
+public:
+    Slot( Scheduler & scheduler, Priority priority, Sink & sink ) : scheduler( scheduler ), priority( priority ),
+        sink( sink ), paused_ms( 0 ) {}
+
+    void write( const short * samples, unsigned int count ) { sink.write( samples, count ); }
+    void sentence() {
+        sink.sentence();
+        if ( priority == BATCH )
+            paused_ms += scheduler.yield();
+    }
+    void mark( const Mark & m ) { sink.mark( m ); }
+
+    Scheduler &         scheduler;
+    Priority            priority;
+    Sink &              sink;
+    double              paused_ms;
+};
+//////////////////////////////////////////////////////////////////
+
+
+Scheduler::Scheduler( unsigned int _running, unsigned int interactive_limit, unsigned int batch_limit,
+                      const Engine::Options & options ) :
+    // every admitted text has an engine of its own, whatever the voices
+    pool( options, (interactive_limit ? interactive_limit : 1) + (batch_limit ? batch_limit : 1) ),
+    slots( _running ? _running : 1 ), running( 0 ) {
+    memset( classes, 0, sizeof(classes) );
+    classes[ INTERACTIVE ].limit = interactive_limit ? interactive_limit : 1;
+    classes[ BATCH ].limit = batch_limit ? batch_limit : 1;
+
+    pthread_mutex_init( &lock, 0 );
+    pthread_cond_init( &changed, 0 );
+}
+
+Scheduler::~Scheduler() {
+    pthread_cond_destroy( &changed );
+    pthread_mutex_destroy( &lock );
+}
+
+int Scheduler::synthesize( Priority priority, const char * voice, const char * text, const Params & params, Sink & sink ) {
+    return schedule( priority, voice, text, 0, params, sink );
+}
+
+int Scheduler::synthesizeFile( Priority priority, const char * voice, const char * filename, const Params & params, Sink & sink ) {
+    return schedule( priority, voice, 0, filename, params, sink );
+}
+
+int Scheduler::schedule( Priority priority, const char * voice, const char * text, const char * filename,
+                         const Params & params, Sink & sink ) {
+    double queued_ms = admit( priority );
+
+    Engine * engine = pool.acquire( voice );
+    if ( !engine ) {
+        pthread_mutex_lock( &lock );
+        classes[ priority ].admitted--;
+        pthread_cond_broadcast( &changed );
+        pthread_mutex_unlock( &lock );
+        return -1;
+    }
+
+    Slot slot( *this, priority, sink );
+    queued_ms += run( priority );
+    int res = filename ? engine->synthesizeFile( filename, params, slot ) : engine->synthesize( text, params, slot );
+    finish( priority, queued_ms + slot.paused_ms );
+
+    pool.release( engine );
+    return res;
+}
+
+// wait for the class to take another text
+double Scheduler::admit( Priority priority ) {
+    double start = now_ms();
+
+    pthread_mutex_lock( &lock );
+    while ( classes[ priority ].admitted >= classes[ priority ].limit )
+        pthread_cond_wait( &changed, &lock );
+    classes[ priority ].admitted++;
+    pthread_mutex_unlock( &lock );
+
+    return now_ms() - start;
+}
+
+// wait for a run slot; interactive texts go first
+double Scheduler::run( Priority priority ) {
+    double start = now_ms();
+
+    pthread_mutex_lock( &lock );
+    classes[ priority ].waiting++;
+    while ( running >= slots || (priority == BATCH && classes[ INTERACTIVE ].waiting > 0) )
+        pthread_cond_wait( &changed, &lock );
+    classes[ priority ].waiting--;
+    running++;
+    pthread_cond_broadcast( &changed );
+    pthread_mutex_unlock( &lock );
+
+    return now_ms() - start;
+}
+
+// a batch text between sentences: give the slot to a waiting interactive
+// text and wait for one again
+double Scheduler::yield() {
+    pthread_mutex_lock( &lock );
+    if ( classes[ INTERACTIVE ].waiting == 0 ) {
+        pthread_mutex_unlock( &lock );
+        return 0;
+    }
+    running--;
+    classes[ BATCH ].preempted++;
+    pthread_cond_broadcast( &changed );
+    pthread_mutex_unlock( &lock );
+
+    TraceScope trace( "paused" );
+    return run( BATCH );
+}
+
+void Scheduler::finish( Priority priority, double queued_ms ) {
+    class_t & c = classes[ priority ];
+
+    pthread_mutex_lock( &lock );
+    running--;
+    c.admitted--;
+    c.samples[ c.texts % SAMPLES ] = queued_ms;
+    c.texts++;
+    c.total_ms += queued_ms;
+    if ( queued_ms > c.max_ms )
+        c.max_ms = queued_ms;
+    pthread_cond_broadcast( &changed );
+    pthread_mutex_unlock( &lock );
+}
+
+Scheduler::Stats Scheduler::stats( Priority priority ) {
+    const class_t & c = classes[ priority ];
+    double sorted[ SAMPLES ];
+    Stats s;
+
+    pthread_mutex_lock( &lock );
+    unsigned int n = c.texts < SAMPLES ? c.texts : SAMPLES;
+    memcpy( sorted, c.samples, n * sizeof(double) );
+    s.texts = c.texts;
+    s.preempted = c.preempted;
+    s.mean_ms = c.texts ? c.total_ms / c.texts : 0;
+    s.max_ms = c.max_ms;
+    pthread_mutex_unlock( &lock );
+
+    // the percentiles are of the latest texts
+    qsort( sorted, n, sizeof(double), compare_ms );
+    s.p50_ms = n ? sorted[ n / 2 ] : 0;
+    s.p99_ms = n ? sorted[ (n * 99) / 100 ] : 0;
+    return s;
+}
+
+void Scheduler::printStats() {
+    static const char * names[ PRIORITIES ] = { "interactive", "batch" };
+
+    fprintf( stderr, "queue time:\n" );
+    for ( int p = 0; p < PRIORITIES; p++ ) {
+        Stats s = stats( (Priority) p );
+        fprintf( stderr, "  %-28s %9lu texts\n", names[p], s.texts );
+        if ( !s.texts )
+            continue;
+        fprintf( stderr, "    %-26s %9.3f ms\n", "mean", s.mean_ms );
+        fprintf( stderr, "    %-26s %9.3f ms\n", "p50", s.p50_ms );
+        fprintf( stderr, "    %-26s %9.3f ms\n", "p99", s.p99_ms );
+        fprintf( stderr, "    %-26s %9.3f ms\n", "max", s.max_ms );
+        if ( p == BATCH )
+            fprintf( stderr, "    %-26s %9lu times\n", "preempted", s.preempted );
+    }
+    pool.printStats();
+}
+
+}
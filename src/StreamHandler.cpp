@@ -14,7 +14,7 @@ StreamHandler::~StreamHandler() {
 
 int StreamHandler::StreamOpen() {
     if ( player ) {
-        player->StreamOpen();
+        return player->StreamOpen();
     }
     return 0;
 }
@@ -26,6 +26,13 @@ int StreamHandler::SubmitFrames( unsigned char * frames, unsigned int frame_coun
     return 0;
 }
 
+int StreamHandler::StreamDrop() {
+    if ( player ) {
+        player->StreamDrop();
+    }
+    return 0;
+}
+
 int StreamHandler::StreamClose() {
     if ( player ) {
         player->StreamClose();
@@ -12,6 +12,7 @@ public:
     virtual ~StreamHandler();
     virtual int StreamOpen();
     virtual int SubmitFrames( unsigned char * frames, unsigned int frame_count );
+    virtual int StreamDrop();
     virtual int StreamClose();
 };
 
@@ -0,0 +1,191 @@
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#include "svoxpico/picoapi.h"
+#include "svoxpico/picoextapi.h"
+
+#include "Trace.h"
+#include "nanotts.h"
+
+enum { RING_SIZE = 1 << 16 };           // events, a power of 2
+
+struct trace_event_t {
+    const char *        name;
+    unsigned long long  ns;
+    char                phase;          // B, E or i
+};
+
+struct trace_ring_t {
+    trace_ring_t *      next;
+    long                tid;
+    bool                exited;         // its thread ended, the ring goes to the next new thread
+    unsigned long       head;           // events recorded, the last RING_SIZE are kept
+    trace_event_t       events[ RING_SIZE ];
+};
+
+bool Trace::on = false;
+
+static char *               trace_filename;
+static unsigned long long   trace_start;
+static __thread trace_ring_t * ring;    // of this thread
+static trace_ring_t *       rings;
+static pthread_mutex_t      rings_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t        ring_key;   // marks the ring of a thread when it exits
+static pthread_once_t       ring_key_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t      write_lock = PTHREAD_MUTEX_INITIALIZER;
+static int                  wakeup[ 2 ];    // SIGUSR1 to the writer thread
+
+static unsigned long long now_ns() {
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+static void ring_exit( void * r ) {
+    pthread_mutex_lock( &rings_lock );
+    ((trace_ring_t *) r)->exited = true;
+    pthread_mutex_unlock( &rings_lock );
+}
+
+static void ring_key_create() {
+    pthread_key_create( &ring_key, ring_exit );
+}
+
+// the rings of exited threads are reused, so that threads coming and going
+// don't add up; the events of the exited thread are dropped then
+void Trace::record( const char * name, char phase ) {
+    if ( !ring ) {
+        trace_ring_t * r;
+
+        pthread_once( &ring_key_once, ring_key_create );
+        pthread_mutex_lock( &rings_lock );
+        for ( r = rings; r && !r->exited; r = r->next )
+            ;
+        if ( r ) {
+            r->exited = false;
+            r->head = 0;
+        } else if ( (r = (trace_ring_t *) calloc( 1, sizeof(trace_ring_t) )) ) {
+            r->next = rings;
+            rings = r;
+        }
+        if ( r )
+            r->tid = syscall( SYS_gettid );
+        pthread_mutex_unlock( &rings_lock );
+        if ( !r )
+            return;
+        pthread_setspecific( ring_key, r );
+        ring = r;
+    }
+
+    // the writer only reads events below head
+    unsigned long head = ring->head;
+    trace_event_t & e = ring->events[ head & (RING_SIZE - 1) ];
+    e.name = name;
+    e.ns = now_ns();
+    e.phase = phase;
+    __atomic_store_n( &ring->head, head + 1, __ATOMIC_RELEASE );
+}
+
+static void trace_step( const pico_Char * name, pico_Int16 begin ) {
+    if ( begin )
+        Trace::begin( (const char *) name );
+    else
+        Trace::end( (const char *) name );
+}
+
+static void trace_at_exit() {
+    Trace::write();
+}
+
+static void trace_on_signal( int ) {
+    char c = 0;
+    if ( ::write( wakeup[1], &c, 1 ) < 0 ) {
+        // the writer is busy, the trace is written anyway
+    }
+}
+
+static void * trace_writer( void * ) {
+    char c;
+    while ( read( wakeup[0], &c, 1 ) > 0 )
+        Trace::write();
+    return 0;
+}
+
+bool Trace::start( const char * filename ) {
+    if ( on )
+        return true;
+
+    trace_filename = strdup( filename );
+    trace_start = now_ns();
+
+    pthread_t writer;
+    if ( pipe( wakeup ) == 0 && pthread_create( &writer, 0, trace_writer, 0 ) == 0 ) {
+        pthread_detach( writer );
+        signal( SIGUSR1, trace_on_signal );
+    } else {
+        fprintf( stderr, "trace: no writing on SIGUSR1\n" );
+    }
+    atexit( trace_at_exit );
+
+    picoext_setStepTraceHook( trace_step );
+    on = true;
+    return true;
+}
+
+// the events so far as a JSON trace; events of a ring that wrapped around
+// while it is written may be missing or out of place
+int Trace::write() {
+    if ( !trace_filename )
+        return -1;
+
+    pthread_mutex_lock( &write_lock );
+    FILE * fp = fopen( trace_filename, "w" );
+    if ( !fp ) {
+        fprintf( stderr, "trace: cannot write \"%s\"\n", trace_filename );
+        pthread_mutex_unlock( &write_lock );
+        return -1;
+    }
+
+    unsigned long count = 0;
+    int pid = getpid();
+    fprintf( fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" );
+
+    pthread_mutex_lock( &rings_lock );
+    for ( trace_ring_t * r = rings; r; r = r->next ) {
+        unsigned long head = __atomic_load_n( &r->head, __ATOMIC_ACQUIRE );
+        for ( unsigned long i = head > RING_SIZE ? head - RING_SIZE : 0; i < head; i++ ) {
+            const trace_event_t & e = r->events[ i & (RING_SIZE - 1) ];
+            fprintf( fp, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%ld%s}",
+                     count++ ? "," : "", e.name, e.phase, (e.ns - trace_start) / 1000.0, pid, r->tid,
+                     e.phase == 'i' ? ",\"s\":\"t\"" : "" );
+        }
+    }
+    pthread_mutex_unlock( &rings_lock );
+
+    fprintf( fp, "\n]}\n" );
+    int res = fclose( fp ) == 0 ? 0 : -1;
+    fprintf( stderr, "trace: wrote \"%s\" (%lu events)\n", trace_filename, count );
+    pthread_mutex_unlock( &write_lock );
+    return res;
+}
+//////////////////////////////////////////////////////////////////
+
+
+namespace nanotts {
+
+bool startTrace( const char * filename ) {
+    return Trace::start( filename );
+}
+
+int writeTrace() {
+    return Trace::write();
+}
+
+}
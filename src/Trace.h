@@ -0,0 +1,44 @@
+#ifndef __Trace__
+#define __Trace__
+
+/*
+================================================
+Trace
+
+timeline of the synthesis, for chrome://tracing or Perfetto. Every thread
+records begin and end events into a ring of its own, the last 64k events,
+without locks; write() turns all rings into a JSON trace. The ring of a
+thread that exited goes to the next new thread, so memory grows with the
+threads running at once, not with all threads ever. Tracing is off
+unless start() was called, an event is then a flag test.
+
+The steps of the processing units come from svoxpico, through
+picoext_setStepTraceHook(). Names are static strings, they are kept as
+pointers.
+================================================
+*/
+class Trace {
+public:
+    // written to filename at exit and on SIGUSR1
+    static bool start( const char * filename );
+    static int write();
+
+    static void begin( const char * name ) { if ( on ) record( name, 'B' ); }
+    static void end( const char * name ) { if ( on ) record( name, 'E' ); }
+    static void instant( const char * name ) { if ( on ) record( name, 'i' ); }
+
+private:
+    static bool on;
+    static void record( const char * name, char phase );
+};
+
+// a span over a scope
+class TraceScope {
+public:
+    TraceScope( const char * _name ) : name( _name ) { Trace::begin( name ); }
+    ~TraceScope() { Trace::end( name ); }
+private:
+    const char *    name;
+};
+
+#endif // __Trace__
@@ -23,21 +23,21 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <ctype.h>
 
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <sys/mman.h> // mmap
+#include <sys/utsname.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
 
-extern "C" {
-#include "svoxpico/picoapi.h"
-#include "svoxpico/picoapid.h"
-#include "svoxpico/picoos.h"
-}
-
-#include "PicoVoices.h"
-#include "mmfile.h"
+#include "nanotts.h"
 #include "StreamHandler.h"
+#include "Encoder.h"
 
 #ifdef _USE_ALSA
   #include "Player_Alsa.h"
@@ -47,17 +47,6 @@ extern "C" {
 #define PICO_DEFAULT_PITCH 1.05f
 #define PICO_DEFAULT_VOLUME 1.00f
 
-/* string-ify a macro */
-#define STRR(X) #X
-#define STR(X) STRR(X)
-
-#ifndef PICO_ROOT
-#define PICO_ROOT /usr
-#endif
-
-// searching these paths
-const char * lingware_paths[ 2 ] = { "./lang", STR(PICO_ROOT) "/share/pico/lang" };
-
 #define FILE_OUTPUT_PREFIX "nanotts-output-"
 #define FILE_OUTPUT_SUFFIX ".wav"
 #define FILENAME_NUMBERING_LEADING_ZEROS 4
@@ -88,11 +77,12 @@ class Nano;
 ================================================
 Listener
 
-stream class, for exchanging byte-streams between producer/consumer
+stream class, for exchanging byte-streams between producer/consumer;
+the sink the engine speaks into
 ================================================
 */
 template <typename type>
-class Listener {
+class Listener : public nanotts::Sink {
     type * data;
     unsigned int read_p;
     void (Nano::*consume)( short *, unsigned int );
@@ -106,6 +96,8 @@ public:
     }
 
     void writeData( type * data, unsigned int byte_size );
+    void write( const short * samples, unsigned int count ) { writeData( const_cast<type*>( samples ), count ); }
+    void mark( const nanotts::Mark & m );
     void setCallback( void (Nano::*con_f)( short *, unsigned int ), Nano* =0 ) ;
     bool hasConsumer();
 };
@@ -132,121 +124,6 @@ bool Listener<type>::hasConsumer() {
 //////////////////////////////////////////////////////////////////
 
 
-struct pads_t {
-    const char * name;
-    const char * ofmt;
-    const char * cfmt;
-    float * val;
-};
-
-/*
-================================================
-Boilerplate
-
-adds padding text around input to set various parameters in pico
-================================================
-*/
-class Boilerplate {
-    char plate_begin[100];
-    char plate_end[50];
-
-    float speed;
-    float pitch;
-    float volume;
-
-    const unsigned int padslen;
-
-    void setOne( const char * verb, float value ) {
-        char buf[100];
-
-        // find the parm and set it
-        for ( unsigned int i = 0; i < padslen; i++ ) {
-            if ( strcmp( pads[i].name, verb ) == 0 ) {
-                *(pads[i].val) = value;
-                break;
-            }
-        }
-
-        // rebuild the plates
-        memset( plate_begin, 0, 100 );
-        memset( plate_end, 0, 50 );
-        for ( unsigned int i = 0; i < padslen; i++ ) {
-            if ( *(pads[i].val) != -1 ) {
-                // begin plate
-                int ivalue = ceilf( *(pads[i].val) * 100.0f );
-                sprintf( buf, pads[i].ofmt, ivalue );
-                strcat( plate_begin, buf );
-                // end plate := reverse order to match tag order
-                strcpy( buf, plate_end );
-                sprintf( plate_end, "%s%s", pads[i].cfmt, buf );
-                // </volume></pitch></speed>
-            }
-        }
-    }
-
-public:
-    static pads_t pads[];
-
-    Boilerplate() : padslen(3) {
-        speed   = -1.0f;
-        pitch   = -1.0f;
-        volume  = -1.0f;
-
-        memset( plate_begin, 0, 100 );
-        memset( plate_end, 0, 50 );
-
-        pads[0].val = &speed;
-        pads[1].val = &pitch;
-        pads[2].val = &volume;
-    }
-
-    Boilerplate( float s, float p, float v ) : padslen(3) {
-        setSpeed( s );
-        setPitch( p );
-        setVolume( v );
-    }
-
-    bool isChanged() {
-        return !((speed == -1.0f) && (pitch == -1.0f) && (volume == -1.0f));
-    }
-
-    char * getOpener(unsigned int * l) { *l = strlen(plate_begin); return plate_begin; }
-    char * getCloser(unsigned int * l) { *l = strlen(plate_end); return plate_end; }
-
-    void setSpeed( float f ) {
-        setOne( "speed", f );
-    }
-    void setPitch( float f ) {
-        setOne( "pitch", f );
-    }
-    void setVolume( float f ) {
-        setOne( "volume", f );
-    }
-
-    const char * getStatusMessage() {
-        static char buf[100];
-        memset(buf, 0, 100);
-        char tmp[40];
-
-        for ( unsigned int i = 0; i < padslen; i++ ) {
-            if ( *(pads[i].val) != -1 ) {
-                pads_t * p = &pads[i];
-                sprintf( tmp, "%s: %.2f\n", p->name, *p->val );
-                strcat( buf, tmp );
-            }
-        }
-        return buf;
-    }
-};
-
-pads_t Boilerplate::pads[] = {
-    {"speed",   "<speed level=\"%d\">",     "</speed>",     0},
-    {"pitch",   "<pitch level=\"%d\">",     "</pitch>",     0},
-    {"volume",  "<volume level=\"%d\">",    "</volume>",    0}
-};
-
-
-
 /*
 ================================================
     Nano
@@ -294,17 +171,35 @@ private:
     char *              copy_arg( int );
 
     unsigned char *     input_buffer;
-    unsigned int        input_size;
-
-    mmfile_t *          mmfile;
+    size_t              input_size;
 
     Listener<short>     listener;
     void                write_short_to_stdout( short *, unsigned int );
     void                write_short_to_playback( short * data, unsigned int shorts );
     void                write_short_to_playback_and_stdout( short * data, unsigned int shorts );
 
-    Boilerplate         modifiers;
+    nanotts::Params     params;             // --speed, --pitch, --volume, --rate
     StreamHandler       streamHandler;
+    PlaybackOptions     playback;           // --device, --latency, ...
+
+    char *              codec;              // --codec, 0 for the default
+    Encoder *           file_encoder;
+    Encoder *           stdout_encoder;
+    FILE *              encoded_fp;
+    const char *        fileCodec();
+
+    bool                print_stats;
+    char *              trace_file;
+    char *              marks_file;         // --marks
+    FILE *              marks_fp;
+    bool                lazy_init;
+    bool                expand_pdfs;
+    char *              save_image;
+    char *              load_image;
+    bool                compile_lingware;
+    bool                compile_all;
+    unsigned int        mem_size;
+    bool                tune_mem;
 
 public:
     bool                silence_output;
@@ -317,25 +212,42 @@ public:
     int setup_input_output();
     int verify_input_output();
 
-    int ProduceInput( unsigned char ** data, unsigned int * bytes );
+    int ProduceInput( unsigned char ** data, size_t * bytes );
+    const char * inputFile() const { return in_mode == IN_SINGLE_FILE ? in_filename : 0; }
     int playOutput();
 
     const char * getVoice();
     const char * getLangFilePath();
 
-    const char * outFilename() const { return out_filename; }
-
-    Listener<short> * getListener() ;
-
-    Boilerplate * getModifiers() ;
+    nanotts::Sink & getSink() { return listener; }
+    const nanotts::Params & getParams() const { return params; }
 
     void SetListenerStdout();
-    void SetListenerPlayback();
-    void SetListenerPlaybackAndStdout();
-
-    bool writingWaveFile() { return (out_mode & OUT_SINGLE_FILE)==OUT_SINGLE_FILE; }
+    int SetListenerPlayback();
+    int SetListenerPlaybackAndStdout();
+    void DropPlayback();
+    int FinishOutput();
+    void writeMark( const nanotts::Mark & mark );
+
+    bool printStats() const { return print_stats; }
+    const char * traceFile() const { return trace_file; }
+    bool lazyInit() const { return lazy_init; }
+    bool expandPdfs() const { return expand_pdfs; }
+    const char * saveImage() const { return save_image; }
+    const char * loadImage() const { return load_image; }
+    bool imageOnly() const { return save_image && out_mode == OUT_NOT_SET; }
+    bool compileLingware() const { return compile_lingware; }
+    bool compileAllVoices() const { return compile_all; }
+    unsigned int memSize() const { return mem_size; }
+    bool tuneMem() const { return tune_mem; }
 };
 
+template <typename type>
+void Listener<type>::mark( const nanotts::Mark & m ) {
+    if ( nano_class )
+        nano_class->writeMark( m );
+}
+
 Nano::Nano( const int i, const char ** v ) : my_argc(i), my_argv(v), listener(this) {
     voice = 0;
     langfiledir = 0;
@@ -349,6 +261,24 @@ Nano::Nano( const int i, const char ** v ) : my_argc(i), my_argv(v), listener(th
     input_buffer = 0;
     input_size = 0;
 
+    print_stats = false;
+    trace_file = 0;
+    marks_file = 0;
+    marks_fp = 0;
+    lazy_init = false;
+    expand_pdfs = false;
+    save_image = 0;
+    load_image = 0;
+    compile_lingware = false;
+    compile_all = false;
+    mem_size = 0;
+    tune_mem = false;
+
+    codec = 0;
+    file_encoder = 0;
+    stdout_encoder = 0;
+    encoded_fp = 0;
+
     silence_output = true;
 }
 
@@ -363,18 +293,21 @@ Nano::~Nano() {
         delete[] in_filename;
     if ( words )
         delete[] words;
+    if ( save_image )
+        delete[] save_image;
+    if ( load_image )
+        delete[] load_image;
+    if ( trace_file )
+        delete[] trace_file;
+    if ( marks_file )
+        delete[] marks_file;
+
+    FinishOutput();
+    if ( codec )
+        delete[] codec;
 
     if ( input_buffer ) {
-        switch ( in_mode ) {
-        case IN_STDIN:
-            delete[] input_buffer;
-            break;
-        case IN_SINGLE_FILE:
-            delete mmfile;
-            mmfile = 0;
-        default:
-            break;
-        }
+        free( input_buffer );
         input_buffer = 0;
     }
 
@@ -423,13 +356,35 @@ void Nano::PrintUsage() {
         { "   -w, --wav ", "Write output to WAV file, will generate filename if '-o' option not provided" },
         { "   -p, --play ", "Play audio output" },
         { "   -m, --no-play", "do NOT play output on PC's soundcard" },
+        { "   --device <pcm>", "ALSA device to play on, eg. hw:0 or null (Default: default)" },
+        { "   --latency <profile>", "Playback buffering: low (20 ms), normal (50 ms) or robust (250 ms)" },
+        { "   --period <ms>", "Playback period, overrides --latency" },
+        { "   --buffer <ms>", "Playback buffer, overrides --latency" },
+        { "   --no-mmap", "Write to the device instead of into its buffer" },
         { "   -c ", "Send raw PCM output to stdout" },
+        { "   --codec <codec>", "Encode file and stdout output: pcm, ulaw, alaw, adpcm or flac" },
+        { "", "(Default: pcm; '-o name.flac' selects flac)" },
+        { "   --rate <hz>", "Sample rate of the output, eg. 8000, 22050, 44100 or 48000 (Default: 16000)" },
+        { "   --resample-quality", "Resampling filter: fast, medium or best (Default: medium)" },
         { "   --prefix", "Set the file prefix (eg. \"MyRecording-\")." },
         { "", "Generated files will be auto-numbered." },
         { "", "Good for running multiple times with different inputs" },
         { "   --speed <0.2-5.0>", "change voice speed" },
         { "   --pitch <0.5-2.0>", "change voice pitch" },
         { "   --volume <0.0-5.0>", "change voice volume (>1.0 may result in degraded quality)" },
+        { "   --stats", "Print a startup and synthesis time breakdown to stderr" },
+        { "   --trace <file>", "Write a Chrome trace of the synthesis at exit and on SIGUSR1" },
+        { "   --marks <file>", "Write the timing of the text, words and phones as JSON lines" },
+        { "   --lazy-init", "Construct processing units when the first text reaches them" },
+        { "   --expand-pdfs", "Expand the voice's pdfs when loading: faster, for about 2 MB more memory" },
+        { "   --save-image <file>", "Write the initialized engine to an image file (no input needed)" },
+        { "   --load-image <file>", "Start from an image file instead of loading the Lingware" },
+        { "   --compile-lingware", "Write the Lingware cache for all voices (or the one given with -v)" },
+        { "", "A current cache in ~/" CONFIG_DIR_NAME "/ is used automatically" },
+        { "   --mem-size <size>", "Size of the engine memory, eg. 2M or 1800k (Default: 2500000 bytes)" },
+        { "   --tune-mem", "Measure the memory while speaking the input, save the size for the voice" },
+        { "", "The input is the calibration text, the engine's peak is reached on creation" },
+        { "", "A size saved in ~/" CONFIG_DIR_NAME "/ is used unless --mem-size is given" },
         { "   --version", "Displays version information about this program" },
 //        { "  --files", "set multiple input files" },
         { " ", " " },
@@ -478,10 +433,6 @@ int Nano::parse_commandline_arguments()
     }                                   \
 }while(0)
 
-    if ( ! isatty(fileno(stdin)) ) {
-        in_mode = IN_STDIN;
-    }
-
     for ( int i = 1; i < my_argc; i++ )
     {
         // PRINT HELP
@@ -550,6 +501,39 @@ int Nano::parse_commandline_arguments()
             WARN_UNMATCHED_INPUTS();
             out_mode |= OUT_STDOUT;
         }
+        else if ( strcmp( my_argv[i], "--codec" ) == 0 ) {
+            WARN_UNMATCHED_INPUTS();
+            if ( (codec = copy_arg( i + 1 )) == 0 )
+                return -1;
+            if ( !Encoder::known( codec ) ) {
+                fprintf( stderr, " **error: unknown codec: %s (use one of: %s)\n\n", codec, Encoder::names() );
+                return -1;
+            }
+            ++i;
+        }
+        else if ( strcmp( my_argv[i], "--rate" ) == 0 ) {
+            WARN_UNMATCHED_INPUTS();
+            if ( i + 1 >= my_argc )
+                return -1;
+            char * end;
+            long hz = strtol( my_argv[i+1], &end, 10 );
+            if ( *end || hz < 4000 || hz > 192000 ) {
+                fprintf( stderr, " **error: invalid sample rate: %s (use 4000 to 192000)\n\n", my_argv[i+1] );
+                return -1;
+            }
+            params.rate = (unsigned int) hz;
+            ++i;
+        }
+        else if ( strcmp( my_argv[i], "--resample-quality" ) == 0 ) {
+            WARN_UNMATCHED_INPUTS();
+            if ( i + 1 >= my_argc )
+                return -1;
+            if ( !nanotts::parseResampleQuality( my_argv[i+1], &params.quality ) ) {
+                fprintf( stderr, " **error: unknown resample quality: %s (use fast, medium or best)\n\n", my_argv[i+1] );
+                return -1;
+            }
+            ++i;
+        }
         else if ( strcmp( my_argv[i], "-w" ) == 0 || strcmp( my_argv[i], "--wav" ) == 0 ) {
             WARN_UNMATCHED_INPUTS();
             out_mode |= OUT_SINGLE_FILE;
@@ -564,6 +548,42 @@ int Nano::parse_commandline_arguments()
             silence_output = false;
             out_mode |= OUT_PLAYBACK;
         }
+        else if ( strcmp( my_argv[i], "--device" ) == 0 ) {
+            WARN_UNMATCHED_INPUTS();
+            if ( i + 1 >= my_argc )
+                return -1;
+            playback.device = my_argv[i+1];
+            ++i;
+        }
+        else if ( strcmp( my_argv[i], "--latency" ) == 0 ) {
+            WARN_UNMATCHED_INPUTS();
+            if ( i + 1 >= my_argc )
+                return -1;
+            if ( !playback.setLatency( my_argv[i+1] ) ) {
+                fprintf( stderr, " **error: unknown latency: %s (use low, normal or robust)\n\n", my_argv[i+1] );
+                return -1;
+            }
+            ++i;
+        }
+        else if ( strcmp( my_argv[i], "--period" ) == 0 || strcmp( my_argv[i], "--buffer" ) == 0 ) {
+            WARN_UNMATCHED_INPUTS();
+            if ( i + 1 >= my_argc )
+                return -1;
+            double ms = strtod( my_argv[i+1], 0 );
+            if ( ms < 1 || ms > 2000 ) {
+                fprintf( stderr, " **error: invalid %s: %s (use 1 to 2000 ms)\n\n", my_argv[i] + 2, my_argv[i+1] );
+                return -1;
+            }
+            if ( my_argv[i][2] == 'p' )
+                playback.period_us = (unsigned int) (ms * 1000);
+            else
+                playback.buffer_us = (unsigned int) (ms * 1000);
+            ++i;
+        }
+        else if ( strcmp( my_argv[i], "--no-mmap" ) == 0 ) {
+            WARN_UNMATCHED_INPUTS();
+            playback.mmap = false;
+        }
         else if ( strcmp( my_argv[i], "--prefix" ) == 0 ) {
             WARN_UNMATCHED_INPUTS();
             out_mode |= OUT_SINGLE_FILE;
@@ -593,24 +613,93 @@ int Nano::parse_commandline_arguments()
             WARN_UNMATCHED_INPUTS();
             if ( i + 1 >= my_argc )
                 return -1;
-            modifiers.setSpeed( strtof(my_argv[i+1], 0) );
+            params.speed = strtof(my_argv[i+1], 0);
             ++i;
         }
         else if ( strcmp( my_argv[i], "--pitch" ) == 0 ) {
             WARN_UNMATCHED_INPUTS();
             if ( i + 1 >= my_argc )
                 return -1;
-            modifiers.setPitch( strtof(my_argv[i+1], 0) );
+            params.pitch = strtof(my_argv[i+1], 0);
             ++i;
         }
         else if ( strcmp( my_argv[i], "--volume" ) == 0 ) {
             WARN_UNMATCHED_INPUTS();
             if ( i + 1 >= my_argc )
                 return -1;
-            modifiers.setVolume( strtof(my_argv[i+1], 0) );
+            params.volume = strtof(my_argv[i+1], 0);
             ++i;
         }
 
+        // DIAGNOSTICS
+        else if ( strcmp( my_argv[i], "--stats" ) == 0 ) {
+            WARN_UNMATCHED_INPUTS();
+            print_stats = true;
+            playback.print_stats = true;
+        }
+        else if ( strcmp( my_argv[i], "--trace" ) == 0 ) {
+            WARN_UNMATCHED_INPUTS();
+            if ( (trace_file = copy_arg( i + 1 )) == 0 )
+                return -1;
+            ++i;
+        }
+        else if ( strcmp( my_argv[i], "--marks" ) == 0 ) {
+            WARN_UNMATCHED_INPUTS();
+            if ( (marks_file = copy_arg( i + 1 )) == 0 )
+                return -1;
+            params.marks = true;
+            ++i;
+        }
+        else if ( strcmp( my_argv[i], "--lazy-init" ) == 0 ) {
+            WARN_UNMATCHED_INPUTS();
+            lazy_init = true;
+        }
+        else if ( strcmp( my_argv[i], "--expand-pdfs" ) == 0 ) {
+            WARN_UNMATCHED_INPUTS();
+            expand_pdfs = true;
+        }
+
+        // ENGINE IMAGE
+        else if ( strcmp( my_argv[i], "--save-image" ) == 0 ) {
+            WARN_UNMATCHED_INPUTS();
+            if ( (save_image = copy_arg( i + 1 )) == 0 )
+                return -1;
+            ++i;
+        }
+        else if ( strcmp( my_argv[i], "--load-image" ) == 0 ) {
+            WARN_UNMATCHED_INPUTS();
+            if ( (load_image = copy_arg( i + 1 )) == 0 )
+                return -1;
+            ++i;
+        }
+        else if ( strcmp( my_argv[i], "--compile-lingware" ) == 0 ) {
+            WARN_UNMATCHED_INPUTS();
+            compile_lingware = true;
+        }
+
+        // MEMORY
+        else if ( strcmp( my_argv[i], "--mem-size" ) == 0 ) {
+            WARN_UNMATCHED_INPUTS();
+            if ( i + 1 >= my_argc )
+                return -1;
+            char * unit;
+            double size = strtod( my_argv[i+1], &unit );
+            if ( *unit == 'k' || *unit == 'K' )
+                size *= 1000;
+            else if ( *unit == 'm' || *unit == 'M' )
+                size *= 1000000;
+            if ( size <= 0 || size > 0x7fffffff ) {
+                fprintf( stderr, " **error: invalid memory size: %s\n\n", my_argv[i+1] );
+                return -1;
+            }
+            mem_size = (unsigned int) size;
+            ++i;
+        }
+        else if ( strcmp( my_argv[i], "--tune-mem" ) == 0 ) {
+            WARN_UNMATCHED_INPUTS();
+            tune_mem = true;
+        }
+
         // doesn't match any expected arguments; therefor try to speak it
         else {
             if ( in_mode != IN_NOT_SET && in_mode != IN_CMDLINE_TRAILING ) {
@@ -625,36 +714,27 @@ int Nano::parse_commandline_arguments()
         }
     }
 
+    // a pipe on stdin is the input, unless another one was given; scripts
+    // run with a stdin that isn't a terminal
+    if ( in_mode == IN_NOT_SET && ! isatty(fileno(stdin)) ) {
+        in_mode = IN_STDIN;
+    }
+
     if ( verify_input_output() < 0 ) {
         return -3;
     }
 
     // DEFAULTS
+    compile_all = compile_lingware && !voice;
     if ( !voice ) {
         voice = new char[6];
         strcpy( voice, "en-GB" );
     }
 
     if ( !langfiledir ) {
-        const char * path_p = 0;
-        char test_file[ 128 ];
-        for ( unsigned int i = 0; i < sizeof(lingware_paths)/sizeof(lingware_paths[0]); ++i ) {
-            sprintf( test_file, "%s/%s", lingware_paths[i], "en-GB_ta.bin" );
-            struct stat ss;
-            if ( -1 != stat( lingware_paths[i], &ss ) ) {
-                if ( S_ISDIR( ss.st_mode ) ) {
-                    if ( -1 != stat( test_file, &ss ) ) {
-                        if ( S_ISREG( ss.st_mode ) ) {
-                            path_p = lingware_paths[i];
-                            break;
-                        }
-                    }
-                }
-            }
-        }
-
+        const char * path_p = nanotts::defaultLingwareDir();
         if ( !path_p ) {
-            fprintf( stderr, " **error: Lang file path not found. Looking in: %s, %s\n\n", lingware_paths[0], lingware_paths[1] );
+            fprintf( stderr, " **error: Lang file path not found\n\n" );
             return -8;
         }
 
@@ -664,6 +744,8 @@ int Nano::parse_commandline_arguments()
     }
 
     if ( !out_filename ) {
+        if ( codec )
+            strcpy( suffix, Encoder::suffix( codec ) );
         int tmpsize = 100;
         out_filename = new char[ tmpsize ];
         memset( out_filename, 0, tmpsize );
@@ -705,6 +787,9 @@ int Nano::setup_input_output()
     case IN_CMDLINE_ARG:
     case IN_CMDLINE_TRAILING:
         break;
+    case IN_NOT_SET:
+        // only writing an engine image
+        break;
     case IN_MULTIPLE_FILES:
         __NOT_IMPL__
     default:
@@ -717,12 +802,24 @@ int Nano::setup_input_output()
         int test_mode = modes[i] & out_mode;
         switch ( test_mode ) {
         case OUT_SINGLE_FILE:
+            if ( !(encoded_fp = fopen( out_filename, "wb" )) ) {
+                fprintf( stderr, " **error: cannot open output file: %s\n\n", out_filename );
+                return -1;
+            }
+            file_encoder = Encoder::create( fileCodec(), encoded_fp, params.rate );
+            if ( file_encoder->start() < 0 )
+                return -1;
             break;
         case OUT_PLAYBACK:
             break;
         case OUT_STDOUT:
             out_fp = stdout;
-            fprintf( stderr, "writing pcm stream to stdout\n" );
+            if ( codec && strcmp( codec, "pcm" ) != 0 ) {
+                stdout_encoder = Encoder::create( codec, out_fp, params.rate );
+                if ( stdout_encoder->start() < 0 )
+                    return -1;
+            }
+            fprintf( stderr, "writing %s stream to stdout\n", codec ? codec : "pcm" );
             break;
         case OUT_MULTIPLE_FILES:
             __NOT_IMPL__
@@ -732,11 +829,20 @@ int Nano::setup_input_output()
         }
     }
 
-    if ( (out_mode & (OUT_PLAYBACK|OUT_STDOUT)) == (OUT_PLAYBACK|OUT_STDOUT) ) {
-        SetListenerPlaybackAndStdout();
+    if ( marks_file && !(marks_fp = fopen( marks_file, "w" )) ) {
+        fprintf( stderr, " **error: cannot open marks file: %s\n\n", marks_file );
+        return -1;
+    }
+
+    // an encoded file takes the samples along with stdout
+    bool to_stdout = (out_mode & OUT_STDOUT) || file_encoder;
+    if ( (out_mode & OUT_PLAYBACK) && to_stdout ) {
+        if ( SetListenerPlaybackAndStdout() < 0 )
+            return -1;
     } else if ( out_mode & OUT_PLAYBACK ) {
-        SetListenerPlayback();
-    } else if ( out_mode & OUT_STDOUT ) {
+        if ( SetListenerPlayback() < 0 )
+            return -1;
+    } else if ( to_stdout ) {
         SetListenerStdout();
     }
 
@@ -745,6 +851,11 @@ int Nano::setup_input_output()
 }
 
 int Nano::verify_input_output() {
+    // only writing an engine image, or the Lingware cache
+    if ( (save_image && out_mode == OUT_NOT_SET) || compile_lingware ) {
+        return 0;
+    }
+
     if ( in_mode == IN_NOT_SET ) {
         fprintf( stderr, " **error: no input\n\n" );
         return -1;
@@ -761,45 +872,76 @@ int Nano::verify_input_output() {
 void Nano::SetListenerStdout() {
     listener.setCallback( &Nano::write_short_to_stdout );
 }
-void Nano::SetListenerPlayback() {
+int Nano::SetListenerPlayback() {
 #ifdef _USE_ALSA
-    streamHandler.player = new Player_Alsa();
+    streamHandler.player = new Player_Alsa( params.rate, playback );
 #endif
-    streamHandler.StreamOpen();
+    if ( streamHandler.StreamOpen() < 0 )
+        return -1;
     listener.setCallback( &Nano::write_short_to_playback );
+    return 0;
 }
-void Nano::SetListenerPlaybackAndStdout() {
+int Nano::SetListenerPlaybackAndStdout() {
 #ifdef _USE_ALSA
-    streamHandler.player = new Player_Alsa();
+    streamHandler.player = new Player_Alsa( params.rate, playback );
 #endif
-    streamHandler.StreamOpen();
+    if ( streamHandler.StreamOpen() < 0 )
+        return -1;
     listener.setCallback( &Nano::write_short_to_playback_and_stdout );
+    return 0;
+}
+// drop what is queued for the soundcard, after the speech was cancelled
+void Nano::DropPlayback() {
+    if ( out_mode & OUT_PLAYBACK )
+        streamHandler.StreamDrop();
 }
 
-// puts input into *data, and number_bytes into bytes
+// puts input into *data, and number_bytes into bytes. The text is not
+// terminated, Pico::process() sends the final '\0' itself
 // returns 0 on no more data
-int Nano::ProduceInput( unsigned char ** data, unsigned int * bytes )
+int Nano::ProduceInput( unsigned char ** data, size_t * bytes )
 {
+    size_t capacity = 1000000;
+
     switch( in_mode ) {
     case IN_STDIN:
-        input_buffer = new unsigned char[ 1000000 ];
-        memset( input_buffer, 0, 1000000 );
-        input_size = fread( input_buffer, 1, 1000000, stdin );
+        // read all of stdin, growing the buffer as needed
+        input_buffer = (unsigned char *) malloc( capacity );
+        input_size = 0;
+        while ( input_buffer ) {
+            input_size += fread( input_buffer + input_size, 1, capacity - input_size, stdin );
+            if ( input_size < capacity )
+                break;
+            capacity *= 2;
+            unsigned char * grown = (unsigned char *) realloc( input_buffer, capacity );
+            if ( !grown )
+                free( input_buffer );
+            input_buffer = grown;
+        }
+        if ( !input_buffer ) {
+            fprintf( stderr, "out of memory reading stdin\n" );
+            return -1;
+        }
         *data = input_buffer;
-        *bytes = input_size + 1;    /* pico expects 1 for terminating '\0' */
-        fprintf( stderr, "read: %u bytes from stdin\n", input_size );
+        *bytes = input_size;
+        fprintf( stderr, "read: %zu bytes from stdin\n", input_size );
         break;
     case IN_SINGLE_FILE:
-        mmfile = new mmfile_t( in_filename );
-        *data = mmfile->data;
-        *bytes = mmfile->size + 1;  /* 1 additional for terminating '\0' */
-        fprintf( stderr, "read: %u bytes from \"%s\"\n", mmfile->size, in_filename );
+        // the engine maps it a window at a time while it is spoken
+        struct stat ss;
+        if ( -1 == stat( in_filename, &ss ) || access( in_filename, R_OK ) ) {
+            fprintf( stderr, "cannot read \"%s\"\n", in_filename );
+            return -1;
+        }
+        *data = 0;
+        *bytes = ss.st_size;
+        fprintf( stderr, "read: %zu bytes from \"%s\"\n", (size_t) ss.st_size, in_filename );
         break;
     case IN_CMDLINE_ARG:
     case IN_CMDLINE_TRAILING:
         *data = (unsigned char *)words;
-        *bytes = strlen(words) + 1; /* 1 additional for terminating '\0' */
-        fprintf( stderr, "read: %u bytes from command line\n", *bytes );
+        *bytes = strlen(words);
+        fprintf( stderr, "read: %zu bytes from command line\n", *bytes );
         break;
     case IN_MULTIPLE_FILES:
         fprintf( stderr, "multiple files not supported\n" );
@@ -830,8 +972,12 @@ const char * Nano::getLangFilePath() {
 }
 
 void Nano::write_short_to_stdout( short * data, unsigned int shorts ) {
-    if ( out_mode & OUT_STDOUT )
+    if ( stdout_encoder )
+        stdout_encoder->submit( data, shorts );
+    else if ( out_mode & OUT_STDOUT )
         fwrite( data, 2, shorts, out_fp );
+    if ( file_encoder )
+        file_encoder->submit( data, shorts );
 }
 
 void Nano::write_short_to_playback( short * data, unsigned int shorts ) {
@@ -840,22 +986,73 @@ void Nano::write_short_to_playback( short * data, unsigned int shorts ) {
 }
 
 void Nano::write_short_to_playback_and_stdout( short * data, unsigned int shorts ) {
-    if ( out_mode & OUT_STDOUT )
-        fwrite( data, 2, shorts, out_fp );
+    write_short_to_stdout( data, shorts );
     if ( out_mode & OUT_PLAYBACK )
         streamHandler.SubmitFrames( (unsigned char*)data, shorts );
 }
 
-Listener<short> * Nano::getListener() {
-    if ( !listener.hasConsumer() )
-        return 0;
-    return &listener;
+// the codec of the output file: --codec, else what its name says
+const char * Nano::fileCodec() {
+    if ( codec )
+        return codec;
+    const char * implied = Encoder::codecForFilename( out_filename );
+    return implied ? implied : "pcm";
 }
 
-Boilerplate * Nano::getModifiers() {
-    if ( modifiers.isChanged() )
-        return &modifiers;
-    return 0;
+// let the encoders write what they have queued, and complete their output
+int Nano::FinishOutput() {
+    int res = 0;
+
+    if ( stdout_encoder ) {
+        res |= stdout_encoder->finish();
+        delete stdout_encoder;
+        stdout_encoder = 0;
+    }
+    if ( file_encoder ) {
+        res |= file_encoder->finish();
+        if ( strcmp( fileCodec(), "pcm" ) == 0 )
+            fprintf( stderr, "wrote \"%s\" (%zu bytes)\n", out_filename, file_encoder->bytesWritten() );
+        else
+            fprintf( stderr, "wrote \"%s\" (%zu bytes, %s)\n", out_filename, file_encoder->bytesWritten(), fileCodec() );
+        delete file_encoder;
+        file_encoder = 0;
+    }
+    if ( encoded_fp ) {
+        fclose( encoded_fp );
+        encoded_fp = 0;
+    }
+    if ( marks_fp ) {
+        fclose( marks_fp );
+        marks_fp = 0;
+    }
+    return res;
+}
+
+// --marks: a JSON object per line, as the marks come
+void Nano::writeMark( const nanotts::Mark & mark ) {
+    static const char * types[] = { "text", "word", "phone", "pause", "mark" };
+
+    if ( !marks_fp )
+        return;
+    fprintf( marks_fp, "{\"type\":\"%s\",\"start\":%lu,\"end\":%lu", types[ mark.type ], mark.start, mark.end );
+    if ( mark.type == nanotts::Mark::TEXT )
+        fprintf( marks_fp, ",\"offset\":%zu,\"length\":%zu", mark.offset, mark.length );
+    else if ( mark.type == nanotts::Mark::PHONE )
+        fprintf( marks_fp, ",\"phone\":%d", mark.phone );
+    else if ( mark.type == nanotts::Mark::NAMED ) {
+        fputs( ",\"name\":\"", marks_fp );
+        for ( const char * c = mark.name; *c; c++ ) {
+            if ( *c == '"' || *c == '\\' )
+                fprintf( marks_fp, "\\%c", *c );
+            else if ( (unsigned char) *c < 0x20 )
+                fprintf( marks_fp, "\\u%04x", *c );
+            else
+                fputc( *c, marks_fp );
+        }
+        fputc( '"', marks_fp );
+    }
+    fputs( "}\n", marks_fp );
+    fflush( marks_fp );         // for a reader that follows the file
 }
 //////////////////////////////////////////////////////////////////
 
@@ -949,516 +1146,138 @@ void NanoSingleton::setArgs( const int i, const char ** v ) {
 
 /*
 ================================================
-Pico
+    Per voice settings
 
-class to encapsulate the workings of the SVox PicoTTS System
+    kept in the user's config directory:
+    - Lingware cache: engine images (see PicoImage) of every voice. An image
+      is only used while it matches the Lingware files, the binary and the
+      machine it was compiled with.
+    - memory size measured with --tune-mem
 ================================================
 */
-class Pico {
-private:
-    PicoVoices_t        voices;
-
-    pico_System         picoSystem;
-    pico_Resource       picoTaResource;
-    pico_Resource       picoSgResource;
-    pico_Engine         picoEngine;
-    picoos_SDFile       sdOutFile;
-    char *              out_filename;
-
-    pico_Char *         local_text;
-    pico_Int16          text_remaining;
-    long long int       total_text_length;
-    char *              picoLingwarePath;
-
-    char                picoVoiceName[10];
-    Listener<short> *   listener;
-    Boilerplate *       modifiers;
-
-    void *              picoMemArea;
-    pico_Char *         picoTaFileName;
-    pico_Char *         picoSgFileName;
-    pico_Char *         picoTaResourceName;
-    pico_Char *         picoSgResourceName;
-    bool                pico_writeWavPcm;
-
-public:
-    Pico() ;
-    virtual ~Pico() ;
-
-    void setLangFilePath( const char * path =0 );
-    int initializeSystem() ;
-    void cleanup() ;
-    void sendTextForProcessing( unsigned char *, long long int ) ;
-    int process();
-
-    int setVoice( const char * );
-    void setOutFilename( const char * fn ) { out_filename = const_cast<char*>(fn); }
-
-    int fileSize( const char * filename ) ;
-    void setListener( Listener<short> * );
-    void addModifiers( Boilerplate * );
-    void writeWavePcm( bool new_setting = true ) { pico_writeWavPcm = new_setting; }
-};
-
-
-Pico::Pico() {
-    picoSystem              = 0;
-    picoTaResource          = 0;
-    picoSgResource          = 0;
-    picoEngine              = 0;
-    sdOutFile               = 0;
-    picoLingwarePath        = 0;
-    out_filename            = 0;
-
-    strcpy( picoVoiceName, "PicoVoice" );
-
-    total_text_length       = 0;
-    text_remaining          = 0;
-    listener                = 0;
-    modifiers               = 0;
+static bool config_file_path( char * path, size_t len, const char * name, bool create_dir )
+{
+    const char * home = getenv( "HOME" );
 
-    picoMemArea             = 0;
-    picoTaFileName          = 0;
-    picoSgFileName          = 0;
-    picoTaResourceName      = 0;
-    picoSgResourceName      = 0;
+    if ( !home || !*home )
+        return false;
 
-    pico_writeWavPcm        = false;
-}
-
-Pico::~Pico() {
-    if ( picoLingwarePath ) {
-        delete[] picoLingwarePath;
+    snprintf( path, len, "%s/%s", home, CONFIG_DIR_NAME );
+    if ( create_dir && -1 == mkdir( path, 0755 ) && errno != EEXIST ) {
+        fprintf( stderr, "cannot create \"%s\"\n", path );
+        return false;
     }
-
-    cleanup();
-
-    if ( picoMemArea )
-        free( picoMemArea );
-    if ( picoTaFileName )
-        free( picoTaFileName );
-    if ( picoSgFileName )
-        free( picoSgFileName );
-    if ( picoTaResourceName )
-        free( picoTaResourceName );
-    if ( picoSgResourceName )
-        free( picoSgResourceName );
-}
-
-void Pico::setLangFilePath( const char * path ) {
-    unsigned int len = strlen( path ) + 1;
-    picoLingwarePath = new char[ len ];
-    strcpy( picoLingwarePath, path );
+    snprintf( path, len, "%s/%s/%s", home, CONFIG_DIR_NAME, name );
+    return true;
 }
 
-int Pico::initializeSystem()
+static bool lingware_cache_path( char * path, size_t len, const char * voice, bool create_dir )
 {
-    const int       PICO_MEM_SIZE           = 2500000;
-    pico_Retstring  outMessage;
-    int             ret;
-
-    picoMemArea = malloc( PICO_MEM_SIZE );
-
-    if ( (ret = pico_initialize( picoMemArea, PICO_MEM_SIZE, &picoSystem )) ) {
-        pico_getSystemStatusMessage(picoSystem, ret, outMessage);
-        fprintf( stderr, "Cannot initialize pico (%i): %s\n", ret, outMessage );
-
-        pico_terminate(&picoSystem);
-        picoSystem = 0;
-        return -1;
-    }
-
-    /* Load the text analysis Lingware resource file.   */
-    picoTaFileName = (pico_Char *) malloc( PICO_MAX_DATAPATH_NAME_SIZE + PICO_MAX_FILE_NAME_SIZE );
-
-    // path
-    if ( !picoLingwarePath )
-        setLangFilePath();
-    strcpy((char *) picoTaFileName, picoLingwarePath);
-
-    // check for connecting slash
-    unsigned int len = strlen( (const char*)picoTaFileName );
-    if ( picoTaFileName[len-1] != '/' )
-        strcat((char*) picoTaFileName, "/");
-
-    // langfile name
-    strcat( (char *) picoTaFileName, voices.getTaName() );
-
-    // attempt to load it
-    if ( (ret = pico_loadResource(picoSystem, picoTaFileName, &picoTaResource)) ) {
-        pico_getSystemStatusMessage(picoSystem, ret, outMessage);
-        fprintf( stderr, "Cannot load text analysis resource file (%i): %s\n", ret, outMessage );
-        goto unloadTaResource;
-    }
-
-    /* Load the signal generation Lingware resource file.   */
-    picoSgFileName = (pico_Char *) malloc( PICO_MAX_DATAPATH_NAME_SIZE + PICO_MAX_FILE_NAME_SIZE );
-
-    strcpy((char *) picoSgFileName,   picoLingwarePath );
-    if ( picoSgFileName[len-1] != '/' )
-        strcat((char*) picoSgFileName, "/");
-    strcat((char *) picoSgFileName,   voices.getSgName() );
-
-    if ( (ret = pico_loadResource(picoSystem, picoSgFileName, &picoSgResource)) ) {
-        pico_getSystemStatusMessage(picoSystem, ret, outMessage);
-        fprintf( stderr, "Cannot load signal generation Lingware resource file (%i): %s\n", ret, outMessage );
-        goto unloadSgResource;
-    }
-
-    /* Get the text analysis resource name.     */
-    picoTaResourceName = (pico_Char *) malloc( PICO_MAX_RESOURCE_NAME_SIZE );
-    if((ret = pico_getResourceName( picoSystem, picoTaResource, (char *) picoTaResourceName ))) {
-        pico_getSystemStatusMessage(picoSystem, ret, outMessage);
-        fprintf( stderr, "Cannot get the text analysis resource name (%i): %s\n", ret, outMessage );
-        goto unloadSgResource;
-    }
-
-    /* Get the signal generation resource name. */
-    picoSgResourceName = (pico_Char *) malloc( PICO_MAX_RESOURCE_NAME_SIZE );
-    if((ret = pico_getResourceName( picoSystem, picoSgResource, (char *) picoSgResourceName ))) {
-        pico_getSystemStatusMessage(picoSystem, ret, outMessage);
-        fprintf( stderr, "Cannot get the signal generation resource name (%i): %s\n", ret, outMessage );
-        goto unloadSgResource;
-    }
-
-    /* Create a voice definition.   */
-    if((ret = pico_createVoiceDefinition( picoSystem, (const pico_Char *) picoVoiceName ))) {
-        pico_getSystemStatusMessage(picoSystem, ret, outMessage);
-        fprintf( stderr, "Cannot create voice definition (%i): %s\n", ret, outMessage );
-        goto unloadSgResource;
-    }
-
-    /* Add the text analysis resource to the voice. */
-    if((ret = pico_addResourceToVoiceDefinition( picoSystem, (const pico_Char *) picoVoiceName, picoTaResourceName ))) {
-        pico_getSystemStatusMessage(picoSystem, ret, outMessage);
-        fprintf( stderr, "Cannot add the text analysis resource to the voice (%i): %s\n", ret, outMessage );
-        goto unloadSgResource;
-    }
-
-    /* Add the signal generation resource to the voice. */
-    if((ret = pico_addResourceToVoiceDefinition( picoSystem, (const pico_Char *) picoVoiceName, picoSgResourceName ))) {
-        pico_getSystemStatusMessage(picoSystem, ret, outMessage);
-        fprintf( stderr, "Cannot add the signal generation resource to the voice (%i): %s\n", ret, outMessage );
-        goto unloadSgResource;
-    }
-
-    /* Create a new Pico engine. */
-    if((ret = pico_newEngine( picoSystem, (const pico_Char *) picoVoiceName, &picoEngine ))) {
-        pico_getSystemStatusMessage(picoSystem, ret, outMessage);
-        fprintf( stderr, "Cannot create a new pico engine (%i): %s\n", ret, outMessage );
-        goto disposeEngine;
-    }
+    struct utsname  un;
+    char            name[ 128 ];
 
-    /* success */
-    return 0;
+    if ( -1 == uname( &un ) )
+        return false;
+    snprintf( name, sizeof(name), "%s-%s.cache", voice, un.machine );
+    return config_file_path( path, len, name, create_dir );
+}
 
+// memory size saved by --tune-mem, 0 if none
+static unsigned int saved_mem_size( const char * voice )
+{
+    char            path[ PATH_MAX ];
+    char            name[ 128 ];
+    unsigned int    size = 0;
 
-    //
-    // partial shutdowns below this line
-    //  for pico cleanup in case of startup abort
-    //
-disposeEngine:
-    if (picoEngine) {
-        pico_disposeEngine( picoSystem, &picoEngine );
-        pico_releaseVoiceDefinition( picoSystem, (pico_Char *) picoVoiceName );
-        picoEngine = 0;
-    }
-unloadSgResource:
-    if (picoSgResource) {
-        pico_unloadResource( picoSystem, &picoSgResource );
-        picoSgResource = 0;
-    }
-unloadTaResource:
-    if (picoTaResource) {
-        pico_unloadResource( picoSystem, &picoTaResource );
-        picoTaResource = 0;
-    }
+    snprintf( name, sizeof(name), "%s.memsize", voice );
+    if ( !config_file_path( path, sizeof(path), name, false ) )
+        return 0;
 
-    if (picoSystem) {
-        pico_terminate(&picoSystem);
-        picoSystem = 0;
+    FILE * fp = fopen( path, "r" );
+    if ( fp ) {
+        if ( 1 != fscanf( fp, "%u", &size ) )
+            size = 0;
+        fclose( fp );
     }
-
-    return -1;
+    return size;
 }
 
-void Pico::cleanup()
+static int save_mem_size( const char * voice, unsigned int size )
 {
-    if ( sdOutFile ) {
-        picoos_Common common = (picoos_Common) pico_sysGetCommon(picoSystem);
-        picoos_sdfCloseOut(common, &sdOutFile);
-        sdOutFile = 0;
-    }
+    char            path[ PATH_MAX ];
+    char            name[ 128 ];
 
-    if (picoEngine) {
-        pico_disposeEngine( picoSystem, &picoEngine );
-        pico_releaseVoiceDefinition( picoSystem, (pico_Char *) picoVoiceName );
-        picoEngine = 0;
-    }
-
-    if (picoSgResource) {
-        pico_unloadResource( picoSystem, &picoSgResource );
-        picoSgResource = 0;
-    }
-
-    if (picoTaResource) {
-        pico_unloadResource( picoSystem, &picoTaResource );
-        picoTaResource = 0;
-    }
+    snprintf( name, sizeof(name), "%s.memsize", voice );
+    if ( !config_file_path( path, sizeof(path), name, true ) )
+        return -1;
 
-    if (picoSystem) {
-        pico_terminate(&picoSystem);
-        picoSystem = 0;
+    FILE * fp = fopen( path, "w" );
+    if ( !fp ) {
+        fprintf( stderr, "cannot write \"%s\"\n", path );
+        return -1;
     }
+    fprintf( fp, "%u\n", size );
+    fclose( fp );
+    fprintf( stderr, "memory size for %s: %u bytes (saved to \"%s\")\n", voice, size, path );
+    return 0;
 }
 
-void Pico::sendTextForProcessing( unsigned char * words, long long int word_len )
-{
-    local_text          = (pico_Char *) words;
-    total_text_length   = word_len;
-}
-
-int Pico::process()
+// compile the cache for one voice, or all voices that have Lingware installed
+static int compile_lingware( const char * langdir, const char * voice_arg, bool expand_pdfs )
 {
-    const int       MAX_OUTBUF_SIZE     = 128;
-    const int       PCM_BUFFER_SIZE     = 256;
-    pico_Char *     inp                 = 0;
-    pico_Int16      bytes_sent, bytes_recv, out_data_type;
-    short           outbuf[MAX_OUTBUF_SIZE/2];
-    pico_Retstring  outMessage;
-    char            pcm_buffer[ PCM_BUFFER_SIZE ];
-    int             ret, getstatus;
-    picoos_bool     done                = TRUE;
-
-    bool            do_startpad         = false;
-    bool            do_endpad           = false;
-
-    // pads are optional, but can be provided to set pico-modifiers
-    if ( modifiers ) {
-        do_startpad = true;
-        do_endpad = true;
-        unsigned int len;
-        inp = (pico_Char *) modifiers->getOpener( &len );
-        text_remaining = len;
-        fprintf( stderr, "%s", modifiers->getStatusMessage() );
-    } else {
-        inp = (pico_Char *) local_text;
-    }
+    char            path[ PATH_MAX ];
+    int             failed = 0;
+    const char *    only_voice = 0;
 
-    unsigned int bufused = 0;
-    memset( pcm_buffer, 0, PCM_BUFFER_SIZE );
-
-    // open output WAVE/PCM for writing
-    if ( pico_writeWavPcm ) {
-        picoos_Common common = (picoos_Common) pico_sysGetCommon(picoSystem);
-        if ( TRUE != (done=picoos_sdfOpenOut(common, &sdOutFile, (picoos_char *)out_filename, SAMPLE_FREQ_16KHZ, PICOOS_ENC_LIN)) ) {
-            fprintf( stderr, "Cannot open output wave file: %s\n", out_filename );
-            return -1;
-        }
+    if ( voice_arg && !(only_voice = nanotts::findVoice( voice_arg )) ) {
+        fprintf( stderr, "unknown voice: %s\n", voice_arg );
+        return -1;
     }
 
-    long long int text_length = total_text_length;
+    for ( int i = 0; nanotts::voiceName( i ); i++ ) {
+        const char * voice = nanotts::voiceName( i );
+        if ( only_voice && strcmp( voice, only_voice ) != 0 )
+            continue;
 
-    /* synthesis loop   */
-    while(1)
-    {
-        //−32,768 to 32,767.
-        if (text_remaining <= 0)
-        {
-            // text_remaining run-out; end pre-pad text
-            if ( do_startpad ) {
-                do_startpad = false;
-                // start normal text
-                inp = (pico_Char *) local_text;
-                int increment = text_length >= 32767 ? 32767 : text_length;
-                text_length -= increment;
-                text_remaining = increment;
-            }
-            // main text ran out
-            else if ( text_length <= 0 ) {
-                // tack end_pad on the end
-                if ( do_endpad ) {
-                    do_endpad = false;
-                    unsigned int len;
-                    inp = (pico_Char *) modifiers->getCloser( &len );
-                    text_remaining = len;
-                } else {
-                    break; /* done */
-                }
-            }
-            // continue feed main text
-            else {
-                int increment = text_length >= 32767 ? 32767 : text_length;
-                text_length -= increment;
-                text_remaining = increment;
+        if ( !nanotts::hasLingware( langdir, voice ) ) {
+            if ( only_voice ) {
+                fprintf( stderr, "no Lingware for %s in %s\n", voice, langdir );
+                failed++;
             }
+            continue;
         }
 
-        /* Feed the text into the engine.   */
-        if ( (ret = pico_putTextUtf8(picoEngine, inp, text_remaining, &bytes_sent)) ) {
-            pico_getSystemStatusMessage(picoSystem, ret, outMessage);
-            fprintf( stderr, "Cannot put Text (%i): %s\n", ret, outMessage );
-            return -2;
+        if ( !lingware_cache_path( path, sizeof(path), voice, true ) ) {
+            return -1;
         }
 
-        text_remaining -= bytes_sent;
-        inp += bytes_sent;
+        nanotts::Engine::Options options;
+        options.lingware_dir = langdir;
+        options.lazy_init = true;
+        options.expand_pdfs = expand_pdfs;
+        options.mem_size = saved_mem_size( voice );
 
-        do {
-
-            /* Retrieve the samples */
-            getstatus = pico_getData( picoEngine, (void *) outbuf, MAX_OUTBUF_SIZE, &bytes_recv, &out_data_type );
-            if ( (getstatus !=PICO_STEP_BUSY) && (getstatus !=PICO_STEP_IDLE) ) {
-                pico_getSystemStatusMessage(picoSystem, getstatus, outMessage);
-                fprintf( stderr, "Cannot get Data (%i): %s\n", getstatus, outMessage );
-                return -4;
-            }
-
-            /* copy partial encoding and get more bytes */
-            if ( bytes_recv > 0 )
-            {
-                if ( (bufused + bytes_recv) <= PCM_BUFFER_SIZE ) {
-                    memcpy( pcm_buffer+bufused, (int8_t *)outbuf, bytes_recv );
-                    bufused += bytes_recv;
-                }
-
-                /* or write the buffer to wavefile, and retrieve any leftover decoding bytes */
-                else
-                {
-                    if ( pico_writeWavPcm ) {
-                        done = picoos_sdfPutSamples( sdOutFile, bufused / 2, (picoos_int16*) pcm_buffer );
-                    }
-
-                    if ( listener ) {
-                        listener->writeData( (short*)pcm_buffer, bufused/2 );
-                    }
-
-                    bufused = 0;
-                    memcpy( pcm_buffer, (int8_t *)outbuf, bytes_recv );
-                    bufused += bytes_recv;
-                }
-            }
-
-        } while (PICO_STEP_BUSY == getstatus);
-
-        /* This chunk of synthesis is finished; pass the remaining samples. */
-        if ( pico_writeWavPcm ) {
-            done = picoos_sdfPutSamples( sdOutFile, bufused / 2, (picoos_int16*) pcm_buffer );
-        }
-
-        if ( listener ) {
-            listener->writeData( (short*)pcm_buffer, bufused/2 );
+        nanotts::Engine engine( voice, options );
+        if ( !engine.ready() || engine.saveImage( path ) < 0 ) {
+            failed++;
         }
     }
 
-    // close output wave file, so it can be opened elsewhere
-    if ( sdOutFile ) {
-        picoos_Common common = (picoos_Common) pico_sysGetCommon(picoSystem);
-        picoos_sdfCloseOut(common, &sdOutFile);
-        sdOutFile = 0;
-
-        // report
-        int bytes = fileSize( out_filename );
-        fprintf( stderr, "wrote \"%s\" (%d bytes)\n", out_filename, bytes );
-    }
-
-    return bufused;
+    return failed;
 }
 
-int Pico::setVoice( const char * v ) {
-    int r = voices.setVoice( v ) ;
-    fprintf( stderr, "using lang: %s\n", voices.getVoice() );
-    return r;
-}
 
-int Pico::fileSize( const char * filename ) {
-    FILE * file_p = fopen( filename, "rb" );
-    if ( !file_p )
-        return -1;
-    fseek( file_p, 0L, SEEK_SET );
-    int beginning = ftell( file_p );
-    fseek( file_p, 0L, SEEK_END );
-    int end = ftell( file_p );
-    return end - beginning;
-}
 
-void Pico::setListener( Listener<short> * listener ) {
-    this->listener = listener;
-}
+static nanotts::Engine * speaking;
 
-void Pico::addModifiers( Boilerplate * modifiers ) {
-    this->modifiers = modifiers;
-}
-//////////////////////////////////////////////////////////////////
-
-/**
- * Pico wrapped with singleton
- */
-class PicoSingleton : public Pico {
-public:
-
-    /**
-     * only method to get singleton handle to this object
-     */
-    static PicoSingleton & instance();
-
-    /**
-     * explicit destruction
-     */
-    static void destroy();
-
-private:
-    /**
-     * prevent outside construction
-     */
-    PicoSingleton();
-
-    /**
-     * prevent compile-time deletion
-     */
-    virtual ~PicoSingleton();
-
-    /**
-     * prevent copy-constructor
-     */
-    PicoSingleton( const PicoSingleton& ) ;
-
-    /**
-     * prevent assignment operator
-     */
-    PicoSingleton& operator=( const PicoSingleton & ) ;
-
-    /**
-     * sole instance of this object; static assures 0 initialization for free
-     */
-    static PicoSingleton * single_instance;
-};
-
-PicoSingleton & PicoSingleton::instance() {
-    if ( 0 == single_instance ) {
-        single_instance = new PicoSingleton();
-    }
-    return *single_instance;
-}
-
-void PicoSingleton::destroy() {
-    if ( single_instance ) {
-        delete single_instance;
-        single_instance = 0;
-    }
-}
-
-PicoSingleton::PicoSingleton() {
-}
-
-PicoSingleton::~PicoSingleton() {
+// ^C stops the speech, a second one ends the process as usual
+static void cancel_on_signal( int )
+{
+    if ( speaking )
+        speaking->cancel();
+    signal( SIGINT, SIG_DFL );
 }
 
-PicoSingleton * PicoSingleton::single_instance;
-//////////////////////////////////////////////////////////////////
-
-
-
 int main( int argc, const char ** argv )
 {
     NanoSingleton::setArgs( argc, argv );
@@ -1477,52 +1296,106 @@ int main( int argc, const char ** argv )
         return 127; // command not found
     }
 
+    //
+    if ( nano.compileLingware() ) {
+        res = compile_lingware( nano.getLangFilePath(), nano.compileAllVoices() ? 0 : nano.getVoice(), nano.expandPdfs() );
+        nano.destroy();
+        return res ? 1 : 0;
+    }
+
     //
     unsigned char * words   = 0;
-    unsigned int    length  = 0;
-    if ( nano.ProduceInput( &words, &length ) < 0 ) {
+    size_t          length  = 0;
+    if ( !nano.imageOnly() && nano.ProduceInput( &words, &length ) < 0 ) {
         nano.destroy();
         return 65; // data format error
     }
 
     //
-    PicoSingleton & pico = PicoSingleton::instance();
-    pico.setLangFilePath( nano.getLangFilePath() );
-    pico.setOutFilename( nano.outFilename() );
-
-    if ( pico.setVoice( nano.getVoice() ) < 0 ) {
+    const char * voice = nanotts::findVoice( nano.getVoice() );
+    if ( !voice ) {
         fprintf( stderr, "set voice failed, with: \"%s\n\"", nano.getVoice() );
-        pico.destroy();
         nano.destroy();
         return 127; // command not found
     }
+    fprintf( stderr, "using lang: %s\n", voice );
 
-    if ( nano.writingWaveFile() ) {
-        pico.writeWavePcm();
-    }
-    pico.setListener( nano.getListener() );
-    pico.addModifiers( nano.getModifiers() );
+    if ( nano.traceFile() )
+        nanotts::startTrace( nano.traceFile() );
+
+    nanotts::Engine::Options options;
+    options.lingware_dir = nano.getLangFilePath();
+    // an image must not depend on when its processing units were constructed
+    options.lazy_init = nano.lazyInit() || nano.saveImage();
+    options.expand_pdfs = nano.expandPdfs();
+
+    // measure with the default size when tuning, don't reuse an earlier result
+    options.mem_size = nano.memSize();
+    if ( !options.mem_size && !nano.tuneMem() )
+        options.mem_size = saved_mem_size( voice );
 
     //
-    if ( pico.initializeSystem() < 0 ) {
+    char cache[ PATH_MAX ];
+    if ( nano.loadImage() ) {
+        options.image = nano.loadImage();
+    } else if ( lingware_cache_path( cache, sizeof(cache), voice, false ) && access( cache, R_OK ) == 0 ) {
+        options.image = cache;
+    }
+
+    nanotts::Engine engine( voice, options );
+    if ( !engine.ready() ) {
         fprintf( stderr, " * problem initializing Svox Pico\n" );
-        pico.destroy();
         nano.destroy();
         return 126; // command found but not executable
     }
+    if ( engine.fromImage() )
+        fprintf( stderr, "using %s: %s\n", nano.loadImage() ? "image" : "Lingware cache", options.image );
+    else if ( options.image == cache )
+        fprintf( stderr, "Lingware cache is stale, rerun with --compile-lingware\n" );
 
     //
-    pico.sendTextForProcessing( words, length );
+    if ( nano.saveImage() && engine.saveImage( nano.saveImage() ) < 0 ) {
+        fprintf( stderr, " * problem writing engine image\n" );
+    }
 
-    //
-    pico.process();
+    if ( nano.imageOnly() ) {
+        nano.destroy();
+        return 0;
+    }
 
     //
-    pico.cleanup();
+    const nanotts::Params & params = nano.getParams();
+    if ( params.speed != -1 )
+        fprintf( stderr, "speed: %.2f\n", params.speed );
+    if ( params.pitch != -1 )
+        fprintf( stderr, "pitch: %.2f\n", params.pitch );
+    if ( params.volume != -1 )
+        fprintf( stderr, "volume: %.2f\n", params.volume );
+
+    speaking = &engine;
+    signal( SIGINT, cancel_on_signal );
+    if ( nano.inputFile() )
+        res = engine.synthesizeFile( nano.inputFile(), params, nano.getSink() );
+    else
+        res = engine.synthesize( (const char *) words, length, params, nano.getSink() );
+    signal( SIGINT, SIG_DFL );
+    speaking = 0;
+
+    int cancelled = res == nanotts::Engine::CANCELLED;
+    if ( cancelled ) {
+        nano.DropPlayback();
+    }
+    nano.FinishOutput();
+
+    if ( nano.printStats() ) {
+        engine.printStats();
+    }
+
+    if ( nano.tuneMem() ) {
+        save_mem_size( voice, engine.recommendedMemSize() );
+    }
 
     //
-    pico.destroy();
     nano.destroy();
-    return 0;
+    return cancelled ? 128 + SIGINT : 0;
 }
-
@@ -14,6 +14,14 @@ mmfile_t::~mmfile_t()
 
 void mmfile_t::open( const char * _filename ) 
 {
+	filename = 0;
+	fp = 0;
+	size = 0;
+	data = 0;
+	window_offset = 0;
+	window_size = 0;
+	released = 0;
+
 #ifdef _WIN /* Windows */
 	LPSTR lpfilename = (LPSTR) _filename;
 	hFile = CreateFile(lpfilename, GENERIC_READ, FILE_SHARE_READ, NULL,
@@ -36,17 +44,23 @@ void mmfile_t::open( const char * _filename )
 	}
 
 	// filesize
-	size = GetFileSize( hFile, NULL );
+	LARGE_INTEGER file_size;
+	GetFileSizeEx( hFile, &file_size );
+	size = (size_t) file_size.QuadPart;
 
 	// save 
 	data = (unsigned char *) lpFileBase;
 
 #else /* Unix */
-    filename = realpath( _filename, NULL );
+    if ( !(filename = realpath( _filename, NULL )) ) {
+		fprintf( stderr, "mmfile: couldn't find input: \"%s\"\n", _filename );
+		return;
+	}
 
 	// open
 	if ( !(fp = fopen( filename, "rb" )) ) {
 		fprintf( stderr, "mmfile: couldn't open input: \"%s\" for reading\n", filename );
+		return;
 	}
 
 	// fileno
@@ -56,11 +70,11 @@ void mmfile_t::open( const char * _filename )
 	struct stat st;
 	if ( fstat( this->fileno, &st ) == -1 || st.st_size == 0 ) {
 		fprintf( stderr, "mmfile: couldn't stat input file\n" );
+		return;
 	}
 	size = st.st_size;
 
-	// mmap the file
-	data = (unsigned char *) mmap( 0, st.st_size, PROT_READ, MAP_SHARED, this->fileno, 0 );
+	// the file is mapped by window()
 #endif /* Windows or Unix mmap methods */
 }
 
@@ -73,7 +87,7 @@ void mmfile_t::close()
 
 #else /* Unix|Mac */
     if ( data ) {
-        if ( -1 == munmap( data, size ) ) {
+        if ( -1 == munmap( data, window_size ) ) {
             fprintf( stderr, "mmfile: failed to unmap file: %s\n", filename );
         }
         data = 0;
@@ -87,3 +101,64 @@ void mmfile_t::close()
 #endif
 }
 
+// the file from offset on, mapped with at least WINDOW_MIN bytes (or the rest
+// of the file) after it; *available is set to the bytes mapped from offset on
+const unsigned char * mmfile_t::window( size_t offset, size_t * available )
+{
+    if ( offset >= size ) {
+        *available = 0;
+        return 0;
+    }
+
+#ifdef _WIN
+    *available = size - offset;
+    return data + offset;
+
+#else /* Unix|Mac */
+    size_t window_end = window_offset + window_size;
+    if ( !data || offset < window_offset
+         || ( offset + WINDOW_MIN > window_end && window_end < size ) ) {
+        if ( data )
+            munmap( data, window_size );
+
+        size_t page = sysconf( _SC_PAGESIZE );
+        window_offset = offset - offset % page;
+        window_size = size - window_offset < WINDOW_SIZE ? size - window_offset : WINDOW_SIZE;
+        released = 0;
+
+        data = (unsigned char *) mmap( 0, window_size, PROT_READ, MAP_SHARED, this->fileno, window_offset );
+        if ( data == MAP_FAILED ) {
+            fprintf( stderr, "mmfile: couldn't map input: \"%s\"\n", filename );
+            data = 0;
+            *available = 0;
+            return 0;
+        }
+        madvise( data, window_size, MADV_SEQUENTIAL );
+    }
+
+    *available = window_offset + window_size - offset;
+    return data + ( offset - window_offset );
+#endif
+}
+
+// everything before offset has been read: drop it from this process and from
+// the page cache, so long inputs don't push out everything else
+void mmfile_t::release( size_t offset )
+{
+#ifndef _WIN
+    if ( !data || offset < window_offset + released + RELEASE_STEP )
+        return;
+
+    size_t page = sysconf( _SC_PAGESIZE );
+    size_t end = offset - window_offset;
+    end -= end % page;
+    if ( end > window_size )
+        end = window_size;
+
+    madvise( data + released, end - released, MADV_DONTNEED );
+#ifdef POSIX_FADV_DONTNEED
+    posix_fadvise( this->fileno, window_offset + released, end - released, POSIX_FADV_DONTNEED );
+#endif
+    released = end;
+#endif
+}
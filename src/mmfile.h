@@ -13,6 +13,8 @@
 #ifndef _WIN
 	#include <sys/types.h> 		// mmap
 	#include <sys/mman.h>		// mmap
+	#include <unistd.h>			// sysconf
+	#include <fcntl.h>			// posix_fadvise
 #endif  /* _WIN */
 #include <sys/stat.h>			// fstat
 
@@ -28,13 +30,27 @@
 #endif
 
 
+/*
+ * read-only input file, mapped a window at a time: window() maps the part of
+ * the file from an offset on, release() drops what was read from memory and
+ * from the page cache. On Windows the whole file is mapped.
+ */
 struct mmfile_t 
 {
+	enum {
+		WINDOW_SIZE     = 16 << 20,     // bytes mapped at a time
+		WINDOW_MIN      = 64 << 10,     // remap when less than this is left
+		RELEASE_STEP    = 1 << 20       // release read pages in steps of this
+	};
+
 	char *          filename;
 	FILE *          fp;
 	unsigned int    fileno;
-	unsigned int    size;
-    unsigned char * data;
+	size_t          size;
+    unsigned char * data;               // the current window
+	size_t          window_offset;      // file offset of data
+	size_t          window_size;
+	size_t          released;           // bytes of the window released
 
 
 // windows file handling
@@ -44,11 +60,15 @@ struct mmfile_t
 	LPVOID lpFileBase;
 #endif
 
-	mmfile_t( void ) : filename(0), fp(0), fileno(0), size(0), data(0) {}
+	mmfile_t( void ) : filename(0), fp(0), fileno(0), size(0), data(0),
+		window_offset(0), window_size(0), released(0) {}
 	mmfile_t( const char * );
 	~mmfile_t() ;
     void open( const char * );
     void close();
+
+    const unsigned char * window( size_t offset, size_t * available );
+    void release( size_t offset );
 };
 
 #endif /* __MMFILE_H__ */
@@ -0,0 +1,328 @@
+#ifndef __nanotts__
+#define __nanotts__
+
+#include <stddef.h>
+#include <pthread.h>
+#include <sched.h>
+
+class Pico;
+
+/*
+================================================
+libnanotts
+
+the speech synthesis of nanotts as a library. An Engine holds one voice,
+loaded once and used for any number of texts; the samples of a text are
+passed to a Sink while it is spoken. An EnginePool shares engines between
+threads.
+
+    nanotts::Engine engine( "en-US" );
+    if ( engine.ready() ) {
+        nanotts::BufferSink sink( buffer, capacity );
+        engine.synthesize( "Hello world.", nanotts::Params(), sink );
+    }
+
+An engine speaks one text at a time; use one per thread, or a pool. The
+signal generation carries its noise state from one text to the next, so a
+text spoken again sounds the same but isn't the same samples.
+================================================
+*/
+namespace nanotts {
+
+enum ResampleQuality {                  // the filters of Resampler
+    RESAMPLE_FAST,
+    RESAMPLE_MEDIUM,
+    RESAMPLE_BEST
+};
+
+// how to speak a text; -1 leaves the voice's own speed, pitch and volume
+struct Params {
+    float               speed;          // 0.2 - 5.0
+    float               pitch;          // 0.5 - 2.0
+    float               volume;         // 0.0 - 5.0, >1.0 may clip
+    unsigned int        rate;           // of the samples, resampled from 16 kHz
+    ResampleQuality     quality;
+    bool                marks;          // pass the timing of the speech to Sink::mark()
+
+    Params() : speed( -1 ), pitch( -1 ), volume( -1 ), rate( 16000 ), quality( RESAMPLE_MEDIUM ), marks( false ) {}
+};
+
+/*
+the timing of the speech, with Params::marks. A mark is passed when it ends,
+while the text is spoken; its samples may follow a little later. Samples
+count from the first one of the text, at Params::rate; the end is after the
+last sample.
+
+TEXT is a word of the text, between spaces, at its bytes in the text; it
+spans the words spoken for it, "42" is two. A word after an abbreviation
+("Dr. Smith") is in the TEXT of the abbreviation, a mark between them would
+change how it is read.
+*/
+struct Mark {
+    enum Type {
+        TEXT,                           // offset and length of a word of the text
+        WORD,                           // a word as spoken
+        PHONE,                          // a phone, phone is its phonetic id in the voice
+        PAUSE,
+        NAMED                           // <mark name="..."/> of the text, start == end
+    };
+
+    Type                type;
+    unsigned long       start;
+    unsigned long       end;
+    size_t              offset;         // TEXT: in bytes
+    size_t              length;
+    int                 phone;          // PHONE
+    const char *        name;           // NAMED, only valid during the call
+};
+
+// receives 16-bit mono samples while a text is spoken
+class Sink {
+public:
+    virtual ~Sink() {}
+    // the samples are only valid during the call
+    virtual void write( const short * samples, unsigned int count ) = 0;
+    // the engine took in the end of a sentence; may block to pause the text
+    virtual void sentence() {}
+    // the timing of the speech, with Params::marks
+    virtual void mark( const Mark & ) {}
+};
+
+// collects the samples in a buffer of the caller's
+class BufferSink : public Sink {
+public:
+    BufferSink( short * buffer, size_t capacity );
+    void write( const short * samples, unsigned int count );
+
+    size_t size() const { return used; }
+    size_t dropped() const { return lost; }    // samples that didn't fit
+    void clear() { used = lost = 0; }
+
+private:
+    short *             buffer;
+    size_t              capacity;
+    size_t              used;
+    size_t              lost;
+};
+
+class Engine {
+public:
+    struct Options {
+        const char *    lingware_dir;   // 0 for defaultLingwareDir()
+        const char *    image;          // start from this engine image if it is current
+        unsigned int    mem_size;       // of the engine memory, 0 for the default
+        bool            lazy_init;      // construct processing units when first needed
+        bool            expand_pdfs;    // faster signal generation for about 2 MB more memory
+
+        Options() : lingware_dir( 0 ), image( 0 ), mem_size( 0 ), lazy_init( false ), expand_pdfs( false ) {}
+    };
+
+    enum { CANCELLED = 1 };             // returned by synthesize()
+
+    struct Stats {
+        unsigned long   texts;
+        double          audio_ms;       // of the samples passed to the sinks
+        double          busy_ms;        // spent in synthesize()
+
+        Stats() : texts( 0 ), audio_ms( 0 ), busy_ms( 0 ) {}
+    };
+
+    explicit Engine( const char * voice, const Options & options = Options() );
+    ~Engine();
+
+    bool ready() const { return ok; }
+    bool fromImage() const { return from_image; }
+    const char * voice() const;
+
+    // 0 when the text was spoken, CANCELLED, <0 on errors
+    int synthesize( const char * text, size_t length, const Params & params, Sink & sink );
+    int synthesize( const char * text, const Params & params, Sink & sink );
+    int synthesizeFile( const char * filename, const Params & params, Sink & sink );
+
+    // stop synthesize() within a synthesis step; safe from a signal handler
+    // or another thread. A cancel while idle does nothing.
+    void cancel();
+
+    int saveImage( const char * filename );
+    const Stats & stats() const { return totals; }
+    unsigned int recommendedMemSize();
+    void printStats();
+
+private:
+    Engine( const Engine & );
+    Engine & operator=( const Engine & );
+
+    int speak( const Params & params, Sink & sink );
+
+    Pico *              pico;
+    bool                ok;
+    bool                from_image;
+    Stats               totals;
+};
+
+/*
+engines by voice, created when first needed; acquire() waits while all
+engines of the voice are in use. Engines of a pool don't start from an
+image, Options::image is for one voice.
+
+With CPU sets, the engines are spread over the sets in turn and
+a thread runs on the set of the engine it holds; the engine's memory is on
+the NUMA node of the set it was created on. nodeCpuSets() gives a set per
+node.
+*/
+class EnginePool {
+public:
+    explicit EnginePool( const Engine::Options & options = Engine::Options(), unsigned int per_voice = 1 );
+    ~EnginePool();
+
+    // before the first acquire()
+    void setCpuSets( const cpu_set_t * sets, unsigned int count );
+
+    Engine * acquire( const char * voice );     // 0 if the voice can't be loaded
+    void release( Engine * engine );
+
+    void printStats();
+
+    // an engine for the lifetime of the lease
+    class Lease {
+    public:
+        Lease( EnginePool & pool, const char * voice ) : pool( pool ), engine( pool.acquire( voice ) ) {}
+        ~Lease() { if ( engine ) pool.release( engine ); }
+        Engine * get() const { return engine; }
+        Engine * operator->() const { return engine; }
+    private:
+        Lease( const Lease & );
+        Lease & operator=( const Lease & );
+        EnginePool &    pool;
+        Engine *        engine;
+    };
+
+private:
+    EnginePool( const EnginePool & );
+    EnginePool & operator=( const EnginePool & );
+
+    struct slot_t {
+        char            voice[ 16 ];
+        Engine *        engine;         // 0 while it is created
+        bool            busy;
+        int             cpus;           // the CPU set, -1 for none
+        cpu_set_t       saved;          // the affinity of the holder before
+        Engine::Stats   stats;          // as of the last release
+    };
+
+    void pin( slot_t & slot );
+    void unpin( slot_t & slot );
+
+    Engine::Options     options;
+    char *              lingware_dir;
+    unsigned int        per_voice;
+    cpu_set_t *         cpu_sets;
+    unsigned int        cpu_set_count;
+    slot_t *            slots;
+    unsigned int        slot_count;
+    unsigned int        slot_capacity;
+    pthread_mutex_t     lock;
+    pthread_cond_t      released;
+};
+
+/*
+runs texts of two priority classes on a bounded number of engines at once.
+synthesize() is called from the caller's threads and blocks until the text
+is spoken. An interactive text waits for a free run slot only; a batch text
+also waits while interactive ones do, and gives up its slot at the end of a
+sentence to an interactive text that is waiting for one. Each class has a
+limit of texts that are admitted, running or paused.
+*/
+class Scheduler {
+public:
+    enum Priority {
+        INTERACTIVE,
+        BATCH,
+        PRIORITIES
+    };
+
+    Scheduler( unsigned int running, unsigned int interactive_limit, unsigned int batch_limit,
+               const Engine::Options & options = Engine::Options() );
+    ~Scheduler();
+
+    // as Engine::synthesize(), -1 also if the voice can't be loaded
+    int synthesize( Priority priority, const char * voice, const char * text, const Params & params, Sink & sink );
+    int synthesizeFile( Priority priority, const char * voice, const char * filename, const Params & params, Sink & sink );
+
+    // time texts spent waiting to be admitted, for a slot and paused, in ms
+    struct Stats {
+        unsigned long   texts;
+        unsigned long   preempted;      // times a batch text gave up its slot
+        double          mean_ms;
+        double          p50_ms;
+        double          p99_ms;
+        double          max_ms;
+    };
+    Stats stats( Priority priority );
+    void printStats();
+
+    // see EnginePool
+    void setCpuSets( const cpu_set_t * sets, unsigned int count ) { pool.setCpuSets( sets, count ); }
+
+private:
+    Scheduler( const Scheduler & );
+    Scheduler & operator=( const Scheduler & );
+
+    class Slot;
+    friend class Slot;
+
+    int schedule( Priority priority, const char * voice, const char * text, const char * filename,
+                  const Params & params, Sink & sink );
+    double admit( Priority priority );
+    double run( Priority priority );
+    void finish( Priority priority, double queued_ms );
+    double yield();
+
+    enum { SAMPLES = 1024 };            // the latest queue times kept per class
+    struct class_t {
+        unsigned int    limit;
+        unsigned int    admitted;
+        unsigned int    waiting;        // for a run slot, paused ones included
+        unsigned long   texts;
+        unsigned long   preempted;
+        double          total_ms;
+        double          max_ms;
+        double          samples[ SAMPLES ];
+    };
+
+    EnginePool          pool;
+    unsigned int        slots;
+    unsigned int        running;
+    class_t             classes[ PRIORITIES ];
+    pthread_mutex_t     lock;
+    pthread_cond_t      changed;
+};
+
+// the voices of pico by index, 0 after the last one
+const char * voiceName( int index );
+
+// the name of a voice given by name or ISO 639-3 / 3166 code, 0 if unknown
+const char * findVoice( const char * voice );
+
+// whether the Lingware of a voice is in a directory
+bool hasLingware( const char * dir, const char * voice );
+
+// "./lang" or the installed Lingware, 0 if neither has any
+const char * defaultLingwareDir();
+
+bool parseResampleQuality( const char * name, ResampleQuality * quality );
+
+// record a timeline of the synthesis in all threads, written as a Chrome
+// trace (chrome://tracing, Perfetto) at exit, on SIGUSR1 and by writeTrace().
+// A thread takes about 1.5 MB while it records; an exited thread's memory
+// and events go to the next thread
+bool startTrace( const char * filename );
+int writeTrace();
+
+// the CPUs of each NUMA node, or of the machine if there is no node
+// information; the number of sets
+unsigned int nodeCpuSets( cpu_set_t * sets, unsigned int max );
+
+}
+
+#endif // __nanotts__
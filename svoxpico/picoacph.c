@@ -681,6 +681,15 @@ static picoos_uint8 acphAccNrSyllParts(register picodata_ProcessingUnit this,
 }
 
 
+/* markers sit between the words of a phrase, without a boundary strength;
+   counting words in the phrase goes on past them */
+static picoos_uint8 acphIsMarker(register acph_subobj_t *acph,
+                                 const picoos_int32 ind) {
+    return (acph->headx[ind].head.type == PICODATA_ITEM_CMD) &&
+        (acph->headx[ind].head.info1 == PICODATA_ITEMINFO1_CMD_MARKER);
+}
+
+
 static picoos_uint8 acphAccGetNrsRight(register picodata_ProcessingUnit this,
                                      register acph_subobj_t *acph,
                                      const picoos_uint16 ind,
@@ -700,7 +709,8 @@ static picoos_uint8 acphAccGetNrsRight(register picodata_ProcessingUnit this,
     *nrsyllsfol = s2;
     i = ind + 1;
     while ((i < acph->headxLen) &&
-           (acph->headx[i].boundstrength == PICODATA_ITEMINFO1_BOUND_PHR0)) {
+           ((acph->headx[i].boundstrength == PICODATA_ITEMINFO1_BOUND_PHR0) ||
+            acphIsMarker(acph, i))) {
         if (acph->headx[i].head.type == PICODATA_ITEM_WORDPHON) {
             (*nrwordsfol)++;
             *nrsyllsfol += acphGetNrSylls(this, acph, i);
@@ -746,7 +756,8 @@ static picoos_uint8 acphAccGetNrsLeft(register picodata_ProcessingUnit this,
     *nrsyllspre = s1;
     i = ind - 1;
     while ((i >= 0) &&
-           (acph->headx[i].boundstrength == PICODATA_ITEMINFO1_BOUND_PHR0)) {
+           ((acph->headx[i].boundstrength == PICODATA_ITEMINFO1_BOUND_PHR0) ||
+            acphIsMarker(acph, i))) {
         if (acph->headx[i].head.type == PICODATA_ITEM_WORDPHON) {
             (*nrwordspre)++;
             *nrsyllspre += acphGetNrSylls(this, acph, i);
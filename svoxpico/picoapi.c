@@ -495,19 +495,11 @@ PICO_FUNC pico_releaseVoiceDefinition(
 
 /* *** Engine creation and deletion functions *********************************/
 
-/**
- * pico_newEngine : Creates and initializes a new Pico engine
- * @param    system : pointer to a pico_System struct
- * @param    *voiceName : pointer to the area containing the voice definition
- * @param    *outEngine : pointer to the Pico engine handle
- * @return  PICO_OK : successful
- * @return     PICO_ERR_INVALID_HANDLE, PICO_ERR_NULLPTR_ACCESS : errors
- * @callgraph
- * @callergraph
-*/
-PICO_FUNC pico_newEngine(
+pico_Status pico_newEngine_priv(
         pico_System system,
         const pico_Char *voiceName,
+        pico_Int16 lazyInit,
+        pico_Uint32 engineSize,
         pico_Engine *outEngine
         )
 {
@@ -526,7 +518,8 @@ PICO_FUNC pico_newEngine(
     } else {
         picoos_emReset(system->common->em);
         if (system->engine == NULL) {
-            *outEngine = (pico_Engine) picoctrl_newEngine(system->common->mm, system->rm, voiceName);
+            *outEngine = (pico_Engine) picoctrl_newEngine(system->common->mm, system->rm, voiceName,
+                    lazyInit ? TRUE : FALSE, (picoos_objsize_t) engineSize);
             if (*outEngine != NULL) {
                 system->engine = (picoctrl_Engine) *outEngine;
             } else {
@@ -542,6 +535,25 @@ PICO_FUNC pico_newEngine(
     return status;
 }
 
+/**
+ * pico_newEngine : Creates and initializes a new Pico engine
+ * @param    system : pointer to a pico_System struct
+ * @param    *voiceName : pointer to the area containing the voice definition
+ * @param    *outEngine : pointer to the Pico engine handle
+ * @return  PICO_OK : successful
+ * @return     PICO_ERR_INVALID_HANDLE, PICO_ERR_NULLPTR_ACCESS : errors
+ * @callgraph
+ * @callergraph
+*/
+PICO_FUNC pico_newEngine(
+        pico_System system,
+        const pico_Char *voiceName,
+        pico_Engine *outEngine
+        )
+{
+    return pico_newEngine_priv(system, voiceName, /*lazyInit*/ FALSE, /*engineSize*/ 0, outEngine);
+}
+
 /**
  * pico_disposeEngine : Disposes a Pico engine
  * @param    system : pointer to a pico_System struct
@@ -24,6 +24,8 @@
  *
  */
 
+#include <string.h>
+
 #include "picoos.h"
 #include "picodbg.h"
 #include "picodefs.h"
@@ -49,6 +51,46 @@ extern "C" {
  * 000uuuuu zzzzyyyy yyxxxxx   11110uuu    10uuzzzz    10yyyyyy    10xxxxxx
  *
 */
+
+/* word-at-a-time tests on four bytes packed into a picoos_uint32 */
+#define BASE_WORD_ONES      ((picoos_uint32)0x01010101)
+#define BASE_WORD_HIGHBITS  ((picoos_uint32)0x80808080)
+#define BASE_WORD_HAS_NONASCII(w)  (((w) & BASE_WORD_HIGHBITS) != 0)
+#define BASE_WORD_HAS_ZERO(w)      ((((w) - BASE_WORD_ONES) & ~(w) & BASE_WORD_HIGHBITS) != 0)
+
+picoos_uint32 picobase_ascii_prefix_length(const picoos_uint8 *utf8str,
+                                           const picoos_uint32 maxlen) {
+    picoos_uint32 i;
+    picoos_uint32 w[4];
+
+    i = 0;
+    /* bytewise up to word alignment */
+    while ((i < maxlen) && ((((picoos_objsize_t) &utf8str[i]) % sizeof(picoos_uint32)) != 0)) {
+        if ((utf8str[i] == 0) || (utf8str[i] >= (picoos_uint8)'\200')) {
+            return i;
+        }
+        i++;
+    }
+    /* then 16 bytes per step as long as all are ASCII and non-zero */
+    while ((i + 4 * sizeof(picoos_uint32)) <= maxlen) {
+        /* memcpy, not a cast: the bytes aren't picoos_uint32 objects; it
+           compiles to plain loads */
+        memcpy(w, &utf8str[i], sizeof(w));
+        if (BASE_WORD_HAS_NONASCII(w[0] | w[1] | w[2] | w[3])
+            || BASE_WORD_HAS_ZERO(w[0]) || BASE_WORD_HAS_ZERO(w[1])
+            || BASE_WORD_HAS_ZERO(w[2]) || BASE_WORD_HAS_ZERO(w[3])) {
+            break;
+        }
+        i += 4 * sizeof(picoos_uint32);
+    }
+    /* remainder, and the block containing the end of the run */
+    while ((i < maxlen) && (utf8str[i] != 0) && (utf8str[i] < (picoos_uint8)'\200')) {
+        i++;
+    }
+    return i;
+}
+
+
 picoos_int32 picobase_utf8_length(const picoos_uint8 *utf8str,
                                   const picoos_uint16 maxlen) {
 
@@ -58,8 +100,9 @@ picoos_int32 picobase_utf8_length(const picoos_uint8 *utf8str,
     picoos_uint8 ok;
 
     ok = TRUE;
-    i = 0;
-    len = 0;
+    /* ASCII prefix: one character per byte */
+    i = (picoos_uint16) picobase_ascii_prefix_length(utf8str, maxlen);
+    len = i;
     follow = 0;
     while (ok && (i < maxlen) && (utf8str[i] != '\000')) {
         if (follow > 0) {
@@ -95,6 +138,10 @@ picoos_int32 picobase_utf8_length(const picoos_uint8 *utf8str,
 }
 
 
+/* case mapping of 7 bit ASCII, same as base_utf32_lowercase/uppercase for c < 128 */
+#define BASE_ASCII_LOWERCASE(c)  ((((c) >= 'A') && ((c) <= 'Z')) ? ((c) + 32) : (c))
+#define BASE_ASCII_UPPERCASE(c)  ((((c) >= 'a') && ((c) <= 'z')) ? ((c) - 32) : (c))
+
 static picoos_uint32 base_utf32_lowercase (picoos_uint32 utf32)
 {
 
@@ -1148,6 +1195,16 @@ extern picoos_int32 picobase_lowercase_utf8_str (picoos_uchar utf8str[], picoos_
     i = 0;
     (*done) = TRUE;
     while (utf8str[i] != 0) {
+        if (utf8str[i] < (picoos_uint8)'\200') {
+            /* ASCII needs no table lookup */
+            if (k < (lowercaseMaxLen-1)) {
+                lowercase[k++] = BASE_ASCII_LOWERCASE(utf8str[i]);
+            } else {
+                *done = FALSE;
+            }
+            i++;
+            continue;
+        }
         picobase_get_utf8char(utf8str,& i,utf8char);
         utf32 = picobase_utf8_to_utf32(utf8char, & done1);
         utf32 = base_utf32_lowercase(utf32);
@@ -1179,6 +1236,16 @@ extern picoos_int32 picobase_uppercase_utf8_str (picoos_uchar utf8str[], picoos_
     i = 0;
     (*done) = TRUE;
     while (utf8str[i] != 0) {
+        if (utf8str[i] < (picoos_uint8)'\200') {
+            /* ASCII needs no table lookup */
+            if (k < (uppercaseMaxLen-1)) {
+                uppercase[k++] = BASE_ASCII_UPPERCASE(utf8str[i]);
+            } else {
+                *done = FALSE;
+            }
+            i++;
+            continue;
+        }
         picobase_get_utf8char(utf8str,& i,utf8char);
         utf32 = picobase_utf8_to_utf32(utf8char, & done1);
         utf32 = base_utf32_uppercase(utf32);
@@ -1207,6 +1274,11 @@ extern picoos_bool picobase_is_utf8_uppercase (picoos_uchar utf8str[], picoos_in
     isUpperCase = TRUE;
     i = 0;
     while (isUpperCase && (i <= utf8strmaxlen-1) && (utf8str[i] != 0)) {
+        if (utf8str[i] < (picoos_uint8)'\200') {
+            isUpperCase = (BASE_ASCII_UPPERCASE(utf8str[i]) == utf8str[i]);
+            i++;
+            continue;
+        }
         picobase_get_utf8char(utf8str,& i,utf8char);
         utf32 = picobase_utf8_to_utf32(utf8char,& done);
         isUpperCase = isUpperCase && (utf32 == base_utf32_uppercase(utf32));
@@ -1226,6 +1298,11 @@ extern picoos_bool picobase_is_utf8_lowercase (picoos_uchar utf8str[], picoos_in
     isLowerCase = TRUE;
     i = 0;
     while (isLowerCase && (i <= utf8strmaxlen-1) && (utf8str[i] != 0)) {
+        if (utf8str[i] < (picoos_uint8)'\200') {
+            isLowerCase = (BASE_ASCII_LOWERCASE(utf8str[i]) == utf8str[i]);
+            i++;
+            continue;
+        }
         picobase_get_utf8char(utf8str,& i,utf8char);
         utf32 = picobase_utf8_to_utf32(utf8char,& done);
         isLowerCase = isLowerCase && (utf32 == base_utf32_lowercase(utf32));
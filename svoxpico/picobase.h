@@ -63,6 +63,17 @@ typedef picoos_uint32 picobase_utf32;
 picoos_int32 picobase_utf8_length(const picoos_uint8 *utf8str,
                                   const picoos_uint16 maxlen);
 
+/**
+ * Determines the number of leading 7 bit ASCII bytes of 'utf8str'
+ * @param    utf8str : a string encoded in UTF8
+ * @param    maxlen  : max length (in bytes) accessible in utf8str
+ * @return   number of bytes before the first non-ASCII byte, '\0' or maxlen
+ * @remarks  tests a word at a time; used to skip per-character
+ *           decoding for plain ASCII text
+*/
+picoos_uint32 picobase_ascii_prefix_length(const picoos_uint8 *utf8str,
+                                           const picoos_uint32 maxlen);
+
 
 /**
  * Determines the number of bytes an UTF8 character used based
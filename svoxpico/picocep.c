@@ -207,7 +207,9 @@ typedef struct cep_subobj
     picoos_uint16 activeEndPos; /* end position of indices to be considered */
 
     /* this is used for input and output */
-    picoos_uint8 phoneId[PICOCEP_MAXWINLEN]; /* synchronised with indexReadPos */
+    picoos_uint16 phoneId[PICOCEP_MAXWINLEN]; /* synchronised with indexReadPos;
+                                                 PICODATA_PHONEFLAG_* in the high byte */
+    picoos_uint8 phoneFlags; /* flags of a phone without frames, for the next one */
 
     /*---------------------- coefficients --------------------------------------*/
     /* output coefficients buffer */
@@ -243,7 +245,7 @@ typedef struct cep_subobj
 
 static void initSmoothing(cep_subobj_t * cep);
 
-static picoos_int32 getFromPdf(picokpdf_PdfMUL pdf, picoos_uint32 vecstart,
+static picoos_int32 getFromPdf(picokpdf_PdfMUL pdf, picoos_uint16 vecindex,
         picoos_uint8 cepnum, picocep_WantMeanOrIvar_t wantMeanOrIvar,
         picocep_WantStaticOrDelta_t wantStaticOrDeltax);
 
@@ -308,6 +310,7 @@ static pico_status_t cepInitialize(register picodata_ProcessingUnit this, picoos
     /* indices* */
     cep->indexReadPos = 0;
     cep->indexWritePos = 0;
+    cep->phoneFlags = 0;
     /* outCep, outF0, outVoiced */
     cep->outXCepReadPos = 0;
     cep->outXCepWritePos = 0;
@@ -962,11 +965,10 @@ static picoos_uint8 makeWUWandWUm(cep_subobj_t * cep, picokpdf_PdfMUL pdf,
 {
     picoos_uint16 Id[2], Idd[3];
     /*picoos_uint32      vecstart, k;*/
-    picoos_uint32 vecstart;
+    picoos_uint16 vecindex;
     picoos_int32 *x = NULL, *xsq = NULL;
     picoos_int32 mean, ivar;
     picoos_uint16 i, j, numd = 0, numdd = 0;
-    picoos_uint8 vecsize = pdf->vecsize;
     picoos_int32 prev_WUm, prev_diag0, prev_diag1, prev_diag1_1, prev_diag2;
 
     prev_WUm = prev_diag0 = prev_diag1 = prev_diag1_1 = prev_diag2 = 0;
@@ -1011,23 +1013,23 @@ static picoos_uint8 makeWUWandWUm(cep_subobj_t * cep, picokpdf_PdfMUL pdf,
             cep->diag0[i] = prev_diag0;
             cep->WUm[i] = prev_WUm;
         } else {
-            vecstart = indices[b + i] * vecsize;
-            ivar = getFromPdf(pdf, vecstart, cepnum, PICOCEP_WANTIVAR,
+            vecindex = indices[b + i];
+            ivar = getFromPdf(pdf, vecindex, cepnum, PICOCEP_WANTIVAR,
                     PICOCEP_WANTSTATIC);
             prev_diag0 = cep->diag0[i] = ivar << 2; /* multiply ivar by 4 (4 used to be first entry of xsq) */
-            mean = getFromPdf(pdf, vecstart, cepnum, PICOCEP_WANTMEAN,
+            mean = getFromPdf(pdf, vecindex, cepnum, PICOCEP_WANTMEAN,
                     PICOCEP_WANTSTATIC);
             prev_WUm = cep->WUm[i] = mean << 1; /* multiply mean by 2 (2 used to be first entry of x) */
         }
 
         /* process delta means and delta inverse variances */
         for (j = 0; j < numd; j++) {
-            vecstart = indices[b + Id[j]] * vecsize;
-            ivar = getFromPdf(pdf, vecstart, cepnum, PICOCEP_WANTIVAR,
+            vecindex = indices[b + Id[j]];
+            ivar = getFromPdf(pdf, vecindex, cepnum, PICOCEP_WANTIVAR,
                     PICOCEP_WANTDELTA);
             cep->diag0[i] += xsq[j] * ivar;
 
-            mean = getFromPdf(pdf, vecstart, cepnum, PICOCEP_WANTMEAN,
+            mean = getFromPdf(pdf, vecindex, cepnum, PICOCEP_WANTMEAN,
                     PICOCEP_WANTDELTA);
             if (mean != 0) {
                 cep->WUm[i] += x[j] * mean;
@@ -1036,12 +1038,12 @@ static picoos_uint8 makeWUWandWUm(cep_subobj_t * cep, picokpdf_PdfMUL pdf,
 
         /* process delta delta means and delta delta inverse variances */
         for (j = 0; j < numdd; j++) {
-            vecstart = indices[b + Idd[j]] * vecsize;
-            ivar = getFromPdf(pdf, vecstart, cepnum, PICOCEP_WANTIVAR,
+            vecindex = indices[b + Idd[j]];
+            ivar = getFromPdf(pdf, vecindex, cepnum, PICOCEP_WANTIVAR,
                     PICOCEP_WANTDELTA2);
             cep->diag0[i] += xsq[numd + j] * ivar;
 
-            mean = getFromPdf(pdf, vecstart, cepnum, PICOCEP_WANTMEAN,
+            mean = getFromPdf(pdf, vecindex, cepnum, PICOCEP_WANTMEAN,
                     PICOCEP_WANTDELTA2);
             if (mean != 0) {
                 cep->WUm[i] += x[numd + j] * mean;
@@ -1057,12 +1059,12 @@ static picoos_uint8 makeWUWandWUm(cep_subobj_t * cep, picokpdf_PdfMUL pdf,
                 if (i > 0 && indices[b + i + 1] == indices[b + i]) {
                     cep->diag1[i] = prev_diag1;
                 } else {
-                    vecstart = indices[b + i + 1] * vecsize;
+                    vecindex = indices[b + i + 1];
                     /*
                      diag1[i] = getFromPdf(pdf, vecstart, numvuv, ceporder, numdeltas, cepnum,
                      bigpow, meanpowUm, ivarpow, PICOCEP_WANTIVAR, PICOCEP_WANTDELTA2);
                      */
-                    prev_diag1 = cep->diag1[i] = getFromPdf(pdf, vecstart,
+                    prev_diag1 = cep->diag1[i] = getFromPdf(pdf, vecindex,
                             cepnum, PICOCEP_WANTIVAR, PICOCEP_WANTDELTA2);
                 }
                 /*
@@ -1077,13 +1079,13 @@ static picoos_uint8 makeWUWandWUm(cep_subobj_t * cep, picokpdf_PdfMUL pdf,
                 if (i > 1 && indices[b + i] == indices[b + i - 1]) {
                     cep->diag1[i] += prev_diag1_1;
                 } else {
-                    vecstart = indices[b + i] * vecsize;
+                    vecindex = indices[b + i];
                     /*
                      k = vecstart + pdf->numvuv + pdf->ceporder * 2 + pdf->numdeltas * 3 + pdf->ceporder * 2 + cepnum;
                      cep->diag1[i] += (picoos_int32)(pdf->content[k]) << pdf->bigpow; */
                     /* cepnum'th delta delta ivar */
 
-                    prev_diag1_1 = getFromPdf(pdf, vecstart, cepnum,
+                    prev_diag1_1 = getFromPdf(pdf, vecindex, cepnum,
                             PICOCEP_WANTIVAR, PICOCEP_WANTDELTA2);
                     cep->diag1[i] += prev_diag1_1;
                 }
@@ -1098,16 +1100,16 @@ static picoos_uint8 makeWUWandWUm(cep_subobj_t * cep, picokpdf_PdfMUL pdf,
         if (i > 0 && indices[b + i + 1] == indices[b + i]) {
             cep->diag2[i] = prev_diag2;
         } else {
-            vecstart = indices[b + i + 1] * vecsize;
+            vecindex = indices[b + i + 1];
             /*
              k = vecstart + pdf->numvuv + pdf->ceporder * 2 + pdf->numdeltas * 3 + pdf->ceporder * 2 + cepnum;
              cep->diag2[i] = (picoos_int32)(pdf->content[k]) << pdf->bigpow;
              k -= pdf->ceporder;
              ivar = (picoos_int32)(pdf->content[k]) << pdf->bigpow;
              */
-            cep->diag2[i] = getFromPdf(pdf, vecstart, cepnum, PICOCEP_WANTIVAR,
+            cep->diag2[i] = getFromPdf(pdf, vecindex, cepnum, PICOCEP_WANTIVAR,
                     PICOCEP_WANTDELTA2);
-            ivar = getFromPdf(pdf, vecstart, cepnum, PICOCEP_WANTIVAR,
+            ivar = getFromPdf(pdf, vecindex, cepnum, PICOCEP_WANTIVAR,
                     PICOCEP_WANTDELTA);
             cep->diag2[i] -= (ivar + 2) / 4;
             prev_diag2 = cep->diag2[i];
@@ -1120,24 +1122,33 @@ static picoos_uint8 makeWUWandWUm(cep_subobj_t * cep, picokpdf_PdfMUL pdf,
 /**
  * Retrieve actual values for MGC from PDF resource
  * @param    pdf :  pointer to picoos_uint8, sequence of pdf vectors, each vector of length 1+ceporder*2+numdeltas*3+ceporder*3
- * @param    vecstart : indices of pdf vectors for all frames in current sentence
+ * @param    vecindex : index of the pdf vector
  * @param    cepnum :  cepstral dimension to be treated
  * @param    wantMeanOrIvar :  flag to select mean or variance values
  * @param    wantStaticOrDeltax :  flag to select static or delta values
  * @return  the actual value retrieved
+ * @remarks  uses the load-time expanded pdf if there is one
  * @callgraph
  * @callergraph
  */
-static picoos_int32 getFromPdf(picokpdf_PdfMUL pdf, picoos_uint32 vecstart,
+static picoos_int32 getFromPdf(picokpdf_PdfMUL pdf, picoos_uint16 vecindex,
         picoos_uint8 cepnum, picocep_WantMeanOrIvar_t wantMeanOrIvar,
         picocep_WantStaticOrDelta_t wantStaticOrDeltax)
 {
     picoos_uint8 s, ind;
     picoos_uint8 *p;
     picoos_uint8 ceporder, ceporder2, cc;
-    picoos_uint32 k;
+    picoos_uint32 k, vecstart;
     picoos_int32 mean = 0, ivar = 0;
 
+    if (NULL != pdf->expanded) {
+        /* means then ivars, each static, delta, deltadelta */
+        return pdf->expanded[((picoos_uint32) vecindex
+                * PICOKPDF_MUL_EXPANDED_STREAMS + wantMeanOrIvar * 3
+                + wantStaticOrDeltax) * pdf->ceporder + cepnum];
+    }
+    vecstart = (picoos_uint32) vecindex * pdf->vecsize;
+
     if (pdf->numdeltas == 0xFF) {
         switch (wantMeanOrIvar) {
             case PICOCEP_WANTMEAN:
@@ -1307,10 +1318,9 @@ static void getDirect(picokpdf_PdfMUL pdf, picoos_uint16 *indices,
 {
     picoos_uint16 i;
     picoos_uint32 j;
-    picoos_uint32 vecstart;
+    picoos_uint16 vecindex;
     picoos_int32 mean, ivar;
     picoos_int32 prev_mean;
-    picoos_uint8 vecsize = pdf->vecsize;
     picoos_uint8 order = pdf->ceporder;
 
     j = cepnum;
@@ -1319,10 +1329,10 @@ static void getDirect(picokpdf_PdfMUL pdf, picoos_uint16 *indices,
         if (i > 0 && indices[i] == indices[i - 1]) {
             mean = prev_mean;
         } else {
-            vecstart = indices[i] * vecsize;
-            mean = getFromPdf(pdf, vecstart, cepnum, PICOCEP_WANTMEAN,
+            vecindex = indices[i];
+            mean = getFromPdf(pdf, vecindex, cepnum, PICOCEP_WANTMEAN,
                     PICOCEP_WANTSTATIC);
-            ivar = getFromPdf(pdf, vecstart, cepnum, PICOCEP_WANTIVAR,
+            ivar = getFromPdf(pdf, vecindex, cepnum, PICOCEP_WANTIVAR,
                     PICOCEP_WANTSTATIC);
             prev_mean = mean = picocep_fixptdiv(mean, ivar, pdf->bigpow);
         }
@@ -1385,6 +1395,7 @@ static void treat_phone(cep_subobj_t * cep, picodata_itemhead_t * ihead)
     picoos_uint16 indlfz, indmgc;
     picoos_uint16 pos;
     picoos_uint8  bufferFull;
+    picoos_uint16 phoneId;
 
     /* treat all states
      *    for each state, repeat putting the index into the index buffer framesperstate times.
@@ -1404,6 +1415,14 @@ static void treat_phone(cep_subobj_t * cep, picodata_itemhead_t * ihead)
     /*  */
     PICODBG_DEBUG(("PARSE starting with frame %i",frame));
 
+    /* the flags follow the states, if there are any; they go with the phone's
+     * first frame, or the next phone's if this one has none */
+    if (ihead->len > ihead->info2 * 6) {
+        cep->phoneFlags |= cep->inBuf[cep->inReadPos + PICODATA_ITEM_HEADSIZE
+                + ihead->info2 * 6];
+    }
+    phoneId = ihead->info1 | ((cep->phoneFlags | PICODATA_PHONEFLAG_BEGIN) << 8);
+
     bufferFull = cep->indexWritePos >= PICOCEP_MAXWINLEN;
     while ((state < ihead->info2) && (bufferFull == FALSE)) {
 
@@ -1426,8 +1445,10 @@ static void treat_phone(cep_subobj_t * cep, picodata_itemhead_t * ihead)
         while (frame < frames) {
             cep->indicesMGC[cep->indexWritePos] = indmgc;
             cep->indicesLFZ[cep->indexWritePos] = indlfz;
-            cep->phoneId[cep->indexWritePos] = ihead->info1;
+            cep->phoneId[cep->indexWritePos] = phoneId;
             cep->indexWritePos++;
+            cep->phoneFlags = 0;
+            phoneId = ihead->info1;
             frame++;
         }
         /* proceed to next state */
@@ -1817,11 +1838,10 @@ static picodata_step_result_t cepStep(register picodata_ProcessingUnit this,
                         picoos_uint16 i;
 
                         /* */
-                        PICODBG_DEBUG(("FRAME reading phoneId[%i] = %c:",cep->indexReadPos, cep->phoneId[cep->indexReadPos]));
+                        PICODBG_DEBUG(("FRAME reading phoneId[%i] = %c:",cep->indexReadPos, cep->phoneId[cep->indexReadPos] & 0xff));
                         /* */
 
-                        tmpUint16
-                                = (picoos_uint16) cep->phoneId[cep->indexReadPos];
+                        tmpUint16 = cep->phoneId[cep->indexReadPos];
 
                         picoos_mem_copy((void *) &tmpUint16,
                                 (void *) &cep->outBuf[cep->outWritePos],
@@ -77,11 +77,34 @@ typedef struct ctrl_subobj {
     picoos_uint8 numProcUnits;
     picoos_uint8 curPU;
     picoos_uint8 lastItemTypeProduced;
+    picoos_bool lazyInit; /* construct sub-PUs when first scheduled */
     picodata_ProcessingUnit procUnit [PICOCTRL_MAX_PROC_UNITS];
     picodata_step_result_t procStatus [PICOCTRL_MAX_PROC_UNITS];
     picodata_CharBuffer procCbOut [PICOCTRL_MAX_PROC_UNITS];
+    picodata_putype_t procType [PICOCTRL_MAX_PROC_UNITS];
+    picoos_uint32 procStartupTime [PICOCTRL_MAX_PROC_UNITS]; /* usec */
 } ctrl_subobj_t;
 
+static const picoos_char * ctrlPUNames[] = {
+    (picoos_char *) "text",
+    (picoos_char *) "tok",
+    (picoos_char *) "pr",
+    (picoos_char *) "wa",
+    (picoos_char *) "sa",
+    (picoos_char *) "acph",
+    (picoos_char *) "spho",
+    (picoos_char *) "pam",
+    (picoos_char *) "cep",
+    (picoos_char *) "sig",
+    (picoos_char *) "sink"
+};
+
+static pico_status_t ctrlNewPU(register picodata_ProcessingUnit this,
+        picoos_uint8 pu);
+
+/* one hook for all engines, NULL unless tracing */
+static picoctrl_StepTraceHook ctrlStepTraceHook = NULL;
+
 /**
  * performs Control PU initialization
  * @param    this : pointer to Control PU
@@ -103,7 +126,8 @@ static pico_status_t ctrlInitialize(register picodata_ProcessingUnit this, picoo
     ctrl->lastItemTypeProduced=0;    /*no item produced by default*/
     status = PICO_OK;
     for (i = 0; i < ctrl->numProcUnits; i++) {
-        if (PICO_OK == status) {
+        /* PUs not constructed yet are initialized when they are */
+        if ((PICO_OK == status) && (NULL != ctrl->procUnit[i])) {
             status = ctrl->procUnit[i]->initialize(ctrl->procUnit[i], resetMode);
             PICODBG_DEBUG(("(re-)initializing procUnit[%i] returned status %i",i, status));
         }
@@ -147,12 +171,33 @@ static picodata_step_result_t ctrlStep(register picodata_ProcessingUnit this,
     *bytesOutput = 0;
     ctrl->lastItemTypeProduced=0; /*no item produced by default*/
 
+    if (NULL != ctrlStepTraceHook) {
+        ctrlStepTraceHook(ctrlPUNames[ctrl->procType[ctrl->curPU]], 1);
+    }
+
+    /* with lazy initialization, a pu is constructed when first scheduled */
+    if (NULL == ctrl->procUnit[ctrl->curPU]) {
+        if (PICO_OK != ctrlNewPU(this, ctrl->curPU)) {
+            picoos_emRaiseException(this->common->em, PICO_EXC_OUT_OF_MEM, NULL,
+                    (picoos_char *) "constructing processing unit %s",
+                    ctrlPUNames[ctrl->procType[ctrl->curPU]]);
+            if (NULL != ctrlStepTraceHook) {
+                ctrlStepTraceHook(ctrlPUNames[ctrl->procType[ctrl->curPU]], 0);
+            }
+            return PICODATA_PU_ERROR;
+        }
+    }
+
     /* --------------------- */
     /* do step of current pu */
     /* --------------------- */
     status = ctrl->procStatus[ctrl->curPU] = ctrl->procUnit[ctrl->curPU]->step(
             ctrl->procUnit[ctrl->curPU], mode, &puBytesOutput);
 
+    if (NULL != ctrlStepTraceHook) {
+        ctrlStepTraceHook(ctrlPUNames[ctrl->procType[ctrl->curPU]], 0);
+    }
+
     if (puBytesOutput) {
 
 #if defined(PICO_DEVEL_MODE)
@@ -242,6 +287,9 @@ static pico_status_t ctrlTerminate(register picodata_ProcessingUnit this) {
     }
     ctrl = (ctrl_subobj_t *) this->subObj;
     for (i = 0; i < ctrl->numProcUnits; i++) {
+        if (NULL == ctrl->procUnit[i]) {
+            continue;
+        }
         status = ctrl->procUnit[i]->terminate(ctrl->procUnit[i]);
         PICODBG_DEBUG(("terminating procUnit[%i] returned status %i",i, status));
         if (PICO_OK != status) {
@@ -280,6 +328,96 @@ static pico_status_t ctrlSubObjDeallocate(register picodata_ProcessingUnit this,
     return PICO_OK;
 }/*ctrlSubObjDeallocate*/
 
+/**
+ * constructs (and thereby initializes) sub-PU 'pu' of the TTS processing chain
+ * @param    this : pointer to Control PU
+ * @param    pu : index of the PU, whose type and output buffer are set already
+ * @return    PICO_OK : processing done
+ * @return    PICO_EXC_OUT_OF_MEM : no more memory available
+ * @remarks    Calls the PU object creation method and records the time it took
+ * @callgraph
+ * @callergraph
+ */
+static pico_status_t ctrlNewPU(register picodata_ProcessingUnit this,
+        picoos_uint8 pu)
+{
+    register ctrl_subobj_t * ctrl = (ctrl_subobj_t *) this->subObj;
+    picodata_CharBuffer cbIn;
+    picoos_uint32 sec0, usec0, sec1, usec1;
+
+    if (0 == pu) {
+        cbIn = this->cbIn;
+    } else {
+        cbIn = ctrl->procCbOut[pu-1];
+    }
+    picoos_get_timer(&sec0, &usec0);
+    switch (ctrl->procType[pu]) {
+    case PICODATA_PUTYPE_TOK:
+            PICODBG_DEBUG(("creating TokenizeUnit for pu %i", pu));
+            ctrl->procUnit[pu] = picotok_newTokenizeUnit(this->common->mm,
+                    this->common, cbIn, ctrl->procCbOut[pu], this->voice);
+        break;
+    case PICODATA_PUTYPE_PR:
+            PICODBG_DEBUG(("creating PreprocUnit for pu %i", pu));
+            ctrl->procUnit[pu] = picopr_newPreprocUnit(this->common->mm,
+                    this->common, cbIn, ctrl->procCbOut[pu], this->voice);
+        break;
+    case PICODATA_PUTYPE_WA:
+            PICODBG_DEBUG(("creating WordAnaUnit for pu %i", pu));
+            ctrl->procUnit[pu] = picowa_newWordAnaUnit(this->common->mm,
+                    this->common, cbIn, ctrl->procCbOut[pu], this->voice);
+        break;
+    case PICODATA_PUTYPE_SA:
+            PICODBG_DEBUG(("creating SentAnaUnit for pu %i", pu));
+            ctrl->procUnit[pu] = picosa_newSentAnaUnit(this->common->mm,
+                    this->common, cbIn, ctrl->procCbOut[pu], this->voice);
+        break;
+    case PICODATA_PUTYPE_ACPH:
+            PICODBG_DEBUG(("creating AccPhrUnit for pu %i", pu));
+            ctrl->procUnit[pu] = picoacph_newAccPhrUnit(this->common->mm,
+                    this->common, cbIn, ctrl->procCbOut[pu], this->voice);
+        break;
+    case PICODATA_PUTYPE_SPHO:
+            PICODBG_DEBUG(("creating SentPhoUnit for pu %i", pu));
+            ctrl->procUnit[pu] = picospho_newSentPhoUnit(this->common->mm,
+                    this->common, cbIn, ctrl->procCbOut[pu], this->voice);
+            break;
+    case PICODATA_PUTYPE_PAM:
+            PICODBG_DEBUG(("creating PAMUnit for pu %i", pu));
+            ctrl->procUnit[pu] = picopam_newPamUnit(this->common->mm,
+                    this->common, cbIn, ctrl->procCbOut[pu], this->voice);
+        break;
+    case PICODATA_PUTYPE_CEP:
+            PICODBG_DEBUG(("creating CepUnit for pu %i", pu));
+            ctrl->procUnit[pu] = picocep_newCepUnit(this->common->mm,
+                    this->common, cbIn, ctrl->procCbOut[pu], this->voice);
+        break;
+#if defined(PICO_DEVEL_MODE)
+        case PICODATA_PUTYPE_SINK:
+            PICODBG_DEBUG(("creating SigUnit for pu %i", pu));
+            ctrl->procUnit[pu] = picosink_newSinkUnit(this->common->mm,
+                    this->common, cbIn, ctrl->procCbOut[pu], this->voice);
+        break;
+#endif
+        case PICODATA_PUTYPE_SIG:
+            PICODBG_DEBUG(("creating SigUnit for pu %i", pu));
+            ctrl->procUnit[pu] = picosig_newSigUnit(this->common->mm,
+                    this->common, cbIn, ctrl->procCbOut[pu], this->voice);
+        break;
+    default:
+            ctrl->procUnit[pu] = picodata_newProcessingUnit(
+                    this->common->mm, this->common, cbIn,
+                    ctrl->procCbOut[pu], this->voice);
+        break;
+    }
+    picoos_get_timer(&sec1, &usec1);
+    ctrl->procStartupTime[pu] = (sec1 - sec0) * 1000000 + usec1 - usec0;
+    if (NULL == ctrl->procUnit[pu]) {
+        return PICO_EXC_OUT_OF_MEM;
+    }
+    return PICO_OK;
+}/*ctrlNewPU*/
+
 /**
  * inserts a new PU in the TTS processing chain
  * @param    this : pointer to Control PU
@@ -288,7 +426,8 @@ static pico_status_t ctrlSubObjDeallocate(register picodata_ProcessingUnit this,
  * @return    PICO_OK : processing done
  * @return    PICO_EXC_OUT_OF_MEM : no more memory available
  * @return    PICO_ERR_OTHER : other error
- * @remarks    Calls the PU object creation method
+ * @remarks    Calls the PU object creation method, unless the Control PU
+ *             initializes lazily; then only the output buffer is created
  * @callgraph
  * @callergraph
  */
@@ -299,7 +438,6 @@ static pico_status_t ctrlAddPU(register picodata_ProcessingUnit this,
 {
     picoos_uint16 bufSize;
     register ctrl_subobj_t * ctrl;
-    picodata_CharBuffer cbIn;
     picoos_uint8 newPU;
     if (this == NULL) {
         return PICO_ERR_OTHER;
@@ -309,13 +447,6 @@ static pico_status_t ctrlAddPU(register picodata_ProcessingUnit this,
         return PICO_ERR_OTHER;
     }
     newPU = ctrl->numProcUnits;
-    if (0 == newPU) {
-        PICODBG_DEBUG(("taking cbIn of this because adding first pu"));
-        cbIn = this->cbIn;
-    } else {
-        PICODBG_DEBUG(("taking cbIn of previous pu"));
-        cbIn = ctrl->procCbOut[newPU-1];
-    }
     if (last) {
         PICODBG_DEBUG(("taking cbOut of this because adding last pu"));
         ctrl->procCbOut[newPU] = this->cbOut;
@@ -332,68 +463,12 @@ static pico_status_t ctrlAddPU(register picodata_ProcessingUnit this,
         }
     }
     ctrl->procStatus[newPU] = PICODATA_PU_IDLE;
-    /*...............*/
-    switch (puType) {
-    case PICODATA_PUTYPE_TOK:
-            PICODBG_DEBUG(("creating TokenizeUnit for pu %i", newPU));
-            ctrl->procUnit[newPU] = picotok_newTokenizeUnit(this->common->mm,
-                    this->common, cbIn, ctrl->procCbOut[newPU], this->voice);
-        break;
-    case PICODATA_PUTYPE_PR:
-            PICODBG_DEBUG(("creating PreprocUnit for pu %i", newPU));
-            ctrl->procUnit[newPU] = picopr_newPreprocUnit(this->common->mm,
-                    this->common, cbIn, ctrl->procCbOut[newPU], this->voice);
-        break;
-    case PICODATA_PUTYPE_WA:
-            PICODBG_DEBUG(("creating WordAnaUnit for pu %i", newPU));
-            ctrl->procUnit[newPU] = picowa_newWordAnaUnit(this->common->mm,
-                    this->common, cbIn, ctrl->procCbOut[newPU], this->voice);
-        break;
-    case PICODATA_PUTYPE_SA:
-            PICODBG_DEBUG(("creating SentAnaUnit for pu %i", newPU));
-            ctrl->procUnit[newPU] = picosa_newSentAnaUnit(this->common->mm,
-                    this->common, cbIn, ctrl->procCbOut[newPU], this->voice);
-        break;
-    case PICODATA_PUTYPE_ACPH:
-            PICODBG_DEBUG(("creating AccPhrUnit for pu %i", newPU));
-            ctrl->procUnit[newPU] = picoacph_newAccPhrUnit(this->common->mm,
-                    this->common, cbIn, ctrl->procCbOut[newPU], this->voice);
-        break;
-    case PICODATA_PUTYPE_SPHO:
-            PICODBG_DEBUG(("creating SentPhoUnit for pu %i", newPU));
-            ctrl->procUnit[newPU] = picospho_newSentPhoUnit(this->common->mm,
-                    this->common, cbIn, ctrl->procCbOut[newPU], this->voice);
-            break;
-    case PICODATA_PUTYPE_PAM:
-            PICODBG_DEBUG(("creating PAMUnit for pu %i", newPU));
-            ctrl->procUnit[newPU] = picopam_newPamUnit(this->common->mm,
-                    this->common, cbIn, ctrl->procCbOut[newPU], this->voice);
-        break;
-    case PICODATA_PUTYPE_CEP:
-            PICODBG_DEBUG(("creating CepUnit for pu %i", newPU));
-            ctrl->procUnit[newPU] = picocep_newCepUnit(this->common->mm,
-                    this->common, cbIn, ctrl->procCbOut[newPU], this->voice);
-        break;
-#if defined(PICO_DEVEL_MODE)
-        case PICODATA_PUTYPE_SINK:
-            PICODBG_DEBUG(("creating SigUnit for pu %i", newPU));
-            ctrl->procUnit[newPU] = picosink_newSinkUnit(this->common->mm,
-                    this->common, cbIn, ctrl->procCbOut[newPU], this->voice);
-        break;
-#endif
-        case PICODATA_PUTYPE_SIG:
-            PICODBG_DEBUG(("creating SigUnit for pu %i", newPU));
-            ctrl->procUnit[newPU] = picosig_newSigUnit(this->common->mm,
-                    this->common, cbIn, ctrl->procCbOut[newPU], this->voice);
-        break;
-    default:
-            ctrl->procUnit[newPU] = picodata_newProcessingUnit(
-                    this->common->mm, this->common, cbIn,
-                    ctrl->procCbOut[newPU], this->voice);
-        break;
-    }
-    if (NULL == ctrl->procUnit[newPU]) {
-        picodata_disposeCharBuffer(this->common->mm,&ctrl->procCbOut[newPU]);
+    ctrl->procType[newPU] = puType;
+    ctrl->procStartupTime[newPU] = 0;
+    if (!ctrl->lazyInit && (PICO_OK != ctrlNewPU(this, newPU))) {
+        if (!last) {
+            picodata_disposeCharBuffer(this->common->mm,&ctrl->procCbOut[newPU]);
+        }
         return PICO_EXC_OUT_OF_MEM;
     }
     ctrl->numProcUnits++;
@@ -411,6 +486,7 @@ void picoctrl_disposeControl(picoos_MemoryManager mm,
  * @param    cbIn : the input char buffer
  * @param    cbOut : the output char buffer
  * @param    voice : the voice object
+ * @param    lazyInit : if true, sub-PUs are constructed when first scheduled
  * @return    the pointer to the PU object created if OK
  * @return    PICO_EXC_OUT_OF_MEM : no more memory available
  * @return    NULL otherwise
@@ -419,7 +495,8 @@ void picoctrl_disposeControl(picoos_MemoryManager mm,
  */
 picodata_ProcessingUnit picoctrl_newControl(picoos_MemoryManager mm,
         picoos_Common common, picodata_CharBuffer cbIn,
-        picodata_CharBuffer cbOut, picorsrc_Voice voice) {
+        picodata_CharBuffer cbOut, picorsrc_Voice voice,
+        picoos_bool lazyInit) {
     picoos_int16 i;
     register ctrl_subobj_t * ctrl;
     picodata_ProcessingUnit this = picodata_newProcessingUnit(mm, common, cbIn,
@@ -445,8 +522,11 @@ picodata_ProcessingUnit picoctrl_newControl(picoos_MemoryManager mm,
         ctrl->procUnit[i] = NULL;
         ctrl->procStatus[i] = PICODATA_PU_IDLE;
         ctrl->procCbOut[i] = NULL;
+        ctrl->procType[i] = PICODATA_PUTYPE_TEXT;
+        ctrl->procStartupTime[i] = 0;
     }
     ctrl->numProcUnits = 0;
+    ctrl->lazyInit = lazyInit;
 
     if (
             (PICO_OK == ctrlAddPU(this,PICODATA_PUTYPE_TOK, FALSE, /*last*/FALSE)) &&
@@ -498,6 +578,7 @@ void picoctrl_disposeControl(picoos_MemoryManager mm,
 typedef struct picoctrl_engine {
     picoos_uint32 magic;        /* magic number used to validate handles */
     void *raw_mem;
+    picoos_objsize_t memSize;   /* size of raw_mem */
     picoos_Common common;
     picorsrc_Voice voice;
     picodata_ProcessingUnit control;
@@ -565,6 +646,10 @@ picoos_int16 picoctrl_isValidEngineHandle(picoctrl_Engine this)
  * @param    mm : memory manager to be used for this engine
  * @param    rm : resource manager to be used for this engine
  * @param    voiceName : voice definition to be used for this engine
+ * @param    lazyInit : if true, the processing units are constructed when
+ *           the first item reaches them instead of here
+ * @param    engineSize : size of the engine's private memory, taken from mm;
+ *           0 for PICOCTRL_DEFAULT_ENGINE_SIZE
  * @return    PICO_OK : reset performed
  * @return    new engine handle
  * @return  NULL otherwise
@@ -572,7 +657,8 @@ picoos_int16 picoctrl_isValidEngineHandle(picoctrl_Engine this)
  * @callergraph
  */
 picoctrl_Engine picoctrl_newEngine(picoos_MemoryManager mm,
-        picorsrc_ResourceManager rm, const picoos_char * voiceName) {
+        picorsrc_ResourceManager rm, const picoos_char * voiceName,
+        picoos_bool lazyInit, picoos_objsize_t engineSize) {
     picoos_uint8 done= TRUE;
 
     picoos_uint16 bSize;
@@ -594,14 +680,15 @@ picoctrl_Engine picoctrl_newEngine(picoos_MemoryManager mm,
         this->cbIn = NULL;
         this->cbOut = NULL;
 
-        this->raw_mem = picoos_allocate(mm, PICOCTRL_DEFAULT_ENGINE_SIZE);
+        this->memSize = (engineSize > 0) ? engineSize : PICOCTRL_DEFAULT_ENGINE_SIZE;
+        this->raw_mem = picoos_allocate(mm, this->memSize);
         if (NULL == this->raw_mem) {
             done = FALSE;
         }
     }
 
     if (done) {
-        engMM = picoos_newMemoryManager(this->raw_mem, PICOCTRL_DEFAULT_ENGINE_SIZE,
+        engMM = picoos_newMemoryManager(this->raw_mem, this->memSize,
                     /*enableMemProt*/ FALSE);
         done = (NULL != engMM);
     }
@@ -630,7 +717,7 @@ picoctrl_Engine picoctrl_newEngine(picoos_MemoryManager mm,
 
 
         this->control = picoctrl_newControl(this->common->mm, this->common,
-                this->cbIn, this->cbOut, this->voice);
+                this->cbIn, this->cbOut, this->voice, lazyInit);
         done = (NULL != this->cbIn) && (NULL != this->cbOut)
                 && (NULL != this->control);
     }
@@ -709,6 +796,21 @@ picoos_Common picoctrl_engGetCommon(picoctrl_Engine this) {
     }
 }/*picoctrl_engGetCommon*/
 
+/**
+ * returns the size of the engine's private memory
+ * @param    this : handle of the engine
+ * @return    size in bytes, 0 if error
+ * @callgraph
+ * @callergraph
+ */
+picoos_objsize_t picoctrl_engGetMemSize(picoctrl_Engine this) {
+    if (NULL == this) {
+        return 0;
+    } else {
+        return this->memSize;
+    }
+}/*picoctrl_engGetMemSize*/
+
 /**
  * feed raw 'text' into 'engine'. text may contain '\\0'.
  * @param    this : handle of the engine
@@ -832,6 +934,58 @@ picodata_step_result_t picoctrl_getLastProducedItemType(
     return (picodata_step_result_t) ctrl->lastItemTypeProduced;
 }/*picoctrl_getLastProducedItemType*/
 
+/**
+ * returns the startup profile of a processing unit of the engine
+ * @param    this : handle of the engine
+ * @param    pu : index of the PU in the TTS processing chain
+ * @param    name : short name of the PU type (output)
+ * @param    constructed : whether the PU has been constructed already (output)
+ * @param    usec : processor time spent constructing and initializing
+ *           the PU, in microseconds (output)
+ * @return    PICO_OK : profile returned
+ * @return    PICO_ERR_INDEX_OUT_OF_RANGE : no PU with index 'pu'
+ * @remarks    with lazy initialization, PUs are constructed when the first
+ *             item reaches them
+ * @callgraph
+ * @callergraph
+ */
+pico_status_t picoctrl_getPUStartupProfile(
+        picoctrl_Engine this,
+        picoos_uint8 pu,
+        const picoos_char ** name,
+        picoos_bool * constructed,
+        picoos_uint32 * usec
+        )
+{
+    ctrl_subobj_t * ctrl;
+    if (NULL == this || NULL == this->control->subObj) {
+        return PICO_ERR_OTHER;
+    }
+    ctrl = (ctrl_subobj_t *) ((*this).control->subObj);
+    if (pu >= ctrl->numProcUnits) {
+        return PICO_ERR_INDEX_OUT_OF_RANGE;
+    }
+    *name = ctrlPUNames[ctrl->procType[pu]];
+    *constructed = (NULL != ctrl->procUnit[pu]);
+    *usec = ctrl->procStartupTime[pu];
+    return PICO_OK;
+}/*picoctrl_getPUStartupProfile*/
+
+/**
+ * sets the function called before and after each step of a processing unit
+ * of any engine, with the short name of the PU type
+ * @param    hook : the function, NULL to stop tracing
+ * @remarks    the name is a static string
+ * @callgraph
+ * @callergraph
+ */
+void picoctrl_setStepTraceHook(
+        picoctrl_StepTraceHook hook
+        )
+{
+    ctrlStepTraceHook = hook;
+}/*picoctrl_setStepTraceHook*/
+
 
 #ifdef __cplusplus
 }
@@ -53,7 +53,9 @@ picoos_int16 picoctrl_isValidEngineHandle(picoctrl_Engine that);
 picoctrl_Engine picoctrl_newEngine (
         picoos_MemoryManager mm,
         picorsrc_ResourceManager rm,
-        const picoos_char * voiceName
+        const picoos_char * voiceName,
+        picoos_bool lazyInit,
+        picoos_objsize_t engineSize
         );
 
 void picoctrl_disposeEngine(
@@ -74,6 +76,8 @@ pico_status_t picoctrl_engReset(
 
 picoos_Common picoctrl_engGetCommon(picoctrl_Engine that);
 
+picoos_objsize_t picoctrl_engGetMemSize(picoctrl_Engine that);
+
 picodata_step_result_t picoctrl_engFetchOutputItemBytes(
         picoctrl_Engine engine,
         picoos_char * buffer,
@@ -94,6 +98,21 @@ picodata_step_result_t picoctrl_getLastProducedItemType(
         picoctrl_Engine engine
         );
 
+pico_status_t picoctrl_getPUStartupProfile(
+        picoctrl_Engine engine,
+        picoos_uint8 pu,
+        const picoos_char ** name,
+        picoos_bool * constructed,
+        picoos_uint32 * usec
+        );
+
+/* called around each step of a processing unit, see picoext_setStepTraceHook */
+typedef void (* picoctrl_StepTraceHook)(const picoos_char * puName, picoos_int16 begin);
+
+void picoctrl_setStepTraceHook(
+        picoctrl_StepTraceHook hook
+        );
+
 #ifdef __cplusplus
 }
 #endif
@@ -142,12 +142,58 @@ void picodata_disposeCharBuffer(picoos_MemoryManager mm,
     }
 }
 
+/* copies 'n' bytes from 'src' to the rear of 'this'; there must be room */
+static void data_cbWrite(register picodata_CharBuffer this,
+                         const picoos_uint8 *src, picoos_uint16 n)
+{
+    picoos_uint16 n1;
+
+    n1 = this->size - this->rear;
+    if (n < n1) {
+        n1 = n;
+    }
+    picoos_mem_copy(src, this->buf + this->rear, n1);
+    if (n1 < n) {    /* wrap around */
+        picoos_mem_copy(src + n1, this->buf, n - n1);
+    }
+    this->rear += n;
+    if (this->rear >= this->size) {
+        this->rear -= this->size;
+    }
+    this->len += n;
+}
+
+/* drops 'n' bytes from the front of 'this'; copies them to 'dst' if not NULL */
+static void data_cbRead(register picodata_CharBuffer this,
+                        picoos_uint8 *dst, picoos_uint16 n)
+{
+    picoos_uint16 n1;
+
+    if (NULL != dst) {
+        n1 = this->size - this->front;
+        if (n < n1) {
+            n1 = n;
+        }
+        picoos_mem_copy(this->buf + this->front, dst, n1);
+        if (n1 < n) {    /* wrap around */
+            picoos_mem_copy(this->buf, dst + n1, n - n1);
+        }
+    }
+    this->front += n;
+    if (this->front >= this->size) {
+        this->front -= this->size;
+    }
+    this->len -= n;
+}
+
 pico_status_t picodata_cbPutCh(register picodata_CharBuffer this,
                                picoos_char ch)
 {
     if (this->len < this->size) {
         this->buf[this->rear++] = ch;
-        this->rear %= this->size;
+        if (this->rear == this->size) {
+            this->rear = 0;
+        }
         this->len++;
         return PICO_OK;
     } else {
@@ -161,7 +207,9 @@ picoos_int16 picodata_cbGetCh(register picodata_CharBuffer this)
     picoos_char ch;
     if (this->len > 0) {
         ch = this->buf[this->front++];
-        this->front %= this->size;
+        if (this->front == this->size) {
+            this->front = 0;
+        }
         this->len--;
         return ch;
     } else {
@@ -177,7 +225,10 @@ static pico_status_t data_cbGetItem(register picodata_CharBuffer this,
         picoos_uint8 *buf, const picoos_uint16 blenmax,
         picoos_uint16 *blen, const picoos_uint8 issd)
 {
+    picoos_uint16 lenPos;
+#if defined(PICO_DEBUG)
     picoos_uint16 i;
+#endif
 
     if (this->len < PICODATA_ITEM_HEADSIZE) {    /* item not in cb? */
         *blen = 0;
@@ -189,8 +240,12 @@ static pico_status_t data_cbGetItem(register picodata_CharBuffer this,
         }
         return PICO_EXC_BUF_UNDERFLOW;
     }
-    *blen = PICODATA_ITEM_HEADSIZE + (picoos_uint8)(this->buf[((this->front) +
-                                      PICODATA_ITEMIND_LEN) % this->size]);
+    /* the head may wrap around the end of the ring */
+    lenPos = this->front + PICODATA_ITEMIND_LEN;
+    if (lenPos >= this->size) {
+        lenPos -= this->size;
+    }
+    *blen = PICODATA_ITEM_HEADSIZE + (picoos_uint8)(this->buf[lenPos]);
 
     /* if getting speech data in item */
     if (issd) {
@@ -198,11 +253,10 @@ static pico_status_t data_cbGetItem(register picodata_CharBuffer this,
         if (this->buf[this->front] != PICODATA_ITEM_FRAME) {
             PICODBG_WARN(("item type mismatch for speech data: %c",
                           this->buf[this->front]));
-            for (i=0; i<*blen; i++) {
-                this->front++;
-                this->front %= this->size;
-                this->len--;
+            if (*blen > this->len) {
+                *blen = this->len;
             }
+            data_cbRead(this, NULL, *blen);
             *blen = 0;
             return PICO_OK;
         }
@@ -223,20 +277,12 @@ static pico_status_t data_cbGetItem(register picodata_CharBuffer this,
     /* if getting speech data in item */
     if (issd) {
         /* skip item header */
-        for (i = 0; i < PICODATA_ITEM_HEADSIZE; i++) {
-            this->front++;
-            this->front %= this->size;
-            this->len--;
-        }
+        data_cbRead(this, NULL, PICODATA_ITEM_HEADSIZE);
         *blen -= PICODATA_ITEM_HEADSIZE;
     }
 
     /* all ok, now get item (or speech data only) */
-    for (i = 0; i < *blen; i++) {
-        buf[i] = (picoos_uint8)(this->buf[this->front++]);
-        this->front %= this->size;
-        this->len--;
-    }
+    data_cbRead(this, buf, *blen);
 
 #if defined(PICO_DEBUG)
     if (issd) {
@@ -262,7 +308,9 @@ static pico_status_t data_cbPutItem(register picodata_CharBuffer this,
         const picoos_uint8 *buf, const picoos_uint16 blenmax,
         picoos_uint16 *blen)
 {
+#if defined(PICO_DEBUG)
     picoos_uint16 i;
+#endif
 
     if (blenmax < PICODATA_ITEM_HEADSIZE) {    /* itemlen not accessible? */
         PICODBG_WARN(("problem putting item, underflow"));
@@ -297,12 +345,7 @@ static pico_status_t data_cbPutItem(register picodata_CharBuffer this,
     }
 #endif
 
-    for (i = 0; i < *blen; i++) {
-        /* put single byte */
-        this->buf[this->rear++] = (picoos_char)buf[i];
-        this->rear %= this->size;
-        this->len++;
-    }
+    data_cbWrite(this, buf, *blen);
     return PICO_OK;
 }
 
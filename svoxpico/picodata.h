@@ -273,6 +273,8 @@ typedef struct picodata_itemhead
  * - iteminfo1 : phonId : the phonetic identity of the phone
  * - iteminfo2 : n_S_P_Phone : number of states per phoneme
  * - len for PHON item is ALWAYS > 0, if len==0 an error should be raised
+ * - content : per state the number of frames, lfz and mgc index (3 uint16),
+ *     then one byte of PICODATA_PHONEFLAG_* for the word and phone timing
  * \n------------------------- FRAME_PAR item type (PRODUCED BY CEP) --------
  * - iteminfo1 : format (float, fixed)
  * - iteminfo2 : vector size
@@ -283,6 +285,13 @@ typedef struct picodata_itemhead
  * - len for FRAME item is ALWAYS > 0, if len==0 an error should be raised
  *
  */
+/* PHONE item flags, the last content byte. CEP puts them, with
+   PICODATA_PHONEFLAG_BEGIN, in the high byte of the phone id of the first
+   FRAME_PAR of the phone; SIG reports the timing from there */
+#define PICODATA_PHONEFLAG_BEGIN  0x01  /* the first frame of a phone */
+#define PICODATA_PHONEFLAG_WORD   0x02  /* the first phone of a word */
+#define PICODATA_PHONEFLAG_PAUSE  0x04  /* a pause */
+
 #define PICODATA_ITEMINFO1_FRAME_PAR_DATA_FORMAT_FIXED  '\x78' /* 120 'x' fixed point */
 #define PICODATA_ITEMINFO1_FRAME_PAR_DATA_FORMAT_FLOAT  '\x66' /* 102 'f' floating point */
 
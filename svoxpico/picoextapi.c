@@ -28,6 +28,7 @@
 #include "picodefs.h"
 #include "picoos.h"
 #include "picoctrl.h"
+#include "picosig.h"
 #include "picodbg.h"
 #include "picoapi.h"
 #include "picoextapi.h"
@@ -51,6 +52,13 @@ extern pico_Status pico_initialize_priv(
         pico_Int16 enableMemProt,
         pico_System *system);
 
+extern pico_Status pico_newEngine_priv(
+        pico_System system,
+        const pico_Char *voiceName,
+        pico_Int16 lazyInit,
+        pico_Uint32 engineSize,
+        pico_Engine *outEngine);
+
 
 /* System initialization and termination functions ****************************/
 
@@ -66,6 +74,36 @@ PICO_FUNC picoext_initialize(
 }
 
 
+/* Engine creation ************************************************************/
+
+
+PICO_FUNC picoext_newEngine(
+        pico_System system,
+        const pico_Char *voiceName,
+        pico_Int16 lazyInit,
+        pico_Uint32 engineSize,
+        pico_Engine *outEngine
+        )
+{
+    return pico_newEngine_priv(system, voiceName, lazyInit, engineSize, outEngine);
+}
+
+
+/* Resource loading ***********************************************************/
+
+PICO_FUNC picoext_setExpandPdfs(
+        pico_System system,
+        pico_Int16 expand
+        )
+{
+    if (!is_valid_system_handle(system)) {
+        return PICO_ERR_INVALID_HANDLE;
+    }
+    picorsrc_setExpandPdfs(system->rm, (expand != 0) ? TRUE : FALSE);
+    return PICO_OK;
+}
+
+
 /* System and lingware inspection functions ***********************************/
 
 /* @todo : not supported yet */
@@ -203,6 +241,25 @@ PICO_FUNC picoext_getEngineMemUsage(
     return status;
 }
 
+
+PICO_FUNC picoext_getEngineMemSize(
+        pico_Engine engine,
+        pico_Uint32 *outSize
+        )
+{
+    pico_Status status = PICO_OK;
+
+    if (!picoctrl_isValidEngineHandle((picoctrl_Engine) engine)) {
+        status = PICO_ERR_INVALID_HANDLE;
+    } else if (outSize == NULL) {
+        status = PICO_ERR_NULLPTR_ACCESS;
+    } else {
+        *outSize = (pico_Uint32) picoctrl_engGetMemSize((picoctrl_Engine) engine);
+    }
+
+    return status;
+}
+
 PICO_FUNC picoext_getLastScheduledPU(
         pico_Engine engine
         )
@@ -221,6 +278,58 @@ PICO_FUNC picoext_getLastProducedItemType(
     return status;
 }
 
+PICO_FUNC picoext_getEngineStartupProfile(
+        pico_Engine engine,
+        pico_Int16 puIndex,
+        pico_Retstring outPuName,
+        pico_Int16 *outConstructed,
+        pico_Uint32 *outUsec
+        )
+{
+    pico_Status status = PICO_OK;
+    const picoos_char * name;
+    picoos_bool constructed;
+    picoos_uint32 usec;
+
+    if (!picoctrl_isValidEngineHandle((picoctrl_Engine) engine)) {
+        status = PICO_ERR_INVALID_HANDLE;
+    } else if ((outPuName == NULL) || (outConstructed == NULL) || (outUsec == NULL)) {
+        status = PICO_ERR_NULLPTR_ACCESS;
+    } else if ((puIndex < 0) || (puIndex > 255)) {
+        status = PICO_ERR_INDEX_OUT_OF_RANGE;
+    } else {
+        status = picoctrl_getPUStartupProfile((picoctrl_Engine) engine, (picoos_uint8) puIndex,
+                &name, &constructed, &usec);
+        if (PICO_OK == status) {
+            picoos_strlcpy((picoos_char *) outPuName, name, PICO_RETSTRINGSIZE);
+            *outConstructed = constructed ? 1 : 0;
+            *outUsec = usec;
+        }
+    }
+
+    return status;
+}
+
+/* Step tracing ***************************************************************/
+
+PICO_FUNC picoext_setStepTraceHook(
+        picoext_StepTraceHook hook
+        )
+{
+    picoctrl_setStepTraceHook((picoctrl_StepTraceHook) hook);
+    return PICO_OK;
+}
+
+/* Timing *********************************************************************/
+
+PICO_FUNC picoext_setTimingHook(
+        picoext_TimingHook hook
+        )
+{
+    picosig_setTimingHook((picosig_TimingHook) hook);
+    return PICO_OK;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -84,6 +84,35 @@ PICO_FUNC picoext_initialize(
         );
 
 
+/* Engine creation ************************************************************/
+
+/* Same as pico_newEngine, but allows to defer constructing the processing
+   units of the engine until the first item reaches each of them
+   (lazyInit != 0), and to choose the size of the engine's private memory,
+   which is taken from the system memory (engineSize, 0 for the default). */
+
+PICO_FUNC picoext_newEngine(
+        pico_System system,
+        const pico_Char *voiceName,
+        pico_Int16 lazyInit,
+        pico_Uint32 engineSize,
+        pico_Engine *outEngine
+        );
+
+
+/* Resource loading ***********************************************************/
+
+/* Expands the mul pdfs (lfz and mgc) of resources loaded afterwards into
+   int32 tables (expand != 0), which makes signal generation faster. This
+   needs about 2 MB more system memory for the shipped voices; a pdf that
+   doesn't fit leaving room for the engine stays compressed. Off by default. */
+
+PICO_FUNC picoext_setExpandPdfs(
+        pico_System system,
+        pico_Int16 expand
+        );
+
+
 /* System and lingware inspection functions ***********************************/
 
 /* Returns version information of the current Pico engine. */
@@ -147,6 +176,12 @@ PICO_FUNC picoext_getEngineMemUsage(
         pico_Int32 *outMaxUsedBytes
         );
 
+/* size of the engine's private memory, as given to picoext_newEngine */
+PICO_FUNC picoext_getEngineMemSize(
+        pico_Engine engine,
+        pico_Uint32 *outSize
+        );
+
 PICO_FUNC picoext_getLastScheduledPU(
         pico_Engine engine
         );
@@ -155,6 +190,55 @@ PICO_FUNC picoext_getLastProducedItemType(
         pico_Engine engine
         );
 
+/* Startup profile ************************************************************/
+
+/* Returns name, construction state and the processor time in microseconds
+   spent constructing processing unit 'puIndex' of the engine (0 is the
+   first unit of the processing chain). Returns PICO_ERR_INDEX_OUT_OF_RANGE
+   past the last unit. */
+
+PICO_FUNC picoext_getEngineStartupProfile(
+        pico_Engine engine,
+        pico_Int16 puIndex,
+        pico_Retstring outPuName,
+        pico_Int16 *outConstructed,
+        pico_Uint32 *outUsec
+        );
+
+/* Step tracing ***************************************************************/
+
+/* Calls 'hook' before (begin 1) and after (begin 0) each step of a processing
+   unit of any engine, with the unit's name, a static string. NULL, the
+   default, turns it off. Set it while no engine is running. */
+
+typedef void (* picoext_StepTraceHook)(const pico_Char * puName, pico_Int16 begin);
+
+PICO_FUNC picoext_setStepTraceHook(
+        picoext_StepTraceHook hook
+        );
+
+/* Timing *********************************************************************/
+
+/* Calls 'hook' with the timing of the speech of any engine, as it is made:
+   the start of each phone, with its phonetic id; WORD for the first phone of
+   a word, PAUSE for a pause; and the markers of <mark name="..."/>, with
+   their name, only valid during the call. 'sample' counts the samples the
+   engine put out before, since it was created or reset. The samples of a
+   phone follow a few frames later. NULL, the default, turns it off. Set it
+   while no engine is running. */
+
+#define PICOEXT_TIMING_PHONE 0
+#define PICOEXT_TIMING_WORD  1
+#define PICOEXT_TIMING_PAUSE 2
+#define PICOEXT_TIMING_MARK  3
+
+typedef void (* picoext_TimingHook)(pico_Int16 kind, pico_Int16 phone,
+        const pico_Char * name, pico_Uint32 sample);
+
+PICO_FUNC picoext_setTimingHook(
+        picoext_TimingHook hook
+        );
+
 #ifdef __cplusplus
 }
 #endif
@@ -462,7 +462,7 @@ void rdft(picoos_int32 n, picoos_int32 isgn, PICOFFTSG_FFTTYPE *a)
 }
 
 
-picoos_single norm_result(picoos_int32 m2, PICOFFTSG_FFTTYPE *tmpX, PICOFFTSG_FFTTYPE *norm_window)
+picoos_single norm_result(picoos_int32 m2, PICOFFTSG_FFTTYPE *tmpX, const PICOFFTSG_FFTTYPE *norm_window)
 {
     picoos_int16 nI;
     PICOFFTSG_FFTTYPE a,b, E;
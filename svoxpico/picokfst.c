@@ -54,6 +54,27 @@ extern "C" {
 
 typedef struct kfst_subobj * kfst_SubObj;
 
+/* expanded (decoded) form of the pair alphabet and of the input epsilon
+   transitions; built once at specialization time so that the access methods
+   below can index directly instead of decoding variable-length numbers from
+   the byte stream on every transition */
+
+typedef struct kfst_symcell {
+    picokfst_symid_t inSym;           /* input symbol of this cell */
+    picoos_int16 nextSameHash;        /* index of next cell with same hash value; -1 if none */
+    picoos_int32 firstPair;           /* index of first pair of this input symbol in 'pairs' */
+} kfst_symcell_t;
+
+typedef struct kfst_pair {
+    picokfst_symid_t outSym;          /* output symbol; PICOKFST_SYMID_ILLEG terminates pair list */
+    picokfst_class_t pairClass;       /* pair class */
+} kfst_pair_t;
+
+typedef struct kfst_epstrans {
+    picokfst_symid_t outSym;          /* output symbol; PICOKFST_SYMID_ILLEG terminates trans list */
+    picokfst_state_t endState;        /* end state of transition */
+} kfst_epstrans_t;
+
 typedef struct kfst_subobj{
     picoos_uint8 * fstStream;         /* the byte stream base address */
     picoos_int32 hdrLen;              /* length of file header */
@@ -67,6 +88,19 @@ typedef struct kfst_subobj{
     picoos_int32 transTabPos;         /* absolute address of the start of the transition table */
     picoos_int32 inEpsStateTabPos;    /* absolute address of the start of the input epsilon transition table */
     picoos_int32 accStateTabPos;      /* absolute address of the table of accepting states */
+
+    /* expanded tables; 'expanded' is FALSE if they could not be built, in which case
+       the access methods fall back to decoding the byte stream */
+    picoos_bool expanded;
+    picoos_uint8 * expandedMem;       /* single block holding all expanded tables */
+    picoos_int16 * alphaHashTab;      /* [alphaHashTabSize] first cell index per hash value; -1 if none */
+    kfst_symcell_t * symCells;        /* input symbol cells, chained by hash value */
+    kfst_pair_t * pairs;              /* pair lists of all input symbols, each terminated */
+    picokfst_state_t * transTab;      /* [nrStates * nrClasses] end states; NULL if 'transTab8' is used */
+    picoos_uint8 * transTab8;         /* one-byte transition table entries, read in place from stream */
+    picoos_int32 * inEpsStateTab;     /* [nrStates] index of first trans in 'epsTrans'; -1 if none */
+    kfst_epstrans_t * epsTrans;       /* input epsilon transition lists of all states, each terminated */
+    picoos_uint8 * accStateTab;       /* [nrStates] 1 if accepting state; read in place from stream */
 } kfst_subobj_t;
 
 
@@ -155,6 +189,8 @@ static pico_status_t kfstInitialize(register picoknow_KnowledgeBase this,
                 NULL);
     }
     kfst = (kfst_subobj_t *) this->subObj;
+    kfst->expanded = FALSE;
+    kfst->expandedMem = NULL;
 
     /* +CT+ */
     kfst->fstStream = this->base;
@@ -181,10 +217,179 @@ static pico_status_t kfstInitialize(register picoknow_KnowledgeBase this,
 }
 
 
+/* decodes the pair alphabet, transition table, input epsilon transitions and
+   accepting states into native arrays. If the memory for the expanded tables
+   cannot be allocated, the FST stays usable in its compressed form. */
+static void kfstExpand(kfst_subobj_t * kfst, picoos_MemoryManager mm)
+{
+    picoos_uint32 pos;
+    picoos_int32 offs, h, cellPos, val, nextOffs;
+    picoos_int32 nrCells, nrPairs, nrEps, nrTrans, i;
+    picoos_uint32 endState;
+    picoos_objsize_t size;
+    picoos_uint8 * mem;
+
+    kfst->expanded = FALSE;
+    kfst->expandedMem = NULL;
+    if ((kfst->nrStates <= 0) || (kfst->nrClasses <= 0) || (kfst->alphaHashTabSize <= 0)) {
+        return;
+    }
+    /* one-byte transition entries are already directly indexable in the stream */
+    nrTrans = (kfst->transTabEntrySize == 1) ? 0 : kfst->nrStates * kfst->nrClasses;
+
+    /* first pass: count symbol cells, pairs and input epsilon transitions */
+    nrCells = 0;
+    nrPairs = 0;
+    for (h = 0; h < kfst->alphaHashTabSize; h++) {
+        pos = kfst->alphaHashTabPos + (h * 4);
+        FixedBytesToSignedNum(kfst->fstStream,4,& pos,& offs);
+        cellPos = kfst->alphaHashTabPos + offs;
+        while (offs > 0) {
+            pos = cellPos;
+            BytesToNum(kfst->fstStream,& pos,& val);
+            BytesToNum(kfst->fstStream,& pos,& nextOffs);
+            nrCells++;
+            do {
+                BytesToNum(kfst->fstStream,& pos,& val);
+                nrPairs++;
+                if (val != PICOKFST_SYMID_ILLEG) {
+                    BytesToNum(kfst->fstStream,& pos,& val);
+                }
+            } while (val != PICOKFST_SYMID_ILLEG);
+            offs = nextOffs;
+            cellPos += nextOffs;
+        }
+    }
+    nrEps = 0;
+    for (i = 0; i < kfst->nrStates; i++) {
+        pos = kfst->inEpsStateTabPos + (i * 4);
+        FixedBytesToSignedNum(kfst->fstStream,4,& pos,& offs);
+        if (offs > 0) {
+            pos = kfst->inEpsStateTabPos + offs;
+            do {
+                BytesToNum(kfst->fstStream,& pos,& val);
+                nrEps++;
+                if (val != PICOKFST_SYMID_ILLEG) {
+                    BytesToNum(kfst->fstStream,& pos,& val);
+                }
+            } while (val != PICOKFST_SYMID_ILLEG);
+        }
+    }
+    if (nrCells > 32767) {
+        return;
+    }
+
+    /* allocate all tables as one block; each part is kept aligned */
+#define KFST_ALIGNED(n) ((((picoos_objsize_t)(n)) + PICOOS_ALIGN_SIZE - 1) & ~((picoos_objsize_t)PICOOS_ALIGN_SIZE - 1))
+    size = KFST_ALIGNED(kfst->alphaHashTabSize * sizeof(picoos_int16))
+            + KFST_ALIGNED(nrCells * sizeof(kfst_symcell_t))
+            + KFST_ALIGNED(nrPairs * sizeof(kfst_pair_t))
+            + KFST_ALIGNED(nrTrans * sizeof(picokfst_state_t))
+            + KFST_ALIGNED(kfst->nrStates * sizeof(picoos_int32))
+            + KFST_ALIGNED(nrEps * sizeof(kfst_epstrans_t));
+    mem = (picoos_uint8 *) picoos_allocate(mm, size);
+    if (NULL == mem) {
+        PICODBG_WARN(("not enough memory to expand FST (%i bytes); using compressed form", size));
+        return;
+    }
+    kfst->expandedMem = mem;
+    kfst->alphaHashTab = (picoos_int16 *) mem;
+    mem += KFST_ALIGNED(kfst->alphaHashTabSize * sizeof(picoos_int16));
+    kfst->symCells = (kfst_symcell_t *) mem;
+    mem += KFST_ALIGNED(nrCells * sizeof(kfst_symcell_t));
+    kfst->pairs = (kfst_pair_t *) mem;
+    mem += KFST_ALIGNED(nrPairs * sizeof(kfst_pair_t));
+    kfst->transTab = (picokfst_state_t *) mem;
+    mem += KFST_ALIGNED(nrTrans * sizeof(picokfst_state_t));
+    kfst->inEpsStateTab = (picoos_int32 *) mem;
+    mem += KFST_ALIGNED(kfst->nrStates * sizeof(picoos_int32));
+    kfst->epsTrans = (kfst_epstrans_t *) mem;
+#undef KFST_ALIGNED
+
+    /* second pass: fill pair alphabet, keeping the original hash chains */
+    nrCells = 0;
+    nrPairs = 0;
+    for (h = 0; h < kfst->alphaHashTabSize; h++) {
+        pos = kfst->alphaHashTabPos + (h * 4);
+        FixedBytesToSignedNum(kfst->fstStream,4,& pos,& offs);
+        kfst->alphaHashTab[h] = (offs > 0) ? (picoos_int16) nrCells : -1;
+        cellPos = kfst->alphaHashTabPos + offs;
+        while (offs > 0) {
+            pos = cellPos;
+            BytesToNum(kfst->fstStream,& pos,& val);
+            BytesToNum(kfst->fstStream,& pos,& nextOffs);
+            kfst->symCells[nrCells].inSym = (picokfst_symid_t) val;
+            kfst->symCells[nrCells].nextSameHash = (nextOffs > 0) ? (picoos_int16) (nrCells + 1) : -1;
+            kfst->symCells[nrCells].firstPair = nrPairs;
+            nrCells++;
+            do {
+                BytesToNum(kfst->fstStream,& pos,& val);
+                kfst->pairs[nrPairs].outSym = (picokfst_symid_t) val;
+                kfst->pairs[nrPairs].pairClass = -1;
+                if (val != PICOKFST_SYMID_ILLEG) {
+                    BytesToNum(kfst->fstStream,& pos,& val);
+                    kfst->pairs[nrPairs].pairClass = (picokfst_class_t) val;
+                    val = 0;
+                }
+                nrPairs++;
+            } while (val != PICOKFST_SYMID_ILLEG);
+            offs = nextOffs;
+            cellPos += nextOffs;
+        }
+    }
+
+    /* transition table and accepting states */
+    if (nrTrans > 0) {
+        kfst->transTab8 = NULL;
+        pos = kfst->transTabPos;
+        for (i = 0; i < nrTrans; i++) {
+            FixedBytesToUnsignedNum(kfst->fstStream,kfst->transTabEntrySize,& pos,& endState);
+            kfst->transTab[i] = (picokfst_state_t) endState;
+        }
+    } else {
+        kfst->transTab = NULL;
+        kfst->transTab8 = kfst->fstStream + kfst->transTabPos;
+    }
+    kfst->accStateTab = kfst->fstStream + kfst->accStateTabPos;
+
+    /* input epsilon transitions */
+    nrEps = 0;
+    for (i = 0; i < kfst->nrStates; i++) {
+        pos = kfst->inEpsStateTabPos + (i * 4);
+        FixedBytesToSignedNum(kfst->fstStream,4,& pos,& offs);
+        if (offs > 0) {
+            kfst->inEpsStateTab[i] = nrEps;
+            pos = kfst->inEpsStateTabPos + offs;
+            do {
+                BytesToNum(kfst->fstStream,& pos,& val);
+                kfst->epsTrans[nrEps].outSym = (picokfst_symid_t) val;
+                kfst->epsTrans[nrEps].endState = 0;
+                if (val != PICOKFST_SYMID_ILLEG) {
+                    BytesToNum(kfst->fstStream,& pos,& val);
+                    kfst->epsTrans[nrEps].endState = (picokfst_state_t) val;
+                    val = 0;
+                }
+                nrEps++;
+            } while (val != PICOKFST_SYMID_ILLEG);
+        } else {
+            kfst->inEpsStateTab[i] = -1;
+        }
+    }
+
+    kfst->expanded = TRUE;
+}
+
+
 static pico_status_t kfstSubObjDeallocate(register picoknow_KnowledgeBase this,
         picoos_MemoryManager mm)
 {
+    kfst_subobj_t * kfst;
+
     if (NULL != this) {
+        kfst = (kfst_subobj_t *) this->subObj;
+        if ((NULL != kfst) && (NULL != kfst->expandedMem)) {
+            picoos_deallocate(mm, (void *) &kfst->expandedMem);
+        }
         picoos_deallocate(mm, (void *) &this->subObj);
     }
     return PICO_OK;
@@ -214,6 +419,8 @@ pico_status_t picokfst_specializeFSTKnowledgeBase(picoknow_KnowledgeBase this,
         status = kfstInitialize(this, common);
         if (PICO_OK != status) {
             picoos_deallocate(common->mm,(void **)&this->subObj);
+        } else {
+            kfstExpand((kfst_subobj_t *) this->subObj, common->mm);
         }
     }
     return PICO_OK;
@@ -283,6 +490,19 @@ extern void picokfst_kfstStartPairSearch (picokfst_FST this, picokfst_symid_t in
     (*searchState) =  -1;
     (*inSymFound) = 0;
     h = inSym % fst->alphaHashTabSize;
+    if (fst->expanded) {
+        /* search state is index into expanded pair lists */
+        offs = fst->alphaHashTab[h];
+        while (offs >= 0) {
+            if (fst->symCells[offs].inSym == inSym) {
+                (*searchState) = fst->symCells[offs].firstPair;
+                (*inSymFound) = 1;
+                return;
+            }
+            offs = fst->symCells[offs].nextSameHash;
+        }
+        return;
+    }
     pos = fst->alphaHashTabPos + (h * 4);
     FixedBytesToSignedNum(fst->fstStream,4,& pos,& offs);
     if (offs > 0) {
@@ -318,6 +538,19 @@ extern void picokfst_kfstGetNextPair (picokfst_FST this, picoos_int32 * searchSt
         (*pairFound) = 0;
         (*outSym) = PICOKFST_SYMID_ILLEG;
         (*pairClass) =  -1;
+    } else if (fst->expanded) {
+        kfst_pair_t * pair = &fst->pairs[*searchState];
+        if (pair->outSym != PICOKFST_SYMID_ILLEG) {
+            (*outSym) = pair->outSym;
+            (*pairClass) = pair->pairClass;
+            (*pairFound) = 1;
+            (*searchState)++;
+        } else {
+            (*pairFound) = 0;
+            (*outSym) = PICOKFST_SYMID_ILLEG;
+            (*pairClass) =  -1;
+            (*searchState) =  -1;
+        }
     } else {
         pos = (*searchState);
         BytesToNum(fst->fstStream,& pos,& val);
@@ -350,6 +583,9 @@ extern void picokfst_kfstGetTrans (picokfst_FST this, picokfst_state_t startStat
     kfst_SubObj fst = (kfst_SubObj) this;
     if ((startState < 1) || (startState > fst->nrStates) || (transClass < 1) || (transClass > fst->nrClasses)) {
         (*endState) = 0;
+    } else if (fst->expanded) {
+        index = (startState - 1) * fst->nrClasses + transClass - 1;
+        (*endState) = (NULL != fst->transTab8) ? fst->transTab8[index] : fst->transTab[index];
     } else {
         index = (startState - 1) * fst->nrClasses + transClass - 1;
         pos = fst->transTabPos + (index * fst->transTabEntrySize);
@@ -370,7 +606,13 @@ extern void picokfst_kfstStartInEpsTransSearch (picokfst_FST this, picokfst_stat
     kfst_SubObj fst = (kfst_SubObj) this;
     (*searchState) =  -1;
     (*inEpsTransFound) = 0;
-    if ((startState > 0) && (startState <= fst->nrStates)) {
+    if ((startState > 0) && (startState <= fst->nrStates) && fst->expanded) {
+        /* search state is index into expanded trans lists */
+        if (fst->inEpsStateTab[startState - 1] >= 0) {
+            (*searchState) = fst->inEpsStateTab[startState - 1];
+            (*inEpsTransFound) = 1;
+        }
+    } else if ((startState > 0) && (startState <= fst->nrStates)) {
         pos = fst->inEpsStateTabPos + (startState - 1) * 4;
         FixedBytesToSignedNum(fst->fstStream,4,& pos,& offs);
         if (offs > 0) {
@@ -395,6 +637,19 @@ extern void picokfst_kfstGetNextInEpsTrans (picokfst_FST this, picoos_int32 * se
         (*inEpsTransFound) = 0;
         (*outSym) = PICOKFST_SYMID_ILLEG;
         (*endState) = 0;
+    } else if (fst->expanded) {
+        kfst_epstrans_t * trans = &fst->epsTrans[*searchState];
+        if (trans->outSym != PICOKFST_SYMID_ILLEG) {
+            (*outSym) = trans->outSym;
+            (*endState) = trans->endState;
+            (*inEpsTransFound) = 1;
+            (*searchState)++;
+        } else {
+            (*inEpsTransFound) = 0;
+            (*outSym) = PICOKFST_SYMID_ILLEG;
+            (*endState) = 0;
+            (*searchState) =  -1;
+        }
     } else {
         pos = (*searchState);
         BytesToNum(fst->fstStream,& pos,& val);
@@ -422,7 +677,9 @@ extern picoos_bool picokfst_kfstIsAcceptingState (picokfst_FST this, picokfst_st
     picoos_uint32 val;
 
     kfst_SubObj fst = (kfst_SubObj) this;
-    if ((state > 0) && (state <= fst->nrStates)) {
+    if ((state > 0) && (state <= fst->nrStates) && fst->expanded) {
+        return (fst->accStateTab[state - 1] == 1);
+    } else if ((state > 0) && (state <= fst->nrStates)) {
         pos = fst->accStateTabPos + (state - 1);
         FixedBytesToUnsignedNum(fst->fstStream,1,& pos,& val);
         return (val == 1);
@@ -85,8 +85,10 @@ enum picofst_transduction_mode {
 /* ************************************************************/
 
 /* calculates a small number of data (e.g. addresses) from kb for fast access.
- * This data is encapsulated in a picokfst_FST that can later be retrieved
- * with picokfst_getFST. */
+ * If memory permits, the pair alphabet and the input epsilon transitions are
+ * also decoded into native arrays so that the access methods below index them
+ * directly. This data is encapsulated in a picokfst_FST that can later be
+ * retrieved with picokfst_getFST. */
 pico_status_t picokfst_specializeFSTKnowledgeBase(picoknow_KnowledgeBase that,
                                                   picoos_Common common);
 
@@ -141,6 +141,106 @@ static picoos_uint8 convScaleFactorToBig(picoos_uint8 pow, picoos_uint8 bigpow)
     return pow;
 }
 
+/* returns value cepnum of stream str (0..2: static, delta and deltadelta
+   mean, 3..5: the corresponding ivars) of the pdf vector starting at
+   vecstart, decoded and scaled the same way as cep reads it from the
+   compressed pdf */
+static picoos_int32 kpdfMULDecode(const picokpdf_pdfmul_t *pdfmul,
+                                  picoos_uint32 vecstart, picoos_uint8 str,
+                                  picoos_uint8 cepnum) {
+    picoos_uint8 *p;
+    picoos_uint8 ceporder, cc, s, ind;
+    picoos_uint32 k;
+
+    ceporder = pdfmul->ceporder;
+    if (str >= KPDF_NUMSTREAMS) {
+        /* inverse variances, dense in both formats */
+        cc = (str - KPDF_NUMSTREAMS) * ceporder + cepnum;
+        if (pdfmul->numdeltas == 0xFF) {
+            k = vecstart + pdfmul->numvuv + ceporder * 6 + cc;
+        } else {
+            k = vecstart + pdfmul->numvuv + ceporder * 2
+                    + pdfmul->numdeltas * 3 + cc;
+        }
+        return (picoos_int32) (pdfmul->content[k]) << (pdfmul->ivarpow[cc]);
+    }
+    cc = str * ceporder + cepnum;
+    if ((str == 0) || (pdfmul->numdeltas == 0xFF)) {
+        /* static means, and delta means of non-sparse pdfs */
+        p = pdfmul->content + (vecstart + pdfmul->numvuv + cc * 2);
+        return ((picoos_int32) ((picoos_int16) (*(p + 1) << 8)) | *p)
+                << (pdfmul->meanpowUm[cc]);
+    }
+    /* sparse delta means; search the index column like cep does */
+    if (str == 1) {
+        s = 0;
+        ind = 0;
+        while ((s < pdfmul->numdeltas) && (ind < cepnum || (ind == 0 && cepnum == 0))) {
+            k = vecstart + pdfmul->numvuv + ceporder * 2 + s;
+            ind = pdfmul->content[k];
+            if (ind == cepnum) {
+                k = vecstart + pdfmul->numvuv + ceporder * 2
+                        + pdfmul->numdeltas + s * 2;
+                return ((picoos_int32) ((picoos_int16) ((pdfmul->content[k + 1]) << 8))
+                        | pdfmul->content[k]) << (pdfmul->meanpowUm[cc]);
+            }
+            s++;
+        }
+    } else {
+        s = pdfmul->numdeltas;
+        ind = 2 * ceporder;
+        while ((s-- > 0) && (ind > ceporder + cepnum)) {
+            k = vecstart + pdfmul->numvuv + ceporder * 2 + s;
+            ind = pdfmul->content[k];
+            if (ind == ceporder + cepnum) {
+                k = vecstart + pdfmul->numvuv + ceporder * 2
+                        + pdfmul->numdeltas + s * 2;
+                return ((picoos_int32) ((picoos_int16) ((pdfmul->content[k + 1]) << 8))
+                        | pdfmul->content[k]) << (pdfmul->meanpowUm[cc]);
+            }
+        }
+    }
+    return 0;
+}
+
+/* expands all vectors of the mul pdf into pdfmul->expanded; leaves it
+   NULL (and the pdf usable in compressed form) if memory is short */
+static void kpdfMULExpand(picokpdf_pdfmul_t *pdfmul, picoos_Common common) {
+    picoos_uint32 numvals, vecstart;
+    picoos_uint16 f;
+    picoos_uint8 str, c;
+    picoos_int32 *e;
+    void *reserve;
+
+    numvals = (picoos_uint32) pdfmul->numframes
+            * PICOKPDF_MUL_EXPANDED_STREAMS * pdfmul->ceporder;
+    pdfmul->expanded = picoos_allocate(common->mm, numvals * sizeof(picoos_int32));
+    /* make sure the engine can still be created */
+    reserve = picoos_allocate(common->mm, PICOKPDF_EXPAND_MUL_RESERVE);
+    if ((NULL == pdfmul->expanded) || (NULL == reserve)) {
+        PICODBG_WARN(("not enough memory to expand mul pdf (%i bytes), using compressed pdf",
+                      numvals * sizeof(picoos_int32)));
+        if (NULL != reserve) {
+            picoos_deallocate(common->mm, &reserve);
+        }
+        if (NULL != pdfmul->expanded) {
+            picoos_deallocate(common->mm, (void *) &(pdfmul->expanded));
+        }
+        return;
+    }
+    picoos_deallocate(common->mm, &reserve);
+    e = pdfmul->expanded;
+    for (f = 0; f < pdfmul->numframes; f++) {
+        vecstart = (picoos_uint32) f * pdfmul->vecsize;
+        for (str = 0; str < PICOKPDF_MUL_EXPANDED_STREAMS; str++) {
+            for (c = 0; c < pdfmul->ceporder; c++) {
+                *e++ = kpdfMULDecode(pdfmul, vecstart, str, c);
+            }
+        }
+    }
+    PICODBG_DEBUG(("mul pdf expanded into %i bytes", numvals * sizeof(picoos_int32)));
+}
+
 static pico_status_t kpdfMULInitialize(register picoknow_KnowledgeBase this,
                                        picoos_Common common) {
     picokpdf_pdfmul_t *pdfmul;
@@ -230,6 +330,7 @@ static pico_status_t kpdfMULInitialize(register picoknow_KnowledgeBase this,
         return picoos_emRaiseException(common->em,PICO_EXC_FILE_CORRUPT,NULL,NULL);
     }
     pdfmul->content = &(this->base[pos]);
+    pdfmul->expanded = NULL;
     PICODBG_DEBUG(("numframes %d, vecsize %d, numstates %d, ceporder %d, "
                    "numvuv %d, numdeltas %d, meanpow %d, bigpow %d",
                    pdfmul->numframes, pdfmul->vecsize, pdfmul->numstates,
@@ -280,6 +381,9 @@ static pico_status_t kpdfMULSubObjDeallocate(register picoknow_KnowledgeBase thi
         pdfmul = (picokpdf_pdfmul_t *)this->subObj;
         picoos_deallocate(mm,(void *) &(pdfmul->meanpowUm));
         picoos_deallocate(mm,(void *) &(pdfmul->ivarpow));
+        if (NULL != pdfmul->expanded) {
+            picoos_deallocate(mm,(void *) &(pdfmul->expanded));
+        }
         picoos_deallocate(mm, (void *) &(this->subObj));
     }
     return PICO_OK;
@@ -355,6 +459,21 @@ pico_status_t picokpdf_specializePdfKnowledgeBase(picoknow_KnowledgeBase this,
     return PICO_OK;
 }
 
+pico_status_t picokpdf_expandMulPdf(picoknow_KnowledgeBase this,
+                                    picoos_Common common) {
+    picokpdf_pdfmul_t *pdfmul;
+
+    if ((NULL == this) || (NULL == this->subObj)) {
+        return picoos_emRaiseException(common->em, PICO_EXC_KB_MISSING,
+                                       NULL, NULL);
+    }
+    pdfmul = (picokpdf_pdfmul_t *)this->subObj;
+    if (NULL == pdfmul->expanded) {
+        kpdfMULExpand(pdfmul, common);
+    }
+    return PICO_OK;
+}
+
 
 /* ************************************************************/
 /* pdf getPdf* */
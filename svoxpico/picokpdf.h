@@ -71,6 +71,20 @@ extern "C" {
 
 #define PICOKPDF_BIG_POW 12
 
+/* mul pdfs can be expanded into native int32 tables at load time (see
+   picokpdf_expandMulPdf). Each expanded pdf needs numframes *
+   PICOKPDF_MUL_EXPANDED_STREAMS * ceporder * 4 bytes of the system memory
+   (about 2 MB for the mgc pdf of the shipped voices). A pdf is only
+   expanded if at least PICOKPDF_EXPAND_MUL_RESERVE bytes stay available
+   for the engine afterwards; otherwise the compressed pdf is used as
+   before. */
+#ifndef PICOKPDF_EXPAND_MUL_RESERVE
+#define PICOKPDF_EXPAND_MUL_RESERVE 1048576
+#endif
+
+/* mean and ivar for coeff, delta and deltadelta */
+#define PICOKPDF_MUL_EXPANDED_STREAMS 6
+
 typedef enum {
     PICOKPDF_KPDFTYPE_DUR,
     PICOKPDF_KPDFTYPE_MUL,
@@ -81,6 +95,11 @@ pico_status_t picokpdf_specializePdfKnowledgeBase(picoknow_KnowledgeBase this,
                                               picoos_Common common,
                                               const picokpdf_kpdftype_t type);
 
+/* expands the specialized mul pdf kb 'this'; keeps it compressed if
+   memory is short */
+pico_status_t picokpdf_expandMulPdf(picoknow_KnowledgeBase this,
+                                    picoos_Common common);
+
 
 /* ************************************************************/
 /* pdf types and get Pdf functions */
@@ -122,6 +141,10 @@ typedef struct picokpdf_pdfmul {
     picoos_uint8 *meanpowUm;  /* KPDF_NUMSTREAMS x ceporder values */
     picoos_uint8 *ivarpow;    /* KPDF_NUMSTREAMS x ceporder values */
     picoos_uint8 *content;
+    /* NULL, or numframes vectors of PICOKPDF_MUL_EXPANDED_STREAMS x
+       ceporder scaled values: static, delta and deltadelta means
+       followed by static, delta and deltadelta ivars */
+    picoos_int32 *expanded;
 } picokpdf_pdfmul_t;
 
 /* subobj specific for pdf phs type */
@@ -105,6 +105,26 @@ extern "C" {
 #define KPR_CTX_NETNAMEOFS_OFS    4
 #define KPR_CTX_PRODNAMEOFS_OFS   8
 
+/* token set elements evaluated when building the first token index;
+   bit positions follow pr_TokSetEleNP and pr_TokSetEleWP in picopr.c */
+#define KPR_TSE_NP_TOKTYPES       0x7F
+#define KPR_TSE_NP_LETTER         (1<<4)
+#define KPR_TSE_NP_ACCEPT         (1<<15)
+#define KPR_TSE_NP_NEXT           (1<<16)
+#define KPR_TSE_NP_ALTL           (1<<17)
+#define KPR_TSE_NP_ALTR           (1<<18)
+
+#define KPR_TSE_WP_OUT            (1<<0)
+#define KPR_TSE_WP_PRODPOS        9
+#define KPR_TSE_WP_PROD           (1<<KPR_TSE_WP_PRODPOS)
+#define KPR_TSE_WP_PRODEXT        (1<<10)
+#define KPR_TSE_WP_LEX            (1<<12)
+
+/* first token set of a token while building the index: token type bits
+   as in KPR_TSE_NP_TOKTYPES, plus */
+#define KPR_FIRST_EPS             (1<<7) /* may accept without consuming a token */
+#define KPR_FIRST_UNKNOWN         (1<<8) /* not determinable at load time */
+
 /* ************************************************************/
 /* preproc type and loading */
 /* ************************************************************/
@@ -157,6 +177,8 @@ typedef struct kpr_subobj
     picokpr_Tok * rTokArr;
     picokpr_Prod * rProdArr;
     picokpr_Ctx * rCtxArr;
+
+    picoos_uint8 * rTokFirstArr;
 } kpr_subobj_t;
 
 
@@ -223,10 +245,288 @@ static pico_status_t kprInitialize(register picoknow_KnowledgeBase this,
 }
 
 
+/* start token of the internal production referenced by token 'tok'
+   with wp set 'wpset', or -1 if it is not a valid token */
+static picoos_int32 kprTokProdATok(kpr_subobj_t * kpr, picokpr_TokArrOffset tok,
+                                   picokpr_TokSetWP wpset)
+{
+    picokpr_Preproc preproc = (picokpr_Preproc) kpr;
+    picoos_int32 prod, n, i;
+
+    /* production index is the attribute value following all lower wp elements */
+    n = 0;
+    for (i = 0; i < KPR_TSE_WP_PRODPOS; i++) {
+        if (((1<<i) & wpset) != 0) {
+            n++;
+        }
+    }
+    prod = picokpr_getAttrValArrInt32(preproc, picokpr_getTokAttribOfs(preproc, tok) + n);
+    if ((prod < 0) || (prod >= kpr->rProdArrLen)
+        || (picokpr_getProdATokOfs(preproc, prod) >= kpr->rTokArrLen)) {
+        return -1;
+    }
+    return picokpr_getProdATokOfs(preproc, prod);
+}
+
+
+/* first token set of token 'tok', given the current sets 'first' of all
+   tokens; mirrors the local states of pr_processToken in picopr.c */
+static picoos_uint16 kprTokFirst(kpr_subobj_t * kpr, picoos_uint16 * first,
+                                 picokpr_TokArrOffset tok)
+{
+    picokpr_Preproc preproc = (picokpr_Preproc) kpr;
+    picokpr_TokSetNP npset;
+    picokpr_TokSetWP wpset;
+    picokpr_TokArrOffset next, altl, altr;
+    picoos_int32 atok;
+    picoos_uint16 res, sub;
+
+    npset = picokpr_getTokSetNP(preproc, tok);
+    wpset = picokpr_getTokSetWP(preproc, tok);
+    next = picokpr_getTokNextOfs(preproc, tok);
+    altl = picokpr_getTokAltLOfs(preproc, tok);
+    altr = picokpr_getTokAltROfs(preproc, tok);
+    if ((next >= kpr->rTokArrLen) || (altl >= kpr->rTokArrLen) || (altr >= kpr->rTokArrLen)) {
+        return KPR_FIRST_UNKNOWN;
+    }
+
+    res = 0;
+    if ((KPR_TSE_NP_ACCEPT & npset) != 0) {
+        res = KPR_FIRST_EPS;
+        if ((KPR_TSE_NP_NEXT & npset) != 0) {
+            res |= first[next];
+        }
+    } else if ((KPR_TSE_WP_PROD & wpset) != 0) {
+        if ((KPR_TSE_WP_PRODEXT & wpset) != 0) {
+            res = KPR_FIRST_UNKNOWN;
+        } else {
+            atok = kprTokProdATok(kpr, tok, wpset);
+            if (atok < 0) {
+                res = KPR_FIRST_UNKNOWN;
+            } else {
+                sub = first[atok];
+                res = sub & ~KPR_FIRST_EPS;
+                if (((sub & KPR_FIRST_EPS) != 0) && ((KPR_TSE_NP_NEXT & npset) != 0)) {
+                    res |= first[next];
+                }
+            }
+        }
+    } else if ((KPR_TSE_WP_OUT & wpset) != 0) {
+        if ((KPR_TSE_NP_NEXT & npset) != 0) {
+            res = first[next];
+        }
+    } else if ((KPR_TSE_WP_LEX & wpset) != 0) {
+        if ((KPR_TSE_NP_LETTER & npset) != 0) {
+            res = npset & KPR_TSE_NP_TOKTYPES;
+        } else {
+            res = KPR_FIRST_UNKNOWN;
+        }
+    } else if ((KPR_TSE_NP_TOKTYPES & npset) != 0) {
+        res = npset & KPR_TSE_NP_TOKTYPES;
+    } else if ((KPR_TSE_NP_NEXT & npset) != 0) {
+        res = first[next];
+    }
+    if ((KPR_TSE_NP_ALTL & npset) != 0) {
+        res |= first[altl];
+    }
+    if ((KPR_TSE_NP_ALTR & npset) != 0) {
+        res |= first[altr];
+    }
+    return res;
+}
+
+
+/* collects the tokens whose first set is read by kprTokFirst for token
+   'tok' into 'deps'; returns their number (at most 4) */
+static picoos_int32 kprTokFirstDeps(kpr_subobj_t * kpr, picokpr_TokArrOffset tok,
+                                    picokpr_TokArrOffset * deps)
+{
+    picokpr_Preproc preproc = (picokpr_Preproc) kpr;
+    picokpr_TokSetWP wpset;
+    picoos_int32 atok, n;
+
+    n = 0;
+    deps[n++] = picokpr_getTokNextOfs(preproc, tok);
+    deps[n++] = picokpr_getTokAltLOfs(preproc, tok);
+    deps[n++] = picokpr_getTokAltROfs(preproc, tok);
+    if ((deps[0] >= kpr->rTokArrLen) || (deps[1] >= kpr->rTokArrLen) || (deps[2] >= kpr->rTokArrLen)) {
+        return 0;
+    }
+    wpset = picokpr_getTokSetWP(preproc, tok);
+    if (((KPR_TSE_WP_PROD & wpset) != 0) && ((KPR_TSE_WP_PRODEXT & wpset) == 0)) {
+        atok = kprTokProdATok(kpr, tok, wpset);
+        if (atok >= 0) {
+            deps[n++] = (picokpr_TokArrOffset) atok;
+        }
+    }
+    return n;
+}
+
+
+/* computes the fixpoint of the first sets with a work list: a token is
+   re-evaluated only after the set of a token it depends on has grown.
+   Needs a reverse dependency table; returns FALSE without touching 'first'
+   if there is not enough memory for it. */
+static picoos_bool kprFirstFixpointWorkList(kpr_subobj_t * kpr, picoos_MemoryManager mm,
+                                            picoos_uint16 * first)
+{
+    picoos_uint32 * depStart;
+    picokpr_TokArrOffset * depTok;
+    picokpr_TokArrOffset * queue;
+    picoos_uint8 * queued;
+    picokpr_TokArrOffset deps[4];
+    picoos_int32 i, j, n, len, head, count;
+    picoos_uint32 k;
+    picoos_uint16 f;
+
+    len = kpr->rTokArrLen;
+    depStart = (picoos_uint32 *) picoos_allocate(mm, (len + 1) * sizeof(picoos_uint32));
+    depTok = (picokpr_TokArrOffset *) picoos_allocate(mm, 4 * len * sizeof(picokpr_TokArrOffset));
+    queue = (picokpr_TokArrOffset *) picoos_allocate(mm, len * sizeof(picokpr_TokArrOffset));
+    queued = (picoos_uint8 *) picoos_allocate(mm, len * sizeof(picoos_uint8));
+    if ((NULL == depStart) || (NULL == depTok) || (NULL == queue) || (NULL == queued)) {
+        if (NULL != queued) {
+            picoos_deallocate(mm, (void *) &queued);
+        }
+        if (NULL != queue) {
+            picoos_deallocate(mm, (void *) &queue);
+        }
+        if (NULL != depTok) {
+            picoos_deallocate(mm, (void *) &depTok);
+        }
+        if (NULL != depStart) {
+            picoos_deallocate(mm, (void *) &depStart);
+        }
+        return FALSE;
+    }
+
+    /* dependents of token d are depTok[depStart[d] .. depStart[d+1]-1] */
+    for (i = 0; i <= len; i++) {
+        depStart[i] = 0;
+    }
+    for (i = 0; i < len; i++) {
+        n = kprTokFirstDeps(kpr, (picokpr_TokArrOffset) i, deps);
+        for (j = 0; j < n; j++) {
+            depStart[deps[j]]++;
+        }
+    }
+    for (i = 0, k = 0; i < len; i++) {
+        k += depStart[i];
+        depStart[i] = k;
+    }
+    depStart[len] = k;
+    for (i = 0; i < len; i++) {
+        n = kprTokFirstDeps(kpr, (picokpr_TokArrOffset) i, deps);
+        for (j = 0; j < n; j++) {
+            depTok[--depStart[deps[j]]] = (picokpr_TokArrOffset) i;
+        }
+    }
+
+    /* start with all tokens, in the order the sweeps used */
+    for (i = 0; i < len; i++) {
+        queue[i] = (picokpr_TokArrOffset) (len - 1 - i);
+        queued[i] = TRUE;
+        first[i] = 0;
+    }
+    head = 0;
+    count = len;
+    while (count > 0) {
+        i = queue[head];
+        head = (head + 1 < len) ? head + 1 : 0;
+        count--;
+        queued[i] = FALSE;
+        f = first[i] | kprTokFirst(kpr, first, (picokpr_TokArrOffset) i);
+        if (f != first[i]) {
+            first[i] = f;
+            for (k = depStart[i]; k < depStart[i+1]; k++) {
+                j = depTok[k];
+                if (!queued[j]) {
+                    queued[j] = TRUE;
+                    queue[(head + count) % len] = (picokpr_TokArrOffset) j;
+                    count++;
+                }
+            }
+        }
+    }
+
+    picoos_deallocate(mm, (void *) &queued);
+    picoos_deallocate(mm, (void *) &queue);
+    picoos_deallocate(mm, (void *) &depTok);
+    picoos_deallocate(mm, (void *) &depStart);
+    return TRUE;
+}
+
+
+/* builds rTokFirstArr, the set of token types each token may match as
+   the first item consumed from there on, including its alternatives;
+   tokens that may continue with anything else (accepting without input,
+   external productions, multi token lexicon entries) are marked
+   PICOKPR_FIRST_ANY. The sets are computed as a fixpoint over the token
+   network, which may be recursive. Without enough memory the index is
+   left out and every token stays a candidate. */
+static void kprBuildFirstIndex(kpr_subobj_t * kpr, picoos_MemoryManager mm)
+{
+    picoos_uint16 * first;
+    picoos_uint16 f;
+    picoos_int32 i;
+    picoos_bool changed;
+
+    kpr->rTokFirstArr = NULL;
+    if (kpr->rTokArrLen <= 0) {
+        return;
+    }
+    /* the permanent array first, so that releasing the temporary one
+       does not leave a hole */
+    kpr->rTokFirstArr = (picoos_uint8 *) picoos_allocate(mm, kpr->rTokArrLen * sizeof(picoos_uint8));
+    if (NULL == kpr->rTokFirstArr) {
+        PICODBG_WARN(("no memory for first token index of '%s'", kpr->rNetName));
+        return;
+    }
+    first = (picoos_uint16 *) picoos_allocate(mm, kpr->rTokArrLen * sizeof(picoos_uint16));
+    if (NULL == first) {
+        PICODBG_WARN(("no memory for first token index of '%s'", kpr->rNetName));
+        picoos_deallocate(mm, (void *) &kpr->rTokFirstArr);
+        return;
+    }
+
+    if (!kprFirstFixpointWorkList(kpr, mm, first)) {
+        /* no memory for the work list: sweep until nothing changes */
+        for (i = 0; i < kpr->rTokArrLen; i++) {
+            first[i] = 0;
+        }
+        do {
+            changed = FALSE;
+            for (i = kpr->rTokArrLen - 1; i >= 0; i--) {
+                f = first[i] | kprTokFirst(kpr, first, (picokpr_TokArrOffset) i);
+                if (f != first[i]) {
+                    first[i] = f;
+                    changed = TRUE;
+                }
+            }
+        } while (changed);
+    }
+
+    for (i = 0; i < kpr->rTokArrLen; i++) {
+        if ((first[i] & (KPR_FIRST_EPS | KPR_FIRST_UNKNOWN)) != 0) {
+            kpr->rTokFirstArr[i] = PICOKPR_FIRST_ANY;
+        } else {
+            kpr->rTokFirstArr[i] = (picoos_uint8) (first[i] & KPR_TSE_NP_TOKTYPES);
+        }
+    }
+    picoos_deallocate(mm, (void *) &first);
+}
+
+
 static pico_status_t kprSubObjDeallocate(register picoknow_KnowledgeBase this,
                                          picoos_MemoryManager mm)
 {
     if (NULL != this) {
+        if (NULL != this->subObj) {
+            kpr_subobj_t * kpr = (kpr_subobj_t *) this->subObj;
+            if (NULL != kpr->rTokFirstArr) {
+                picoos_deallocate(mm, (void *) &kpr->rTokFirstArr);
+            }
+        }
         picoos_deallocate(mm, (void *) &this->subObj);
     }
     return PICO_OK;
@@ -240,6 +540,8 @@ static pico_status_t kprSubObjDeallocate(register picoknow_KnowledgeBase this,
 pico_status_t picokpr_specializePreprocKnowledgeBase(picoknow_KnowledgeBase this,
                                                      picoos_Common common)
 {
+    pico_status_t status;
+
     if (NULL == this) {
         return picoos_emRaiseException(common->em, PICO_EXC_KB_MISSING,
                                        NULL, NULL);
@@ -250,7 +552,12 @@ pico_status_t picokpr_specializePreprocKnowledgeBase(picoknow_KnowledgeBase this
         return picoos_emRaiseException(common->em, PICO_EXC_OUT_OF_MEM,
                                        NULL, NULL);
     }
-    return kprInitialize(this, common);
+    ((kpr_subobj_t *) this->subObj)->rTokFirstArr = NULL;
+    status = kprInitialize(this, common);
+    if (PICO_OK == status) {
+        kprBuildFirstIndex((kpr_subobj_t *) this->subObj, common->mm);
+    }
+    return status;
 }
 
 /* ************************************************************/
@@ -345,7 +652,7 @@ extern picoos_int32 picokpr_getAttrValArrInt32(picokpr_Preproc preproc, picokpr_
     picoos_uint32 c =              p[KPR_ATTRVAL_INT_OFS] +
                                256*p[KPR_ATTRVAL_INT_OFS+1] +
                            256*256*p[KPR_ATTRVAL_INT_OFS+2] +
-                       256*256*256*p[KPR_ATTRVAL_INT_OFS+3];
+                       256*256*256*(picoos_uint32)p[KPR_ATTRVAL_INT_OFS+3];
 
     if (c > KPR_MAX_INT32) {
         return (c - KPR_MAX_INT32) - 1;
@@ -402,7 +709,7 @@ extern picoos_int32 picokpr_getOutItemVal(picokpr_Preproc preproc, picokpr_OutIt
     picoos_uint32 c =  p[KPR_OUTITEM_VAL_OFS+0] +
                    256*p[KPR_OUTITEM_VAL_OFS+1] +
                256*256*p[KPR_OUTITEM_VAL_OFS+2] +
-           256*256*256*p[KPR_OUTITEM_VAL_OFS+3];
+           256*256*256*(picoos_uint32)p[KPR_OUTITEM_VAL_OFS+3];
 
     if (c > KPR_MAX_INT32) {
         return (c - KPR_MAX_INT32) - 1;
@@ -540,6 +847,17 @@ extern picokpr_AttrValArrOffset picokpr_getTokAttribOfs(picokpr_Preproc preproc,
     return p[KPR_TOK_ATTRIBOFS_OFS+0] + 256*p[KPR_TOK_ATTRIBOFS_OFS+1];
 }
 
+
+extern picoos_uint8 picokpr_getTokFirstTypes(picokpr_Preproc preproc, picokpr_TokArrOffset ofs)
+{
+    kpr_SubObj kpr = (kpr_SubObj)preproc;
+
+    if ((NULL == kpr->rTokFirstArr) || (ofs >= kpr->rTokArrLen)) {
+        return PICOKPR_FIRST_ANY;
+    }
+    return kpr->rTokFirstArr[ofs];
+}
+
 /* *****************************************************************************/
 /* knowledge base access routines for productions in ProdArr */
 /* *****************************************************************************/
@@ -555,7 +873,7 @@ extern picoos_int32 picokpr_getProdPrefCost(picokpr_Preproc preproc, picokpr_Pro
     picoos_uint32 c =  p[KPR_PROD_PRODPREFCOST_OFS+0] +
                    256*p[KPR_PROD_PRODPREFCOST_OFS+1] +
                256*256*p[KPR_PROD_PRODPREFCOST_OFS+2] +
-           256*256*256*p[KPR_PROD_PRODPREFCOST_OFS+3];
+           256*256*256*(picoos_uint32)p[KPR_PROD_PRODPREFCOST_OFS+3];
 
 
     if (c > KPR_MAX_INT32) {
@@ -123,6 +123,12 @@ extern picokpr_TokArrOffset picokpr_getTokAltLOfs(picokpr_Preproc preproc, picok
 extern picokpr_TokArrOffset picokpr_getTokAltROfs(picokpr_Preproc preproc, picokpr_TokArrOffset ofs);
 extern picokpr_AttrValArrOffset picokpr_getTokAttribOfs(picokpr_Preproc preproc, picokpr_TokArrOffset ofs);
 
+/* token types (TokSetNP bits Begin..Seq) the first item consumed from
+   token 'ofs' on may have, alternatives included, or PICOKPR_FIRST_ANY
+   if this is not restricted; built when the knowledge base is specialized */
+#define PICOKPR_FIRST_ANY 0x80
+extern picoos_uint8 picokpr_getTokFirstTypes(picokpr_Preproc preproc, picokpr_TokArrOffset ofs);
+
 /* knowledge base access routines for productions in ProdArr */
 extern picoos_int32 picokpr_getProdArrLen(picokpr_Preproc preproc);
 extern picoos_int32 picokpr_getProdPrefCost(picokpr_Preproc preproc, picokpr_ProdArrOffset ofs);
@@ -191,12 +191,25 @@ static picoos_uint32 ktab_propOffset (const picoktab_Graphs this, picoos_uint32
 
 typedef struct ktabgraphs_subobj *ktabgraphs_SubObj;
 
+/* number of code points (Latin-1) resolved by direct lookup */
+#define KTAB_GRAPH_DIRECT_SIZE 256
+
+/* graph of a directly mapped code point with its token type properties */
+typedef struct ktab_graphdirect {
+    picoos_uint16 graphsOffset;  /* 0 if not in graphs table */
+    picoos_uint8 propset;
+    picoos_uint8 tokenType;
+    picoos_int8 tokenSubType;
+} ktab_graphdirect_t;
+
 typedef struct ktabgraphs_subobj {
     picoos_uint16 nrOffset;
     picoos_uint16 sizeOffset;
 
     picoos_uint8 * offsetTable;
     picoos_uint8 * graphTable;
+
+    ktab_graphdirect_t * direct; /* NULL if not available */
 } ktabgraphs_subobj_t;
 
 
@@ -216,12 +229,66 @@ static pico_status_t ktabGraphsInitialize(register picoknow_KnowledgeBase this,
     ktabgraphs->sizeOffset  = (int)(this->base[KTAB_START_GRAPHS_SIZE_OFFSET]);
     ktabgraphs->offsetTable = &(this->base[KTAB_START_GRAPHS_OFFSET_TABLE]);
     ktabgraphs->graphTable  = &(this->base[KTAB_START_GRAPHS_GRAPH_TABLE]);
+    ktabgraphs->direct = NULL;
     return PICO_OK;
 }
 
+static picoos_uint32 ktab_searchGraph (const picoktab_Graphs this, picoos_uchar * utf8graph);
+
+/* resolves all code points below KTAB_GRAPH_DIRECT_SIZE once, so that
+   looking them up later needs no binary search over the graphs table;
+   if there is no memory the binary search is used for all graphs */
+static void ktabGraphsInitializeDirect(ktabgraphs_subobj_t * ktabgraphs,
+                                       picoos_MemoryManager mm) {
+    picoktab_Graphs graphs = (picoktab_Graphs) ktabgraphs;
+    ktab_graphdirect_t * d;
+    picoos_uchar utf8graph[3];
+    picoos_uint32 cp, graphsOffset, propOffset;
+
+    d = (ktab_graphdirect_t *) picoos_allocate(mm, KTAB_GRAPH_DIRECT_SIZE * sizeof(ktab_graphdirect_t));
+    if (NULL == d) {
+        PICODBG_WARN(("no memory for direct graph lookup table"));
+        return;
+    }
+    for (cp = 0; cp < KTAB_GRAPH_DIRECT_SIZE; cp++) {
+        if (cp < 0x80) {
+            utf8graph[0] = (picoos_uchar) cp;
+            utf8graph[1] = 0;
+        } else {
+            utf8graph[0] = (picoos_uchar) (0xC0 | (cp >> 6));
+            utf8graph[1] = (picoos_uchar) (0x80 | (cp & 0x3F));
+            utf8graph[2] = 0;
+        }
+        /* code point 0 is the empty string and never matches a graph */
+        graphsOffset = (cp > 0) ? ktab_searchGraph(graphs, utf8graph) : 0;
+        d[cp].graphsOffset = (picoos_uint16) graphsOffset;
+        d[cp].propset = 0;
+        d[cp].tokenType = 0;
+        d[cp].tokenSubType = 0;
+        if (graphsOffset > 0) {
+            d[cp].propset = ktabgraphs->graphTable[graphsOffset];
+            propOffset = ktab_propOffset(graphs, graphsOffset, KTAB_GRAPH_PROPSET_TOKENTYPE);
+            if (propOffset > 0) {
+                d[cp].tokenType = ktabgraphs->graphTable[graphsOffset + propOffset];
+            }
+            propOffset = ktab_propOffset(graphs, graphsOffset, KTAB_GRAPH_PROPSET_TOKENSUBTYPE);
+            if (propOffset > 0) {
+                d[cp].tokenSubType = (picoos_int8) ktabgraphs->graphTable[graphsOffset + propOffset];
+            }
+        }
+    }
+    ktabgraphs->direct = d;
+}
+
 static pico_status_t ktabGraphsSubObjDeallocate(register picoknow_KnowledgeBase this,
                                                 picoos_MemoryManager mm) {
     if (NULL != this) {
+        if (NULL != this->subObj) {
+            ktabgraphs_subobj_t * ktabgraphs = (ktabgraphs_subobj_t *) this->subObj;
+            if (NULL != ktabgraphs->direct) {
+                picoos_deallocate(mm, (void *) &ktabgraphs->direct);
+            }
+        }
         picoos_deallocate(mm, (void *) &this->subObj);
     }
     return PICO_OK;
@@ -230,6 +297,8 @@ static pico_status_t ktabGraphsSubObjDeallocate(register picoknow_KnowledgeBase
 
 pico_status_t picoktab_specializeGraphsKnowledgeBase(picoknow_KnowledgeBase this,
                                                      picoos_Common common) {
+    pico_status_t status;
+
     if (NULL == this) {
         return picoos_emRaiseException(common->em, PICO_EXC_KB_MISSING,
                                        NULL, NULL);
@@ -240,7 +309,11 @@ pico_status_t picoktab_specializeGraphsKnowledgeBase(picoknow_KnowledgeBase this
         return picoos_emRaiseException(common->em, PICO_EXC_OUT_OF_MEM,
                                        NULL, NULL);
     }
-    return ktabGraphsInitialize(this, common);
+    status = ktabGraphsInitialize(this, common);
+    if (PICO_OK == status) {
+        ktabGraphsInitializeDirect((ktabgraphs_subobj_t *) this->subObj, common->mm);
+    }
+    return status;
 }
 
 
@@ -366,7 +439,64 @@ static picoos_uint32 ktab_propOffset(const picoktab_Graphs this,
 }
 
 
+/* returns the code point of 'utf8graph' if it is a single character
+   below KTAB_GRAPH_DIRECT_SIZE, KTAB_GRAPH_DIRECT_SIZE otherwise */
+static picoos_uint32 ktab_utf8Direct (const picoos_uchar * utf8graph)
+{
+    if (utf8graph[0] < 0x80) {
+        if ((utf8graph[0] != 0) && (utf8graph[1] == 0)) {
+            return utf8graph[0];
+        }
+    } else if (((utf8graph[0] & 0xFE) == 0xC2) && ((utf8graph[1] & 0xC0) == 0x80) && (utf8graph[2] == 0)) {
+        return ((utf8graph[0] & 0x1F) << 6) | (utf8graph[1] & 0x3F);
+    }
+    return KTAB_GRAPH_DIRECT_SIZE;
+}
+
+
 picoos_uint32 picoktab_graphOffset (const picoktab_Graphs this, picoos_uchar * utf8graph)
+{
+    ktabgraphs_subobj_t * g = (ktabgraphs_SubObj)this;
+    picoos_uint32 cp;
+
+    if (NULL != g->direct) {
+        cp = ktab_utf8Direct(utf8graph);
+        if (cp < KTAB_GRAPH_DIRECT_SIZE) {
+            return g->direct[cp].graphsOffset;
+        }
+    }
+    return ktab_searchGraph(this, utf8graph);
+}
+
+
+picoos_uint32 picoktab_graphTokenTypes (const picoktab_Graphs this, picoos_uchar * utf8graph,
+                                        picoos_uint8 * stokenType, picoos_int8 * stokenSubType)
+{
+    ktabgraphs_subobj_t * g = (ktabgraphs_SubObj)this;
+    picoos_uint32 cp, graphsOffset;
+
+    if (NULL != g->direct) {
+        cp = ktab_utf8Direct(utf8graph);
+        if (cp < KTAB_GRAPH_DIRECT_SIZE) {
+            if (g->direct[cp].propset & KTAB_GRAPH_PROPSET_TOKENTYPE) {
+                *stokenType = g->direct[cp].tokenType;
+            }
+            if (g->direct[cp].propset & KTAB_GRAPH_PROPSET_TOKENSUBTYPE) {
+                *stokenSubType = g->direct[cp].tokenSubType;
+            }
+            return g->direct[cp].graphsOffset;
+        }
+    }
+    graphsOffset = ktab_searchGraph(this, utf8graph);
+    if (graphsOffset > 0) {
+        picoktab_getIntPropTokenType(this, graphsOffset, stokenType);
+        picoktab_getIntPropTokenSubType(this, graphsOffset, stokenSubType);
+    }
+    return graphsOffset;
+}
+
+
+static picoos_uint32 ktab_searchGraph (const picoktab_Graphs this, picoos_uchar * utf8graph)
 {  ktabgraphs_subobj_t * g = (ktabgraphs_SubObj)this;
    picoos_int32 a, b, m;
    picoos_uint32 graphsOffset;
@@ -421,7 +551,7 @@ picoos_uint32 picoktab_graphOffset (const picoktab_Graphs this, picoos_uchar * u
        }
      } while (a<=b);
    }
-   PICODBG_DEBUG(("picoktab_graphOffset: utf char '%s' not found", utf8graph));
+   PICODBG_DEBUG(("ktab_searchGraph: utf char '%s' not found", utf8graph));
    return 0;
 }
 
@@ -86,6 +86,15 @@ picoktab_Graphs picoktab_getGraphs(picoknow_KnowledgeBase that);
 picoos_uint32 picoktab_graphOffset(const picoktab_Graphs that,
                                    picoos_uchar * utf8graph);
 
+/* combined lookup for tokenizing: returns the graph offset as
+   picoktab_graphOffset and, if the graph has them, its token type and
+   token subtype properties in 'stokenType' and 'stokenSubType' (which
+   are left unchanged otherwise) */
+picoos_uint32 picoktab_graphTokenTypes(const picoktab_Graphs that,
+                                       picoos_uchar * utf8graph,
+                                       picoos_uint8 * stokenType,
+                                       picoos_int8 * stokenSubType);
+
 
 /* check if UTF8 char 'graph' has property vowellike, return non-zero
    if 'ch' has the property, 0 otherwise */
@@ -552,6 +552,11 @@ void * picoos_allocate(picoos_MemoryManager this,
         this->maxUsedSize = this->usedSize;
     }
 
+    /* the free-links are part of the contents now; clear them, so that no
+       stale address remains e.g. in padding bytes of the new object */
+    c->prevFree = NULL;
+    c->nextFree = NULL;
+
     c->size = -(c->size);
     adr = (void *)((picoos_objsize_t)c + this->usedCellHdrSize);
     return adr;
@@ -606,6 +611,97 @@ void picoos_deallocate(picoos_MemoryManager this, void * * adr)
     *adr = NULL;
 }
 
+/* *****************************************************************/
+/* Arena                                                           */
+/* *****************************************************************/
+
+typedef struct picoos_arena
+{
+    byte_ptr_t data;
+    picoos_objsize_t size;
+    picoos_objsize_t top; /* next free position in data */
+    picoos_objsize_t maxTop; /* high-water mark */
+} picoos_arena_t;
+
+picoos_Arena picoos_newArena(picoos_MemoryManager mm, picoos_objsize_t size)
+{
+    picoos_Arena this;
+
+    this = (picoos_Arena) picoos_allocate(mm, sizeof(*this));
+    if (NULL == this) {
+        return NULL;
+    }
+    this->data = picoos_allocate(mm, size);
+    if (NULL == this->data) {
+        picoos_deallocate(mm, (void *) &this);
+        return NULL;
+    }
+    this->size = size;
+    this->top = 0;
+    this->maxTop = 0;
+    return this;
+}
+
+void picoos_disposeArena(picoos_MemoryManager mm, picoos_Arena * this)
+{
+    if (NULL != (*this)) {
+        PICODBG_DEBUG(("arena maximally used: %d of %d", (*this)->maxTop,
+                       (*this)->size));
+        picoos_deallocate(mm, (void *) &(*this)->data);
+        picoos_deallocate(mm, (void *) this);
+    }
+}
+
+void * picoos_arenaAllocate(picoos_Arena this, picoos_objsize_t byteSize)
+{
+    void * adr;
+
+    if (byteSize > (this->size - this->top)) {
+        return NULL;
+    }
+    adr = (void *) (this->data + this->top);
+    byteSize = ((byteSize + PICOOS_ALIGN_SIZE - 1) / PICOOS_ALIGN_SIZE)
+            * PICOOS_ALIGN_SIZE;
+    if (byteSize > (this->size - this->top)) {
+        this->top = this->size;
+    } else {
+        this->top += byteSize;
+    }
+    if (this->top > this->maxTop) {
+        this->maxTop = this->top;
+    }
+    return adr;
+}
+
+picoos_objsize_t picoos_arenaMark(picoos_Arena this)
+{
+    return this->top;
+}
+
+void picoos_arenaRelease(picoos_Arena this, picoos_objsize_t mark)
+{
+    if (mark < this->top) {
+        this->top = mark;
+    }
+}
+
+void picoos_arenaReset(picoos_Arena this)
+{
+    this->top = 0;
+    this->maxTop = 0;
+}
+
+void picoos_getArenaUsage(
+        picoos_Arena this,
+        picoos_int32 *usedBytes,
+        picoos_int32 *maxUsedBytes,
+        picoos_int32 *sizeBytes)
+{
+    *usedBytes = (picoos_int32) this->top;
+    *maxUsedBytes = (picoos_int32) this->maxTop;
+    *sizeBytes = (picoos_int32) this->size;
+}
+
 /* *****************************************************************/
 /* Exception Management                                                */
 /* *****************************************************************/
@@ -953,7 +1049,8 @@ picoos_File picoos_newFile(picoos_MemoryManager mm)
 void picoos_disposeFile(picoos_MemoryManager mm, picoos_File * this)
 {
     if (NULL != (*this)) {
-        /* terminate */
+        /* terminate; don't leave the stale native file handle behind */
+        (*this)->nf = NULL;
         picoos_deallocate(mm, (void *)this);
     }
 }
@@ -1739,7 +1836,8 @@ extern picoos_bool picoos_sdfOpenOut(picoos_Common g, picoos_SDFile * sdFile,
         picoos_emRaiseWarning(g->em, PICO_EXC_UNEXPECTED_FILE_TYPE, NULL,
                 (picoos_char *) "encoding not supported");
     }
-    if (SAMPLE_FREQ_16KHZ != sdf->sf) {
+    /* the engine makes 16 kHz, other rates are resampled by the caller */
+    if (sdf->sf <= 0) {
         done = FALSE;
         picoos_emRaiseWarning(g->em, PICO_EXC_UNEXPECTED_FILE_TYPE, NULL,
                 (picoos_char *) "sample frequency not supported");
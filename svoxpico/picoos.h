@@ -201,6 +201,39 @@ void picoos_showMemUsage(
         picoos_bool incremental,
         picoos_bool resetIncremental);
 
+/* *****************************************************************/
+/* Arena                                                           */
+/* *****************************************************************/
+/**  object   : Arena
+ *   shortcut : arena
+ *
+ *   Scratch memory for data with a limited life time, e.g. one sentence.
+ *   Memory is handed out from one fixed block in stack order and is never
+ *   deallocated individually; instead, picoos_arenaRelease releases
+ *   everything allocated since the corresponding picoos_arenaMark.
+ */
+typedef struct picoos_arena * picoos_Arena;
+
+picoos_Arena picoos_newArena(picoos_MemoryManager mm, picoos_objsize_t size);
+
+void picoos_disposeArena(picoos_MemoryManager mm, picoos_Arena * that);
+
+/* returns NULL if the arena is exhausted */
+void * picoos_arenaAllocate(picoos_Arena that, picoos_objsize_t byteSize);
+
+picoos_objsize_t picoos_arenaMark(picoos_Arena that);
+
+void picoos_arenaRelease(picoos_Arena that, picoos_objsize_t mark);
+
+/* releases everything and resets the high-water mark */
+void picoos_arenaReset(picoos_Arena that);
+
+void picoos_getArenaUsage(
+        picoos_Arena that,
+        picoos_int32 *usedBytes,
+        picoos_int32 *maxUsedBytes,
+        picoos_int32 *sizeBytes);
+
 /* *****************************************************************/
 /* Exception Management                                                */
 /* *****************************************************************/
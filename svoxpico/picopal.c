@@ -86,6 +86,12 @@ extern "C" {
 #define USE_CLOCK 1
 #endif
 
+/* picopal_get_timer reports zero unless IMPLEMENT_TIMER is set; it is on
+   by default where the clock() based timer is used */
+#if !defined(IMPLEMENT_TIMER) && USE_CLOCK
+#define IMPLEMENT_TIMER 1
+#endif
+
 #include <time.h>
 #if PICO_PLATFORM == PICO_Windows
 #include <windows.h>
@@ -1909,7 +1909,7 @@ static pico_status_t pam_put_item(register picodata_ProcessingUnit this,
     sDest[0] = PICODATA_ITEM_PHONE; /*Item type*/
     sDest[1] = pam->sPhFeats[P3]; /*phonetic id*/
     sDest[2] = PICOPAM_NRSTPF; /*number of states per phone*/
-    sDest[3] = sizeof(picoos_uint16) * PICOPAM_NRSTPF * 3; /*size of the item*/
+    sDest[3] = sizeof(picoos_uint16) * PICOPAM_NRSTPF * 3 + 1; /*size of the item, with the flags*/
     pos = 4;
     /*make initial silence of sentence shorter (see also UpdateVector)*/
     if ((pam->nCurrSyllable == 0) && (pam->nSyllPhoneme == 0)) {
@@ -1970,8 +1970,17 @@ static pico_status_t pam_put_item(register picodata_ProcessingUnit this,
         picoos_write_mem_pi_uint16(sDest, &pos,
                 (picoos_uint16) pam->mgcIndex[nI]);
     }
+    /*phone flags for the timing: pause, or the first phone of a word*/
+    if (pam->sSyllFeats[pam->nCurrSyllable].phoneV[P1] == 1) {
+        sDest[pos++] = PICODATA_PHONEFLAG_PAUSE;
+    } else if ((pam->sSyllFeats[pam->nCurrSyllable].phoneV[B4] == 1)
+            && (pam->nSyllPhoneme == 0)) {
+        sDest[pos++] = PICODATA_PHONEFLAG_WORD;
+    } else {
+        sDest[pos++] = 0;
+    }
     *bytesWr = sizeof(picodata_itemhead_t) + sizeof(picoos_uint16)
-            * PICOPAM_NRSTPF * 3;
+            * PICOPAM_NRSTPF * 3 + 1;
     return PICO_OK;
 }/*pam_put_item*/
 
@@ -302,9 +302,7 @@ typedef struct pr_subobj
     picoos_uchar tmpStr1[PR_MAX_DATA_LEN_Z];
     picoos_uchar tmpStr2[PR_MAX_DATA_LEN_Z];
 
-    picoos_uint8 pr_WorkMem[PR_WORK_MEM_SIZE];
-    picoos_uint32 workMemTop;
-    picoos_uint32 maxWorkMemTop;
+    picoos_Arena workArena;
     picoos_uint8 pr_DynMem[PR_DYN_MEM_SIZE];
     picoos_MemoryManager dynMemMM;
     picoos_int32 dynMemSize;
@@ -349,8 +347,8 @@ static void pr_getOutputItemList (picodata_ProcessingUnit this, pr_subobj_t * pr
    partitions allocated with pr_subobj_t.
    Dynamic memory is allocated in pr_subobj_t->pr_DynMem. Dynamic memory has
    to be deallocated again with pr_DEALLOCATE.
-   Working memory is allocated in pr_subobj_t->pr_WorkMem. Working memory is stack
-   based and may not to be deallocated with pr_DEALLOCATE, but with pr_resetMemState
+   Working memory is allocated in the arena pr_subobj_t->workArena. Working memory is
+   stack based and may not to be deallocated with pr_DEALLOCATE, but with pr_resetMemState
    to a state previously saved with pr_getMemState.
 */
 
@@ -359,25 +357,26 @@ static void pr_ALLOCATE (picodata_ProcessingUnit this, pr_MemTypes mType, void *
 {
     pr_subobj_t * pr = (pr_subobj_t *) this->subObj;
     picoos_int32 incrUsedBytes, prevmaxDynMemSize;
+#if PR_TRACE_MEM || PR_TRACE_MAX_MEM
+    picoos_int32 workUsed, workMaxUsed, workSize;
+#endif
 
     if (mType == pr_WorkMem) {
-        if ((pr->workMemTop + byteSize) < PR_WORK_MEM_SIZE) {
-            (*adr) = (void *)(&(pr->pr_WorkMem[pr->workMemTop]));
-            byteSize = ((byteSize + PICOOS_ALIGN_SIZE - 1) / PICOOS_ALIGN_SIZE) * PICOOS_ALIGN_SIZE;
-            pr->workMemTop += byteSize;
+        (*adr) = picoos_arenaAllocate(pr->workArena, byteSize);
+        if ((*adr) != NULL) {
+#if PR_TRACE_MEM || PR_TRACE_MAX_MEM
+            picoos_getArenaUsage(pr->workArena, &workUsed, &workMaxUsed, &workSize);
+#endif
 #if PR_TRACE_MEM
-            PICODBG_INFO(("pr_WorkMem: +%u, tot:%i of %i", byteSize, pr->workMemTop, PR_WORK_MEM_SIZE));
+            PICODBG_INFO(("pr_WorkMem: +%u, tot:%i of %i", byteSize, workUsed, workSize));
 #endif
-
-            if (pr->workMemTop > pr->maxWorkMemTop) {
-                pr->maxWorkMemTop = pr->workMemTop;
 #if PR_TRACE_MAX_MEM
-                PICODBG_INFO(("new max pr_WorkMem: %i of %i", pr->workMemTop, PR_WORK_MEM_SIZE));
-#endif
+            if (workUsed == workMaxUsed) {
+                PICODBG_INFO(("new max pr_WorkMem: %i of %i", workUsed, workSize));
             }
+#endif
         }
         else {
-            (*adr) = NULL;
             PICODBG_ERROR(("pr out of working memory"));
             picoos_emRaiseException(this->common->em, PICO_EXC_OUT_OF_MEM, (picoos_char *)"pr out of dynamic memory", (picoos_char *)"");
             pr->outOfMemory = TRUE;
@@ -434,7 +433,7 @@ static void pr_getMemState(picodata_ProcessingUnit this, pr_MemTypes mType, pico
 {
     pr_subobj_t * pr = (pr_subobj_t *) this->subObj;
     mType = mType;        /* avoid warning "var not used in this function"*/
-    *lmemState = pr->workMemTop;
+    *lmemState = picoos_arenaMark(pr->workArena);
 }
 
 
@@ -443,10 +442,10 @@ static void pr_resetMemState(picodata_ProcessingUnit this, pr_MemTypes mType, pi
     pr_subobj_t * pr = (pr_subobj_t *) this->subObj;
 
 #if PR_TRACE_MEM
-    PICODBG_INFO(("pr_WorkMem: -%i, tot:%i of %i", pr->workMemTop-lmemState, lmemState, PR_WORK_MEM_SIZE));
+    PICODBG_INFO(("pr_WorkMem: -%i, tot:%i of %i", picoos_arenaMark(pr->workArena)-lmemState, lmemState, PR_WORK_MEM_SIZE));
 #endif
     mType = mType;        /* avoid warning "var not used in this function"*/
-    pr->workMemTop = lmemState;
+    picoos_arenaRelease(pr->workArena, lmemState);
 }
 
 
@@ -2477,6 +2476,47 @@ static picoos_bool pr_getToken (picodata_ProcessingUnit this, pr_subobj_t * pr)
 }
 
 
+/* checks the first token index of the knowledge base: FALSE if neither the
+   actual token nor any of its alternatives can match the next item */
+static picoos_bool pr_mayMatchNextItem (pr_subobj_t * pr)
+{
+    picoos_uint8 types;
+    picoos_int32 ln;
+    picoos_int32 lid;
+    picokpr_TokSetNP itemType;
+
+    types = picokpr_getTokFirstTypes(pr->ractpath.rele[pr->ractpath.rlen - 1].rnetwork, pr->ractpath.rele[pr->ractpath.rlen - 1].rtok);
+    if ((types & PICOKPR_FIRST_ANY) != 0) {
+        return TRUE;
+    }
+    /* same item as pr_getToken would take */
+    ln = (pr->ractpath.rlen - 2);
+    while ((ln >= 0) && (pr->ractpath.rele[ln].ritemid ==  -1)) {
+        ln = ln - 1;
+    }
+    if (ln >= 0) {
+        lid = pr->ractpath.rele[ln].ritemid + 1;
+    } else {
+        lid = 0;
+    }
+    if (lid >= pr->rnritems) {
+        return TRUE;
+    }
+    switch (pr->ritems[lid+1]->head.info1) {
+        case PICODATA_ITEMINFO1_TOKTYPE_BEGIN:  itemType = PR_TSE_MASK_BEGIN;  break;
+        case PICODATA_ITEMINFO1_TOKTYPE_END:    itemType = PR_TSE_MASK_END;    break;
+        case PICODATA_ITEMINFO1_TOKTYPE_SPACE:  itemType = PR_TSE_MASK_SPACE;  break;
+        case PICODATA_ITEMINFO1_TOKTYPE_DIGIT:  itemType = PR_TSE_MASK_DIGIT;  break;
+        case PICODATA_ITEMINFO1_TOKTYPE_LETTER: itemType = PR_TSE_MASK_LETTER; break;
+        case PICODATA_ITEMINFO1_TOKTYPE_SEQ:    itemType = PR_TSE_MASK_SEQ;    break;
+        case PICODATA_ITEMINFO1_TOKTYPE_CHAR:   itemType = PR_TSE_MASK_CHAR;   break;
+        default:
+            return TRUE;
+    }
+    return ((types & itemType) != 0);
+}
+
+
 static picoos_bool pr_getNextMultiToken (picodata_ProcessingUnit this, pr_subobj_t * pr)
 {
     picoos_int32 len;
@@ -2918,7 +2958,10 @@ void pr_processToken (picodata_ProcessingUnit this, pr_subobj_t * pr)
                 case PR_LSInit:
                     npset = picokpr_getTokSetNP(with__0->rnetwork, with__0->rtok);
                     wpset = picokpr_getTokSetWP(with__0->rnetwork, with__0->rtok);
-                    if ((PR_TSE_MASK_ACCEPT & npset) != 0){
+                    if (!pr_mayMatchNextItem(pr)) {
+                        /* no path from here can match, skip the whole subnetwork */
+                        with__0->rlState = PR_LSGoBack;
+                    } else if ((PR_TSE_MASK_ACCEPT & npset) != 0){
                         if (with__0->rdepth == 1) {
                             pr_calcPathCost(&pr->ractpath);
                             if ((pr->rbestpath.rlen == 0) || (pr->ractpath.rcost < pr->rbestpath.rcost)) {
@@ -3209,13 +3252,7 @@ pico_status_t prReset(register picodata_ProcessingUnit this, picoos_int32 resetM
     pr->actCtxChanged = FALSE;
     pr->prodList = NULL;
 
-    if (((picoos_uint32)pr->pr_WorkMem % PICOOS_ALIGN_SIZE) == 0) {
-        pr->workMemTop = 0;
-    }
-    else {
-        pr->workMemTop = PICOOS_ALIGN_SIZE - ((picoos_uint32)pr->pr_WorkMem % PICOOS_ALIGN_SIZE);
-    }
-    pr->maxWorkMemTop=0;
+    picoos_arenaReset(pr->workArena);
     pr->dynMemSize=0;
     pr->maxDynMemSize=0;
     /* this is ok to be in 'initialize' because it is a private memory within pr. Creating a new mm
@@ -3266,14 +3303,16 @@ pico_status_t prSubObjDeallocate(register picodata_ProcessingUnit this,
         picoos_MemoryManager mm)
 {
     pr_subobj_t * pr;
+    picoos_int32 workUsed, workMaxUsed, workSize;
 
     if (NULL != this) {
         pr = (pr_subobj_t *) this->subObj;
-        mm = mm;        /* avoid warning "var not used in this function"*/
-        PICODBG_INFO(("max pr_WorkMem: %i of %i", pr->maxWorkMemTop, PR_WORK_MEM_SIZE));
+        picoos_getArenaUsage(pr->workArena, &workUsed, &workMaxUsed, &workSize);
+        PICODBG_INFO(("max pr_WorkMem: %i of %i", workMaxUsed, workSize));
         PICODBG_INFO(("max pr_DynMem: %i of %i", pr->maxDynMemSize, PR_DYN_MEM_SIZE));
 
         pr_disposeContextList(this);
+        picoos_disposeArena(mm, &pr->workArena);
         picoos_deallocate(this->common->mm, (void *) &this->subObj);
     }
     return PICO_OK;
@@ -3308,6 +3347,13 @@ picodata_ProcessingUnit picopr_newPreprocUnit(picoos_MemoryManager mm, picoos_Co
     }
     pr = (pr_subobj_t *) this->subObj;
 
+    pr->workArena = picoos_newArena(mm, PR_WORK_MEM_SIZE);
+    if (pr->workArena == NULL) {
+        picoos_deallocate(mm, (void *)&this->subObj);
+        picoos_deallocate(mm, (void *)&this);
+        return NULL;
+    }
+
     pr->graphs = picoktab_getGraphs(this->voice->kbArray[PICOKNOW_KBID_TAB_GRAPHS]);
     pr->preproc[0] = picokpr_getPreproc(this->voice->kbArray[PICOKNOW_KBID_TPP_MAIN]);
     for (i=0; i<PICOKNOW_MAX_NUM_UTPP; i++) {
@@ -3537,7 +3583,7 @@ picodata_step_result_t prStep(register picodata_ProcessingUnit this,
             }
         }
 #if PR_TRACE_MEM
-        PICODBG_INFO(("memory: dyn=%u, work=%u", pr->dynMemSize, pr->workMemTop));
+        PICODBG_INFO(("memory: dyn=%u, work=%u", pr->dynMemSize, picoos_arenaMark(pr->workArena)));
 #endif
         if (pr->nrIterations <= 0) {
             return PICODATA_PU_BUSY;
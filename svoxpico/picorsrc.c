@@ -219,6 +219,7 @@ typedef struct picorsrc_resource_manager {
     picoos_uint16 numKbs;
     picoknow_KnowledgeBase freeKbs;
     picoos_header_string_t tmpHeader;
+    picoos_uint8 expandPdfs; /* expand mul pdfs of resources loaded from now on */
 } picorsrc_resource_manager_t;
 
 pico_status_t picorsrc_createDefaultResource(picorsrc_ResourceManager this /*,
@@ -240,6 +241,7 @@ picorsrc_ResourceManager picorsrc_newResourceManager(picoos_MemoryManager mm, pi
         this->numVdefs = 0;
         this->vdefs = NULL;
         this->freeVdefs = NULL;
+        this->expandPdfs = FALSE;
     }
     return this;
 }
@@ -252,6 +254,13 @@ void picorsrc_disposeResourceManager(picoos_MemoryManager mm, picorsrc_ResourceM
     }
 }
 
+void picorsrc_setExpandPdfs(picorsrc_ResourceManager this, picoos_uint8 expand)
+{
+    if (NULL != this) {
+        this->expandPdfs = expand;
+    }
+}
+
 
 /* ******* accessing resources **************************************/
 
@@ -341,6 +350,8 @@ static pico_status_t picorsrc_createKnowledgeBase(
         picoknow_kb_id_t kbid,
         picoknow_KnowledgeBase * kb)
 {
+    pico_status_t status;
+
     (*kb) = picoknow_newKnowledgeBase(this->common->mm);
     if (NULL == (*kb)) {
         return PICO_EXC_OUT_OF_MEM;
@@ -433,12 +444,13 @@ static pico_status_t picorsrc_createKnowledgeBase(
 
             break;
         case PICOKNOW_KBID_PDF_LFZ:
-            return picokpdf_specializePdfKnowledgeBase(*kb, this->common,
-                                                       PICOKPDF_KPDFTYPE_MUL);
-            break;
         case PICOKNOW_KBID_PDF_MGC:
-            return picokpdf_specializePdfKnowledgeBase(*kb, this->common,
-                                                       PICOKPDF_KPDFTYPE_MUL);
+            status = picokpdf_specializePdfKnowledgeBase(*kb, this->common,
+                                                         PICOKPDF_KPDFTYPE_MUL);
+            if ((PICO_OK == status) && this->expandPdfs) {
+                status = picokpdf_expandMulPdf(*kb, this->common);
+            }
+            return status;
             break;
         case PICOKNOW_KBID_PDF_PHS:
             return picokpdf_specializePdfKnowledgeBase(*kb, this->common,
@@ -653,6 +665,13 @@ pico_status_t picorsrc_loadResource(picorsrc_ResourceManager this,
         }
     }
 
+    /* the resource is completely held in memory now; don't keep the file
+       open, so the resource does not refer to anything outside the memory
+       area (and is not leaked when loading failed) */
+    if (NULL != res->file) {
+        picoos_CloseBinary(this->common, &res->file);
+    }
+
     if (status == PICO_OK) {
         /* add resource to rm */
         res->next = this->resources;
@@ -99,6 +99,10 @@ picorsrc_ResourceManager picorsrc_newResourceManager(picoos_MemoryManager mm, pi
 
 void picorsrc_disposeResourceManager(picoos_MemoryManager mm, picorsrc_ResourceManager * that);
 
+/* expand the mul pdfs (lfz and mgc) of resources loaded from now on into
+   int32 tables (expand != 0), see picokpdf_expandMulPdf */
+void picorsrc_setExpandPdfs(picorsrc_ResourceManager that, picoos_uint8 expand);
+
 
 /* **************************************************************************
  *
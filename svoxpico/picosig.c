@@ -57,6 +57,9 @@ extern "C" {
 static picodata_step_result_t sigStep(register picodata_ProcessingUnit this,
         picoos_int16 mode, picoos_uint16 * numBytesOutput);
 
+/* timing of all engines, see picosig_setTimingHook */
+static picosig_TimingHook sigTimingHook = NULL;
+
 /*----------------------------------------------------------
  // Name    :   sig_subobj
  // Function:   subobject definition for the sig processing
@@ -87,6 +90,7 @@ typedef struct sig_subobj
     picoos_SDFile sOutSDFile;               /* output file handle */
     picoos_single fSampNorm;                /* running normalization factor */
     picoos_uint32 nNumFrame;                /* running count for frame number in output items */
+    picoos_uint32 nNumSamples;              /* running count of samples, for the timing */
     /*---------------------- other working variables ---------------------------*/
     picoos_uint8 innerProcState; /*where to take up work at next processing step*/
     /*-----------------------Definition of the local storage for this PU--------*/
@@ -132,6 +136,7 @@ static pico_status_t sigInitialize(register picodata_ProcessingUnit this, picoos
     sig_subObj->retState = PICOSIG_COLLECT;
     sig_subObj->innerProcState = 0;
     sig_subObj->nNumFrame = 0;
+    sig_subObj->nNumSamples = 0;
 
     /*-----------------------------------------------------------------
      * MANAGE Item I/O control management
@@ -303,6 +308,22 @@ picodata_ProcessingUnit picosig_newSigUnit(picoos_MemoryManager mm,
     return this;
 }/*picosig_newSigUnit*/
 
+/**
+ * sets the function called with the timing of the speech of any engine: the
+ * start of each phone, word and pause, and the markers, with the number of
+ * samples the engine put out before them since its last reset
+ * @param    hook : the function, NULL to stop
+ * @remarks    the name of a marker is only valid during the call
+ * @callgraph
+ * @callergraph
+ */
+void picosig_setTimingHook(
+        picosig_TimingHook hook
+        )
+{
+    sigTimingHook = hook;
+}/*picosig_setTimingHook*/
+
 /**
  * pdf access for phase
  * @param    this : sig object pointer
@@ -433,6 +454,16 @@ static pico_status_t sigProcess(register picodata_ProcessingUnit this,
             picoos_mem_copy((void *) &sig_subObj->inBuf[inReadPos
                     + sizeof(picodata_itemhead_t)],                   /*src*/
             (void *) &tmp_uint16, sizeof(tmp_uint16));                /*dest+size*/
+            /*the phone's first frame: report the timing, the samples are those of
+              the frames before; its audio follows the lag of the DSP*/
+            if ((NULL != sigTimingHook) && ((tmp_uint16 >> 8) & PICODATA_PHONEFLAG_BEGIN)) {
+                sigTimingHook(((tmp_uint16 >> 8) & PICODATA_PHONEFLAG_WORD) ? PICOSIG_TIMING_WORD
+                        : ((tmp_uint16 >> 8) & PICODATA_PHONEFLAG_PAUSE) ? PICOSIG_TIMING_PAUSE
+                        : PICOSIG_TIMING_PHONE, (picoos_int16) (tmp_uint16 & 0xff), NULL,
+                        sig_subObj->nNumSamples);
+            }
+            sig_subObj->nNumSamples += sig_subObj->sig_inner.hop_p;
+            tmp_uint16 &= 0xff;
             sig_subObj->sig_inner.PhIdBuff[CEPST_BUFF_SIZE-1] = (picoos_int16) tmp_uint16; /*store into newest*/
             tmp_uint16 = (picoos_int16) sig_subObj->sig_inner.PhIdBuff[0];                 /*assign oldest*/
             sig_subObj->sig_inner.phId_p = (picoos_int16) tmp_uint16;                      /*assign oldest*/
@@ -1062,6 +1093,19 @@ static picodata_step_result_t sigStep(register picodata_ProcessingUnit this,
                             return PICODATA_PU_BUSY; /*data still to process or to feed*/
                         }
 
+                        /*markers get their time: the samples of the frames before*/
+                        if ((NULL != sigTimingHook)
+                                && (sig_subObj->inBuf[sig_subObj->inReadPos] == PICODATA_ITEM_CMD)
+                                && (sig_subObj->inBuf[sig_subObj->inReadPos + 1]
+                                        == PICODATA_ITEMINFO1_CMD_MARKER)) {
+                            picoos_char name[PICODATA_MAX_ITEMSIZE];
+                            picoos_uint8 len = sig_subObj->inBuf[sig_subObj->inReadPos + 3];
+                            picoos_mem_copy(&(sig_subObj->inBuf[sig_subObj->inReadPos
+                                    + PICODATA_ITEM_HEADSIZE]), name, len);
+                            name[len] = '\0';
+                            sigTimingHook(PICOSIG_TIMING_MARK, 0, name, sig_subObj->nNumSamples);
+                        }
+
                         /*if end of sentence reset number of frames(only needed for debugging purposes)*/
                         if ((sig_subObj->inBuf[sig_subObj->inReadPos]
                                 == PICODATA_ITEM_BOUND)
@@ -57,6 +57,19 @@ picodata_ProcessingUnit picosig_newSigUnit(
         picodata_CharBuffer cbOut,
         picorsrc_Voice voice);
 
+/* the timing reported by SIG, see picoext_setTimingHook */
+#define PICOSIG_TIMING_PHONE 0  /* a phone starts */
+#define PICOSIG_TIMING_WORD  1  /* the first phone of a word starts */
+#define PICOSIG_TIMING_PAUSE 2  /* a pause starts */
+#define PICOSIG_TIMING_MARK  3  /* a marker, its name in 'name' */
+
+typedef void (* picosig_TimingHook)(picoos_int16 kind, picoos_int16 phone,
+        const picoos_char * name, picoos_uint32 sample);
+
+void picosig_setTimingHook(
+        picosig_TimingHook hook
+        );
+
 #ifdef __cplusplus
 }
 #endif
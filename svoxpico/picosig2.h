@@ -49,7 +49,7 @@ typedef struct sig_innerobj
 
     /*-----------------------Definition of the local storage for this PU--------*/
     picoos_int16 *idx_vect1; /*reserved for bit reversal tables*/
-    picoos_int16 *idx_vect2; /*reserved for table lookup "A" vector*/
+    const picoos_int16 *idx_vect2; /*constant table lookup "A" vector*/
     picoos_int16 *idx_vect4; /*reserved for max peak index arrax in pchip*/
     picoos_int16 *idx_vect5; /*reserved for min index arrax in sigana_singleIMF*/
     picoos_int16 *idx_vect6; /*reserved for max index arrax in sigana_singleIMF*/
@@ -57,27 +57,27 @@ typedef struct sig_innerobj
     picoos_int16 *idx_vect8; /*reserved for LocV*/
     picoos_int16 *idx_vect9; /*reserved for LocU*/
 
-    picoos_int32 *int_vec22; /*reserved for normalized hanning window - fixed point */
+    const picoos_int32 *int_vec22; /*constant normalized hanning window - fixed point */
     picoos_int32 *int_vec23; /*reserved for impresp  - fixed point */
     picoos_int32 *int_vec24; /*reserved for impresp  - fixed point */
-    picoos_int32 *int_vec25; /*reserved for window  - fixed point */
+    const picoos_int32 *int_vec25; /*constant window  - fixed point */
     picoos_int32 *int_vec26; /*reserved for wavBuf  - fixed point */
     picoos_int32 *int_vec28; /*reserved for cepstral vectors input - fixed point */
     picoos_int32 *int_vec29; /*reserved for cepstral vectors input - fixed point */
-    picoos_int32 *int_vec38; /*reserved for cepstral vectors input - fixed point */
+    const picoos_int32 *int_vec38; /*constant table lookup "D" vector - fixed point */
     picoos_int32 *int_vec30; /*reserved for cepstral vectors input - fixed point */
     picoos_int32 *int_vec31; /*reserved for cepstral vectors input - fixed point */
 
     picoos_int32 *int_vec32; /*reserved for cepstral vectors input - fixed point */
     picoos_int32 *int_vec33; /*reserved for cepstral vectors input - fixed point */
 
-    picoos_int32 *int_vec34; /* reserved for sin table- fixed point */
-    picoos_int32 *int_vec35; /* reserved for cos table - fixed point */
+    const picoos_int32 *int_vec34; /* constant random cos table - fixed point */
+    const picoos_int32 *int_vec35; /* constant random sin table - fixed point */
     picoos_int32 *int_vec36; /* reserved for currently used sin table- fixed point */
     picoos_int32 *int_vec37; /* reserved for currently used cos table - fixed point */
 
     picoos_int32 *int_vec39; /* reserved for ang - fixed point */
-    picoos_int32 *int_vec40; /* reserved for cos table - fixed point */
+    const picoos_int32 *int_vec40; /* constant cos table - fixed point */
 
     picoos_int32 *int_vec41[CEPST_BUFF_SIZE]; /*reserved for phase smoothing - cepstrum buffers */
     picoos_int32 *int_vec42[PHASE_BUFF_SIZE]; /*reserved for phase smoothing - phase buffers */
@@ -147,7 +147,6 @@ extern void sigDspInitialize(sig_innerobj_t *sig_inObj, picoos_int32 resetMode);
  ------------------------------------------------------------------*/
 extern void mel_2_lin_init(sig_innerobj_t *sig_inObj);
 extern void save_transition_frame(sig_innerobj_t *sig_inObj);
-extern void mel_2_lin_init(sig_innerobj_t *sig_inObj);
 extern void post_filter_init(sig_innerobj_t *sig_inObj);
 extern void mel_2_lin_lookup(sig_innerobj_t *sig_inObj, picoos_uint32 mgc);
 extern void post_filter(sig_innerobj_t *sig_inObj);
@@ -238,6 +238,10 @@ typedef struct tok_subobj
     picoos_int32 tokenPos;
     picoos_uchar tokenStr[IN_BUF_SIZE];
 
+    /* token type and subtype of each 7 bit ASCII character */
+    pico_tokenType asciiTokenType[128];
+    pico_tokenSubType asciiTokenSubType[128];
+
     picoos_int32 nrEOL;
 
     picoos_bool markupHandlingMode;       /* to be moved ??? */
@@ -1300,10 +1304,8 @@ static void tok_treatMarkup (picodata_ProcessingUnit this, tok_subobj_t * tok)
 static void tok_treatChar (picodata_ProcessingUnit this, tok_subobj_t * tok, picoos_uchar ch, picoos_bool markupHandling)
 {
     picoos_int32 i, id;
-    picoos_uint8 uval8;
     pico_tokenType type = PICODATA_ITEMINFO1_TOKTYPE_UNDEFINED;
     pico_tokenSubType subtype = -1;
-    picoos_bool dummy;
     utf8char0c utf2;
     picoos_int32 utf2pos;
 
@@ -1321,15 +1323,11 @@ static void tok_treatChar (picodata_ProcessingUnit this, tok_subobj_t * tok, pic
             break;
         case UTF_CHAR_COMPLETE:
             markupHandling = (markupHandling && (tok->markupHandlingMode == MARKUP_HANDLING_ENABLED));
-            id = picoktab_graphOffset(tok->graphTab, tok->utf);
+            id = picoktab_graphTokenTypes(tok->graphTab, tok->utf, &type, &subtype);
             if (id > 0) {
-                if (picoktab_getIntPropTokenType(tok->graphTab, id, &uval8)) {
-                    type = (pico_tokenType)uval8;
-                    if (type == PICODATA_ITEMINFO1_TOKTYPE_LETTERV) {
-                        type = PICODATA_ITEMINFO1_TOKTYPE_LETTER;
-                    }
+                if (type == PICODATA_ITEMINFO1_TOKTYPE_LETTERV) {
+                    type = PICODATA_ITEMINFO1_TOKTYPE_LETTER;
                 }
-                dummy = picoktab_getIntPropTokenSubType(tok->graphTab, id, &subtype);
             } else if (tok->utf[tok->utfpos-1] <= (picoos_uchar)' ') {
                 type = PICODATA_ITEMINFO1_TOKTYPE_SPACE;
                 subtype =  -1;
@@ -1378,6 +1376,49 @@ static void tok_treatChar (picodata_ProcessingUnit this, tok_subobj_t * tok, pic
 }
 
 
+/* caches the graph token types of all ASCII characters as tok_treatChar
+   determines them for characters > ' ' */
+static void tok_initAsciiTokenTypes (tok_subobj_t * tok)
+{
+    picoos_int32 ch;
+    picoos_uchar utf[2];
+
+    for (ch = 0; ch < 128; ch++) {
+        tok->asciiTokenType[ch] = PICODATA_ITEMINFO1_TOKTYPE_UNDEFINED;
+        tok->asciiTokenSubType[ch] = -1;
+        if ((ch > 0) && (NULL != tok->graphTab)) {
+            utf[0] = (picoos_uchar)ch;
+            utf[1] = 0;
+            if (picoktab_graphTokenTypes(tok->graphTab, utf, &tok->asciiTokenType[ch], &tok->asciiTokenSubType[ch]) > 0) {
+                if (tok->asciiTokenType[ch] == PICODATA_ITEMINFO1_TOKTYPE_LETTERV) {
+                    tok->asciiTokenType[ch] = PICODATA_ITEMINFO1_TOKTYPE_LETTER;
+                }
+            }
+        }
+    }
+}
+
+
+/* fast path for runs of ASCII characters: appends 'ch' to the actual simple
+   token if tok_treatChar would do nothing else with it */
+static picoos_bool tok_extendSimpleToken (tok_subobj_t * tok, picoos_uchar ch)
+{
+    if ((ch > (picoos_uchar)' ') && (ch < (picoos_uchar)'\200') && (ch != (picoos_uchar)'<')
+        && (tok->utfpos == 0) && (tok->markupState == MSNotInMarkup)
+        && (tok->tokenType != PICODATA_ITEMINFO1_TOKTYPE_UNDEFINED)
+        && (tok->tokenType != PICODATA_ITEMINFO1_TOKTYPE_CHAR)
+        && (tok->asciiTokenType[ch] == tok->tokenType)
+        && (tok->asciiTokenSubType[ch] == tok->tokenSubType)
+        && (tok->tokenPos < IN_BUF_SIZE)) {
+        tok->tokenStr[tok->tokenPos] = ch;
+        tok->tokenPos++;
+        tok->nrEOL = 0;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+
 static void tok_treatSimpleToken (picodata_ProcessingUnit this, tok_subobj_t * tok)
 {
     if (tok->tokenPos < IN_BUF_SIZE) {
@@ -1448,6 +1489,7 @@ static pico_status_t tokReset(register picodata_ProcessingUnit this, picoos_int3
 
 
     tok->graphTab = picoktab_getGraphs(this->voice->kbArray[PICOKNOW_KBID_TAB_GRAPHS]);
+    tok_initAsciiTokenTypes(tok);
 
     tok->xsampa_parser = picokfst_getFST(this->voice->kbArray[PICOKNOW_KBID_FST_XSAMPA_PARSE]);
     PICODBG_TRACE(("got xsampa_parser @ %i",tok->xsampa_parser));
@@ -1562,7 +1604,9 @@ picodata_step_result_t tokStep(register picodata_ProcessingUnit this,
         }
         else if (PICO_EOF != (ch = picodata_cbGetCh(this->cbIn))) {
             PICODBG_DEBUG(("read in %c", (picoos_char) ch));
-            tok_treatChar(this, tok, (picoos_uchar) ch, /*markupHandling*/TRUE);
+            if (!tok_extendSimpleToken(tok, (picoos_uchar) ch)) {
+                tok_treatChar(this, tok, (picoos_uchar) ch, /*markupHandling*/TRUE);
+            }
         }
         else {
             return PICODATA_PU_IDLE;
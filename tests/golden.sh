@@ -0,0 +1,188 @@
+#!/bin/bash
+#
+# golden-output regression test: synthesizes tests/corpus with every voice in
+# lang/ at several speed, pitch and volume settings, plus edge cases, and
+# compares the PCM with the hashes in tests/golden.md5. Resampled output goes
+# through float filters, it is compared with tests/ref/ by SNR instead.
+#
+# usage: tests/golden.sh [--update] [path to nanotts]
+#   --update    write the current output as the new golden output
+#
+# Run from the top of the tree, 'make test' does.
+#
+
+UPDATE=0
+if [ "$1" == "--update" ]; then
+    UPDATE=1
+    shift
+fi
+
+NANOTTS=${1:-./nanotts}
+TESTS=tests
+GOLDEN=${TESTS}/golden.md5
+SNR=${TESTS}/snr
+MIN_SNR=60
+
+SETTINGS=( "" "--speed 1.6" "--speed 0.6 --pitch 1.4" "--pitch 0.7 --volume 1.8" "--volume 0.4" )
+
+# no Lingware cache or saved memory size from the user's home
+TMP=$(mktemp -d)
+trap 'rm -rf ${TMP}' EXIT
+export HOME=${TMP}
+
+[ ${UPDATE} -eq 1 ] && mkdir -p ${TESTS}/ref
+
+passed=0
+failed=0
+: > ${TMP}/golden.md5
+
+result() {
+    if [ $1 -eq 0 ]; then
+        passed=$((passed + 1))
+        echo "ok    $2"
+    else
+        failed=$((failed + 1))
+        echo "FAIL  $2 ($3)"
+    fi
+}
+
+# check <name> <nanotts arguments...>, the text on stdin: the PCM on stdout
+# against the golden hash of <name>
+check() {
+    local name=$1
+    shift
+    "${NANOTTS}" -l lang "$@" -c > ${TMP}/out.raw 2> ${TMP}/err.txt
+    local rc=$?
+    local hash=$(md5sum < ${TMP}/out.raw | cut -d' ' -f1)
+    echo "${hash}  ${name}" >> ${TMP}/golden.md5
+
+    if [ ${rc} -ne 0 ]; then
+        result 1 "${name}" "exit code ${rc}: $(tail -1 ${TMP}/err.txt)"
+        return
+    fi
+    [ ${UPDATE} -eq 1 ] && return
+
+    local expected=$(awk -v name="${name}" 'substr($0, 35) == name { print $1; exit }' ${GOLDEN})
+    if [ -z "${expected}" ]; then
+        result 1 "${name}" "no golden hash"
+    elif [ "${expected}" != "${hash}" ]; then
+        result 1 "${name}" "$(stat -c %s ${TMP}/out.raw) bytes, hash ${hash}"
+    else
+        result 0 "${name}"
+    fi
+}
+
+# check_snr <name> <nanotts arguments...>, the text on stdin: the PCM on
+# stdout against tests/ref/<name>.raw
+check_snr() {
+    local name=$1
+    shift
+    "${NANOTTS}" -l lang "$@" -c > ${TMP}/out.raw 2> ${TMP}/err.txt
+    local rc=$?
+    if [ ${UPDATE} -eq 1 ]; then
+        cp ${TMP}/out.raw ${TESTS}/ref/${name}.raw
+        return
+    fi
+    if [ ${rc} -ne 0 ]; then
+        result 1 "${name}" "exit code ${rc}: $(tail -1 ${TMP}/err.txt)"
+        return
+    fi
+    local snr
+    snr=$(${SNR} ${TESTS}/ref/${name}.raw ${TMP}/out.raw ${MIN_SNR})
+    result $? "${name}" "${snr}, needs ${MIN_SNR} dB"
+}
+
+if [ ! -x "${NANOTTS}" ] || [ ! -x ${SNR} ]; then
+    echo "golden.sh: build nanotts and ${SNR} first ('make test')"
+    exit 2
+fi
+
+# the corpus, with every voice and setting
+for ta in lang/*_ta.bin; do
+    voice=$(basename ${ta} _ta.bin)
+    for setting in "${SETTINGS[@]}"; do
+        check "${voice} ${setting:-default}" -v ${voice} ${setting} < ${TESTS}/corpus/${voice}.txt
+    done
+done
+
+# edge cases; a case reads its text from a file or a process substitution,
+# in a pipeline it would run in a subshell and its result would be lost
+check "empty input" -v en-US < /dev/null
+check "newline only" -v en-US < <(printf '\n')
+check "invalid UTF-8" -v en-US < <(printf 'Bad \xff\xfe bytes, \xc3 a cut \xe2\x82 sequence and \xc0\xaf an overlong one.\n')
+# a user mark must not change the phrasing, see acphIsMarker
+check "user mark" -v en-US < <(printf 'Hello <mark name="x"/> world, a mark within a sentence.\n')
+
+for i in $(seq 160); do cat ${TESTS}/corpus/en-US.txt; done > ${TMP}/long.txt
+check "over 32 KB" -v en-US < ${TMP}/long.txt
+check "over 32 KB, file input" -v en-US -f ${TMP}/long.txt < /dev/null
+
+"${NANOTTS}" -l lang -v en-US --save-image ${TMP}/en-US.img > /dev/null 2>&1
+check "engine image" -v en-US --load-image ${TMP}/en-US.img < ${TESTS}/corpus/en-US.txt
+
+# encoded output, with every codec but pcm
+for codec in ulaw alaw adpcm flac; do
+    check "codec ${codec}" -v en-US --codec ${codec} < ${TESTS}/corpus/en-US.txt
+done
+
+# the mul pdfs expanded at load time: the same audio, the Lingware in more memory
+"${NANOTTS}" -l lang -v en-US --stats -c < /dev/null > /dev/null 2> ${TMP}/err.txt
+compressed=$(awk '/Lingware and voice/ { print $4 }' ${TMP}/err.txt)
+"${NANOTTS}" -l lang -v en-US --expand-pdfs --stats -c < ${TESTS}/corpus/en-US.txt > ${TMP}/out.raw 2> ${TMP}/err.txt
+if [ ${UPDATE} -eq 0 ]; then
+    expected=$(awk 'substr($0, 35) == "en-US default" { print $1; exit }' ${GOLDEN})
+    hash=$(md5sum < ${TMP}/out.raw | cut -d' ' -f1)
+    expanded=$(awk '/Lingware and voice/ { print $4 }' ${TMP}/err.txt)
+    [ "${hash}" == "${expected}" ] && [ "${expanded:-0}" -gt "${compressed:-0}" ]
+    result $? "expanded pdfs" "hash ${hash}, Lingware ${expanded} bytes, ${compressed} compressed"
+fi
+
+# timing: the same audio with --marks, and marks up to its end
+"${NANOTTS}" -l lang -v en-US --marks ${TMP}/marks.jsonl -c < ${TESTS}/corpus/en-US.txt > ${TMP}/out.raw 2> ${TMP}/err.txt
+if [ ${UPDATE} -eq 0 ]; then
+    expected=$(awk 'substr($0, 35) == "en-US default" { print $1; exit }' ${GOLDEN})
+    hash=$(md5sum < ${TMP}/out.raw | cut -d' ' -f1)
+    samples=$(( $(stat -c %s ${TMP}/out.raw) / 2 ))
+    end=$(grep -o '"end":[0-9]*' ${TMP}/marks.jsonl | cut -d: -f2 | sort -n | tail -1)
+    texts=$(grep -c '"type":"text"' ${TMP}/marks.jsonl)
+    [ "${hash}" == "${expected}" ] && [ "${end}" == "${samples}" ] && [ ${texts} -gt 0 ]
+    result $? "marks" "hash ${hash}, marks end at ${end} of ${samples} samples, ${texts} texts"
+fi
+
+# float paths
+check_snr "rate-8000" -v en-US --rate 8000 < <(echo "Yes.")
+check_snr "rate-24000" -v en-US --rate 24000 < <(echo "Yes.")
+
+# playback, through the file plugin: what is played is the stdout output
+play() {
+    local name=$1
+    shift
+    rm -f ${TMP}/play.raw
+    "${NANOTTS}" -l lang -v en-US -p --device "file:'${TMP}/play.raw',raw" "$@" < ${TESTS}/corpus/en-US.txt > /dev/null 2> ${TMP}/err.txt
+    local rc=$?
+    [ ${UPDATE} -eq 1 ] && return
+    if [ ${rc} -ne 0 ]; then
+        result 1 "${name}" "exit code ${rc}: $(tail -1 ${TMP}/err.txt)"
+        return
+    fi
+    local expected=$(awk 'substr($0, 35) == "en-US default" { print $1; exit }' ${GOLDEN})
+    local hash=$(md5sum < ${TMP}/play.raw | cut -d' ' -f1)
+    [ "${hash}" == "${expected}" ]
+    result $? "${name}" "$(stat -c %s ${TMP}/play.raw) bytes, hash ${hash}"
+}
+
+if ldd "${NANOTTS}" 2> /dev/null | grep -q libasound; then
+    play "playback, mmap"
+    play "playback, writes" --no-mmap
+    play "playback, low latency" --latency low
+    play "playback, robust" --latency robust
+fi
+
+if [ ${UPDATE} -eq 1 ]; then
+    cp ${TMP}/golden.md5 ${GOLDEN}
+    echo "updated ${GOLDEN} and ${TESTS}/ref/"
+    exit 0
+fi
+
+echo "${passed} passed, ${failed} failed"
+[ ${failed} -eq 0 ]
@@ -0,0 +1,259 @@
+/*
+ * libtest: the library API of libnanotts, see src/nanotts.h
+ *
+ * usage: libtest [Lingware directory]
+ * run from the top of the tree, 'make test' does; exits 1 if a case fails
+ */
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "src/nanotts.h"
+
+static const char * text = "Hello world. This text is long enough to be cancelled while it is spoken.";
+
+static int passed = 0;
+static int failed = 0;
+
+static void result( bool ok, const char * name, int res, size_t samples )
+{
+    if ( ok ) {
+        passed++;
+        printf( "ok    %s\n", name );
+    } else {
+        failed++;
+        printf( "FAIL  %s (returned %d, %zu samples)\n", name, res, samples );
+    }
+}
+
+// cancels its engine at the first samples
+class cancelling_sink_t : public nanotts::BufferSink {
+public:
+    cancelling_sink_t( nanotts::Engine & _engine, short * buffer, size_t capacity ) :
+        nanotts::BufferSink( buffer, capacity ), engine( _engine ) {}
+    void write( const short * samples, unsigned int count ) {
+        if ( size() == 0 )
+            engine.cancel();
+        nanotts::BufferSink::write( samples, count );
+    }
+
+    nanotts::Engine &   engine;
+};
+
+// counts the TEXT marks
+class marks_sink_t : public nanotts::BufferSink {
+public:
+    marks_sink_t( short * buffer, size_t capacity ) : nanotts::BufferSink( buffer, capacity ), texts( 0 ) {}
+    void mark( const nanotts::Mark & m ) {
+        if ( m.type == nanotts::Mark::TEXT )
+            texts++;
+    }
+
+    unsigned int        texts;
+};
+
+// a text spoken on an engine of a pool, in a thread of its own
+struct pool_text_t {
+    nanotts::EnginePool *   pool;
+    bool                    cancel;
+    short                   buffer[ 16000 * 30 ];
+    size_t                  samples;
+    int                     res;
+};
+
+static void * speak_from_pool( void * arg )
+{
+    pool_text_t * t = (pool_text_t *) arg;
+    nanotts::EnginePool::Lease engine( *t->pool, "en-US" );
+
+    t->res = -1;
+    t->samples = 0;
+    if ( !engine.get() )
+        return 0;
+
+    cancelling_sink_t cancelling( *engine.get(), t->buffer, sizeof(t->buffer) / sizeof(short) );
+    nanotts::BufferSink sink( t->buffer, sizeof(t->buffer) / sizeof(short) );
+    nanotts::Sink & to = t->cancel ? (nanotts::Sink &) cancelling : (nanotts::Sink &) sink;
+
+    t->res = engine->synthesize( text, nanotts::Params(), to );
+    t->samples = t->cancel ? cancelling.size() : sink.size();
+    return 0;
+}
+
+// a long batch text on a scheduler; tells when its first samples are out
+struct batch_text_t : public nanotts::BufferSink {
+    batch_text_t( nanotts::Scheduler & scheduler, const char * text, short * buffer, size_t capacity ) :
+        nanotts::BufferSink( buffer, capacity ), scheduler( scheduler ), text( text ), started( false ), res( -1 ) {
+        pthread_mutex_init( &lock, 0 );
+        pthread_cond_init( &speaking, 0 );
+    }
+    ~batch_text_t() {
+        pthread_cond_destroy( &speaking );
+        pthread_mutex_destroy( &lock );
+    }
+    void write( const short * samples, unsigned int count ) {
+        nanotts::BufferSink::write( samples, count );
+        pthread_mutex_lock( &lock );
+        started = true;
+        pthread_cond_signal( &speaking );
+        pthread_mutex_unlock( &lock );
+    }
+    void waitSpeaking() {
+        pthread_mutex_lock( &lock );
+        while ( !started )
+            pthread_cond_wait( &speaking, &lock );
+        pthread_mutex_unlock( &lock );
+    }
+
+    nanotts::Scheduler &    scheduler;
+    const char *            text;
+    bool                    started;
+    int                     res;
+    pthread_mutex_t         lock;
+    pthread_cond_t          speaking;
+};
+
+static void * speak_batch( void * arg )
+{
+    batch_text_t * t = (batch_text_t *) arg;
+    t->res = t->scheduler.synthesize( nanotts::Scheduler::BATCH, "en-US", t->text, nanotts::Params(), *t );
+    return 0;
+}
+
+int main( int argc, char ** argv )
+{
+    enum { CAPACITY = 16000 * 30 };
+    static short buffer[ CAPACITY ];
+    nanotts::BufferSink sink( buffer, CAPACITY );
+    nanotts::Params params;
+    int res;
+
+    nanotts::Engine::Options options;
+    options.lingware_dir = argc > 1 ? argv[1] : "lang";
+
+    nanotts::Engine engine( "en-US", options );
+    if ( !engine.ready() ) {
+        printf( "libtest: cannot load en-US from %s\n", options.lingware_dir );
+        return 2;
+    }
+
+    res = engine.synthesize( text, params, sink );
+    size_t full = sink.size();
+    result( res == 0 && full > 0 && sink.dropped() == 0, "library, synthesize", res, full );
+
+    // a cancel while idle must not stop the next text
+    engine.cancel();
+    sink.clear();
+    res = engine.synthesize( text, params, sink );
+    result( res == 0 && sink.size() == full, "library, cancel while idle", res, sink.size() );
+
+    cancelling_sink_t cancelling( engine, buffer, CAPACITY );
+    res = engine.synthesize( text, params, cancelling );
+    result( res == nanotts::Engine::CANCELLED && cancelling.size() < full, "library, cancel while speaking", res, cancelling.size() );
+
+    // the engine takes the next text after a cancel
+    sink.clear();
+    res = engine.synthesize( text, params, sink );
+    result( res == 0 && sink.size() == full, "library, text after a cancel", res, sink.size() );
+
+    // two engines of a pool at once, one of them cancelled
+    nanotts::EnginePool pool( options, 2 );
+    static pool_text_t texts[ 2 ];
+    pthread_t threads[ 2 ];
+    for ( int i = 0; i < 2; i++ ) {
+        texts[i].pool = &pool;
+        texts[i].cancel = i == 0;
+        pthread_create( &threads[i], 0, speak_from_pool, &texts[i] );
+    }
+    for ( int i = 0; i < 2; i++ )
+        pthread_join( threads[i], 0 );
+    result( texts[0].res == nanotts::Engine::CANCELLED && texts[0].samples < full,
+            "pool, cancel while speaking", texts[0].res, texts[0].samples );
+    result( texts[1].res == 0 && texts[1].samples == full, "pool, text next to a cancel", texts[1].res, texts[1].samples );
+
+    // both engines, the cancelled one included, take the next text: one
+    // held here, the other by a thread
+    texts[0].cancel = false;
+    {
+        nanotts::EnginePool::Lease held( pool, "en-US" );
+        pthread_create( &threads[0], 0, speak_from_pool, &texts[0] );
+        sink.clear();
+        res = held.get() ? held->synthesize( text, params, sink ) : -1;
+        pthread_join( threads[0], 0 );
+    }
+    result( res == 0 && sink.size() == full && texts[0].res == 0 && texts[0].samples == full,
+            "pool, texts after a cancel", texts[0].res, texts[0].samples );
+
+    // the marks of a scheduled text reach the caller's sink
+    nanotts::Scheduler scheduler( 1, 1, 1, options );
+    nanotts::Params with_marks;
+    with_marks.marks = true;
+    marks_sink_t marks( buffer, CAPACITY );
+    res = scheduler.synthesize( nanotts::Scheduler::INTERACTIVE, "en-US", text, with_marks, marks );
+    result( res == 0 && marks.size() == full && marks.texts > 0, "scheduler, marks", res, marks.size() );
+
+    // an interactive text while a batch text runs on the only slot: the
+    // batch text gives it the slot at the end of a sentence
+    enum { LONG_CAPACITY = 16000 * 120 };
+    static short long_buffer[ LONG_CAPACITY ];
+    static char long_text[ 2048 ];
+    long_text[0] = 0;
+    for ( int i = 0; i < 30; i++ )
+        snprintf( long_text + strlen( long_text ), sizeof(long_text) - strlen( long_text ),
+                  "This is sentence number %d of the batch text. ", i + 1 );
+    nanotts::BufferSink long_sink( long_buffer, LONG_CAPACITY );
+    engine.synthesize( long_text, params, long_sink );
+    size_t long_full = long_sink.size();
+
+    nanotts::Scheduler preempting( 1, 1, 1, options );
+    batch_text_t batch( preempting, long_text, long_buffer, LONG_CAPACITY );
+    pthread_t batch_thread;
+    pthread_create( &batch_thread, 0, speak_batch, &batch );
+    batch.waitSpeaking();
+    sink.clear();
+    res = preempting.synthesize( nanotts::Scheduler::INTERACTIVE, "en-US", text, params, sink );
+    pthread_join( batch_thread, 0 );
+    result( res == 0 && sink.size() == full, "scheduler, interactive text", res, sink.size() );
+    result( batch.res == 0 && batch.size() == long_full && batch.dropped() == 0, "scheduler, preempted batch text",
+            batch.res, batch.size() );
+    nanotts::Scheduler::Stats batch_stats = preempting.stats( nanotts::Scheduler::BATCH );
+    nanotts::Scheduler::Stats interactive_stats = preempting.stats( nanotts::Scheduler::INTERACTIVE );
+    result( batch_stats.preempted >= 1 && batch_stats.texts == 1 && interactive_stats.texts == 1,
+            "scheduler, stats", (int) batch_stats.preempted, interactive_stats.texts );
+
+    // the CPU sets of the nodes, narrowed to a CPU each so that running on
+    // one shows even on a machine of one node
+    enum { MAX_SETS = 64 };
+    static cpu_set_t sets[ MAX_SETS ];
+    unsigned int set_count = nanotts::nodeCpuSets( sets, MAX_SETS );
+    bool sets_ok = set_count > 0;
+    for ( unsigned int i = 0; i < set_count; i++ ) {
+        int cpu = 0;
+        sets_ok = sets_ok && CPU_COUNT( &sets[i] ) > 0;
+        while ( cpu < CPU_SETSIZE && !CPU_ISSET( cpu, &sets[i] ) )
+            cpu++;
+        CPU_ZERO( &sets[i] );
+        CPU_SET( cpu, &sets[i] );
+    }
+    result( sets_ok, "pool, node CPU sets", 0, set_count );
+
+    cpu_set_t before, leased, after;
+    sched_getaffinity( 0, sizeof(before), &before );
+    nanotts::EnginePool pinned( options, 1 );
+    pinned.setCpuSets( sets, set_count );
+    {
+        nanotts::EnginePool::Lease held( pinned, "en-US" );
+        sched_getaffinity( 0, sizeof(leased), &leased );
+        sink.clear();
+        res = held.get() ? held->synthesize( text, params, sink ) : -1;
+        nanotts::Engine::Stats stats = held.get() ? held->stats() : nanotts::Engine::Stats();
+        result( res == 0 && stats.texts == 1 && stats.audio_ms == full * 1000.0 / params.rate,
+                "pool, engine stats", res, stats.texts );
+    }
+    sched_getaffinity( 0, sizeof(after), &after );
+    result( set_count > 0 && CPU_EQUAL( &leased, &sets[0] ), "pool, running on the engine's CPUs", 0, CPU_COUNT( &leased ) );
+    result( CPU_EQUAL( &after, &before ), "pool, CPUs restored on release", 0, CPU_COUNT( &after ) );
+
+    printf( "%d passed, %d failed\n", passed, failed );
+    return failed ? 1 : 0;
+}
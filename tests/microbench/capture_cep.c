@@ -0,0 +1,98 @@
+/*
+ * capture_cep: the smoothing of picocep.c, with the frame indices of each
+ * sentence. The step of the unit is wrapped to take them when it is about
+ * to smooth; the replay is the SMOOTH state of cepStep().
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#define picocep_newCepUnit picocep_newCepUnit_impl
+#include "picocep.c"
+#undef picocep_newCepUnit
+
+#include "microbench.h"
+
+typedef struct {
+    cep_subobj_t *  cep;
+    picoos_uint16   N;
+    picoos_uint16 * indicesLFZ;
+    picoos_uint16 * indicesMGC;
+} cep_input_t;
+
+static cep_input_t cep_inputs[ MB_MAX_INPUTS ];
+static unsigned int cep_count;
+
+static picodata_step_result_t cepCaptureStep(register picodata_ProcessingUnit this,
+        picoos_int16 mode, picoos_uint16 * numBytesOutput)
+{
+    cep_subobj_t * cep = (cep_subobj_t *) this->subObj;
+
+    if (mb_capturing && cep_count < MB_MAX_INPUTS && cep->procState == PICOCEP_STEPSTATE_PROCESS_SMOOTH
+            && cep->activeEndPos > 0) {
+        cep_input_t * in = &cep_inputs[ cep_count ];
+        picoos_uint16 N = cep->activeEndPos;
+        in->indicesLFZ = (picoos_uint16 *) malloc( N * sizeof(picoos_uint16) );
+        in->indicesMGC = (picoos_uint16 *) malloc( N * sizeof(picoos_uint16) );
+        if (in->indicesLFZ && in->indicesMGC) {
+            memcpy( in->indicesLFZ, cep->indicesLFZ, N * sizeof(picoos_uint16) );
+            memcpy( in->indicesMGC, cep->indicesMGC, N * sizeof(picoos_uint16) );
+            in->cep = cep;
+            in->N = N;
+            cep_count++;
+        }
+    }
+    return cepStep( this, mode, numBytesOutput );
+}
+
+picodata_ProcessingUnit picocep_newCepUnit(picoos_MemoryManager mm,
+        picoos_Common common, picodata_CharBuffer cbIn,
+        picodata_CharBuffer cbOut, picorsrc_Voice voice)
+{
+    picodata_ProcessingUnit this = picocep_newCepUnit_impl( mm, common, cbIn, cbOut, voice );
+    if (this != NULL) {
+        this->step = cepCaptureStep;
+    }
+    return this;
+}
+
+static unsigned int cep_inputs_count( void ) { return cep_count; }
+
+/* into the output buffers of the idle unit */
+static void cep_run( void )
+{
+    unsigned int i;
+    picoos_uint8 cepnum;
+
+    for ( i = 0; i < cep_count; i++ ) {
+        cep_input_t * in = &cep_inputs[ i ];
+        cep_subobj_t * cep = in->cep;
+        picokpdf_PdfMUL pdf;
+        picoos_uint16 N = in->N;
+
+        pdf = cep->pdflfz;
+        for (cepnum = 0; cepnum < pdf->ceporder; cepnum++) {
+            if (3 < N) {
+                makeWUWandWUm( cep, pdf, in->indicesLFZ, 0, N, cepnum );
+                invMatrix( cep, N, cep->outF0, cepnum, pdf, PICOCEP_LFZINVPOW, PICOCEP_LFZDOUBLEDEC );
+            } else {
+                getDirect( pdf, in->indicesLFZ, N, cepnum, cep->outF0 );
+            }
+        }
+
+        pdf = cep->pdfmgc;
+        for (cepnum = 0; cepnum < pdf->ceporder; cepnum++) {
+            if (3 < N) {
+                makeWUWandWUm( cep, pdf, in->indicesMGC, 0, N, cepnum );
+                invMatrix( cep, N, cep->outXCep, cepnum, pdf, PICOCEP_MGCINVPOW, PICOCEP_MGCDOUBLEDEC );
+            } else {
+                getDirect( pdf, in->indicesMGC, N, cepnum, cep->outXCep );
+            }
+        }
+        getVoiced( pdf, in->indicesMGC, N, cep->outVoiced );
+    }
+}
+
+const mb_kernel_t mb_cep_kernels[] = {
+    { "picocep smoothing", cep_inputs_count, cep_run },
+    { 0, 0, 0 }
+};
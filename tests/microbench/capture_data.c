@@ -0,0 +1,59 @@
+/*
+ * capture_data: picodata_cbPutItem() and picodata_cbGetItem() of
+ * picodata.c, with the items the units pass on. An item is put into the
+ * char buffer it went to and taken out again.
+ */
+#include <string.h>
+
+#define picodata_cbPutItem picodata_cbPutItem_impl
+#include "picodata.c"
+#undef picodata_cbPutItem
+
+#include "microbench.h"
+
+typedef struct {
+    picodata_CharBuffer cb;
+    picoos_uint16       len;
+    picoos_uint8        item[ PICODATA_MAX_ITEMSIZE ];
+} data_input_t;
+
+static data_input_t data_inputs[ MB_MAX_INPUTS ];
+static unsigned int data_count;
+
+pico_status_t picodata_cbPutItem(register picodata_CharBuffer this,
+        const picoos_uint8 *buf, const picoos_uint16 blenmax,
+        picoos_uint16 *blen)
+{
+    if (mb_capturing && data_count < MB_MAX_INPUTS && blenmax >= PICODATA_ITEM_HEADSIZE) {
+        data_input_t * in = &data_inputs[ data_count ];
+        picoos_uint16 len = PICODATA_ITEM_HEADSIZE + buf[ PICODATA_ITEMIND_LEN ];
+        if (len <= blenmax) {
+            in->cb = this;
+            in->len = len;
+            memcpy( in->item, buf, len );
+            data_count++;
+        }
+    }
+    return picodata_cbPutItem_impl( this, buf, blenmax, blen );
+}
+
+static unsigned int data_inputs_count( void ) { return data_count; }
+
+/* the buffers are those of the idle engine, what goes in comes out */
+static void data_run( void )
+{
+    static picoos_uint8 item[ PICODATA_MAX_ITEMSIZE ];
+    picoos_uint16 blen;
+    unsigned int i;
+
+    for ( i = 0; i < data_count; i++ ) {
+        data_input_t * in = &data_inputs[ i ];
+        if (picodata_cbPutItem_impl( in->cb, in->item, in->len, &blen ) == PICO_OK)
+            picodata_cbGetItem( in->cb, item, sizeof(item), &blen );
+    }
+}
+
+const mb_kernel_t mb_data_kernels[] = {
+    { "picodata_cbPutItem+cbGetItem", data_inputs_count, data_run },
+    { 0, 0, 0 }
+};
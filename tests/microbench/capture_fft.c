@@ -0,0 +1,49 @@
+/*
+ * capture_fft: rdft() of picofftsg.c, with the frames of picosig2.c
+ */
+#include <string.h>
+
+#define rdft rdft_impl
+#include "picofftsg.c"
+#undef rdft
+
+#include "picodsp.h"
+#include "microbench.h"
+
+typedef struct {
+    picoos_int32        n, isgn;
+    PICOFFTSG_FFTTYPE   a[ PICODSP_FFTSIZE ];
+} fft_input_t;
+
+static fft_input_t fft_inputs[ MB_MAX_INPUTS ];
+static unsigned int fft_count;
+
+void rdft(picoos_int32 n, picoos_int32 isgn, PICOFFTSG_FFTTYPE *a)
+{
+    if (mb_capturing && fft_count < MB_MAX_INPUTS && n <= PICODSP_FFTSIZE) {
+        fft_input_t * in = &fft_inputs[ fft_count++ ];
+        in->n = n;
+        in->isgn = isgn;
+        memcpy( in->a, a, n * sizeof(PICOFFTSG_FFTTYPE) );
+    }
+    rdft_impl( n, isgn, a );
+}
+
+static unsigned int fft_inputs_count( void ) { return fft_count; }
+
+static void fft_run( void )
+{
+    static PICOFFTSG_FFTTYPE work[ PICODSP_FFTSIZE ];
+    unsigned int i;
+
+    for ( i = 0; i < fft_count; i++ ) {
+        fft_input_t * in = &fft_inputs[ i ];
+        memcpy( work, in->a, in->n * sizeof(PICOFFTSG_FFTTYPE) );
+        rdft_impl( in->n, in->isgn, work );
+    }
+}
+
+const mb_kernel_t mb_fft_kernels[] = {
+    { "rdft", fft_inputs_count, fft_run },
+    { 0, 0, 0 }
+};
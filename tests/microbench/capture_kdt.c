@@ -0,0 +1,120 @@
+/*
+ * capture_kdt: kdtAskTree() of picokdt.c, one kernel per tree type. The
+ * input vectors are those of the classify calls, the trees of the lingware.
+ */
+#include <string.h>
+
+#define picokdt_dtPosPclassify picokdt_dtPosPclassify_impl
+#define picokdt_dtPosDclassify picokdt_dtPosDclassify_impl
+#define picokdt_dtG2Pclassify picokdt_dtG2Pclassify_impl
+#define picokdt_dtPHRclassify picokdt_dtPHRclassify_impl
+#define picokdt_dtACCclassify picokdt_dtACCclassify_impl
+#define picokdt_dtPAMclassify picokdt_dtPAMclassify_impl
+#include "picokdt.c"
+#undef picokdt_dtPosPclassify
+#undef picokdt_dtPosDclassify
+#undef picokdt_dtG2Pclassify
+#undef picokdt_dtPHRclassify
+#undef picokdt_dtACCclassify
+#undef picokdt_dtPAMclassify
+
+#include "microbench.h"
+
+#define KDT_MAX_NRATT PICOKDT_NRATT_PAM     /* the largest */
+
+typedef struct {
+    kdt_subobj_t *  dt;
+    picoos_uint16   invec[ KDT_MAX_NRATT ];
+} kdt_input_t;
+
+typedef struct {
+    kdt_input_t     inputs[ MB_MAX_INPUTS ];
+    unsigned int    count;
+} kdt_inputs_t;
+
+static void kdt_capture( kdt_inputs_t * in, kdt_subobj_t * dt, const picoos_uint16 * invec, kdt_nratt_t nratt )
+{
+    if (mb_capturing && in->count < MB_MAX_INPUTS) {
+        in->inputs[ in->count ].dt = dt;
+        memcpy( in->inputs[ in->count ].invec, invec, nratt * sizeof(picoos_uint16) );
+        in->count++;
+    }
+}
+
+/* the walk of the classify functions */
+static void kdt_run( kdt_inputs_t * in, kdt_nratt_t nratt )
+{
+    unsigned int i;
+
+    for ( i = 0; i < in->count; i++ ) {
+        picoos_uint32 iByteNo = 0;
+        picoos_int8 iBitNo = 7;
+        while (kdtAskTree( in->inputs[ i ].dt, in->inputs[ i ].invec, nratt, &iByteNo, &iBitNo ) > 0)
+            ;
+    }
+}
+
+/* the inputs and the kernel of a tree type */
+#define KDT_KERNEL( type, NRATT ) \
+    static kdt_inputs_t kdt_##type##_inputs; \
+    static unsigned int kdt_##type##_count( void ) { return kdt_##type##_inputs.count; } \
+    static void kdt_##type##_run( void ) { kdt_run( &kdt_##type##_inputs, NRATT ); }
+
+KDT_KERNEL( posp, PICOKDT_NRATT_POSP )
+KDT_KERNEL( posd, PICOKDT_NRATT_POSD )
+KDT_KERNEL( g2p, PICOKDT_NRATT_G2P )
+KDT_KERNEL( phr, PICOKDT_NRATT_PHR )
+KDT_KERNEL( acc, PICOKDT_NRATT_ACC )
+KDT_KERNEL( pam, PICOKDT_NRATT_PAM )
+
+picoos_uint8 picokdt_dtPosPclassify(const picokdt_DtPosP this)
+{
+    kdtposp_subobj_t * dtposp = (kdtposp_subobj_t *) this;
+    kdt_capture( &kdt_posp_inputs, &dtposp->dt, dtposp->invec, PICOKDT_NRATT_POSP );
+    return picokdt_dtPosPclassify_impl( this );
+}
+
+picoos_uint8 picokdt_dtPosDclassify(const picokdt_DtPosD this, picoos_uint16 *treeout)
+{
+    kdtposd_subobj_t * dtposd = (kdtposd_subobj_t *) this;
+    kdt_capture( &kdt_posd_inputs, &dtposd->dt, dtposd->invec, PICOKDT_NRATT_POSD );
+    return picokdt_dtPosDclassify_impl( this, treeout );
+}
+
+picoos_uint8 picokdt_dtG2Pclassify(const picokdt_DtG2P this, picoos_uint16 *treeout)
+{
+    kdtg2p_subobj_t * dtg2p = (kdtg2p_subobj_t *) this;
+    kdt_capture( &kdt_g2p_inputs, &dtg2p->dt, dtg2p->invec, PICOKDT_NRATT_G2P );
+    return picokdt_dtG2Pclassify_impl( this, treeout );
+}
+
+picoos_uint8 picokdt_dtPHRclassify(const picokdt_DtPHR this)
+{
+    kdtphr_subobj_t * dtphr = (kdtphr_subobj_t *) this;
+    kdt_capture( &kdt_phr_inputs, &dtphr->dt, dtphr->invec, PICOKDT_NRATT_PHR );
+    return picokdt_dtPHRclassify_impl( this );
+}
+
+picoos_uint8 picokdt_dtACCclassify(const picokdt_DtACC this, picoos_uint16 *treeout)
+{
+    kdtacc_subobj_t * dtacc = (kdtacc_subobj_t *) this;
+    kdt_capture( &kdt_acc_inputs, &dtacc->dt, dtacc->invec, PICOKDT_NRATT_ACC );
+    return picokdt_dtACCclassify_impl( this, treeout );
+}
+
+picoos_uint8 picokdt_dtPAMclassify(const picokdt_DtPAM this)
+{
+    kdtpam_subobj_t * dtpam = (kdtpam_subobj_t *) this;
+    kdt_capture( &kdt_pam_inputs, &dtpam->dt, dtpam->invec, PICOKDT_NRATT_PAM );
+    return picokdt_dtPAMclassify_impl( this );
+}
+
+const mb_kernel_t mb_kdt_kernels[] = {
+    { "kdtAskTree/posp", kdt_posp_count, kdt_posp_run },
+    { "kdtAskTree/posd", kdt_posd_count, kdt_posd_run },
+    { "kdtAskTree/g2p", kdt_g2p_count, kdt_g2p_run },
+    { "kdtAskTree/phr", kdt_phr_count, kdt_phr_run },
+    { "kdtAskTree/acc", kdt_acc_count, kdt_acc_run },
+    { "kdtAskTree/pam", kdt_pam_count, kdt_pam_run },
+    { 0, 0, 0 }
+};
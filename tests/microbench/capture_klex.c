@@ -0,0 +1,50 @@
+/*
+ * capture_klex: picoklex_lexLookup() of picoklex.c, with the words of
+ * picowa.c
+ */
+#include <string.h>
+
+#define picoklex_lexLookup picoklex_lexLookup_impl
+#include "picoklex.c"
+#undef picoklex_lexLookup
+
+#include "microbench.h"
+
+typedef struct {
+    picoklex_Lex    lex;
+    picoos_uint16   graphlen;
+    picoos_uint8    graph[ 256 ];
+} klex_input_t;
+
+static klex_input_t klex_inputs[ MB_MAX_INPUTS ];
+static unsigned int klex_count;
+
+picoos_uint8 picoklex_lexLookup(const picoklex_Lex this,
+                                const picoos_uint8 *graph,
+                                const picoos_uint16 graphlen,
+                                picoklex_lexl_result_t *lexres)
+{
+    if (mb_capturing && klex_count < MB_MAX_INPUTS && graphlen <= sizeof(klex_inputs[0].graph)) {
+        klex_input_t * in = &klex_inputs[ klex_count++ ];
+        in->lex = this;
+        in->graphlen = graphlen;
+        memcpy( in->graph, graph, graphlen );
+    }
+    return picoklex_lexLookup_impl( this, graph, graphlen, lexres );
+}
+
+static unsigned int klex_inputs_count( void ) { return klex_count; }
+
+static void klex_run( void )
+{
+    picoklex_lexl_result_t lexres;
+    unsigned int i;
+
+    for ( i = 0; i < klex_count; i++ )
+        picoklex_lexLookup_impl( klex_inputs[ i ].lex, klex_inputs[ i ].graph, klex_inputs[ i ].graphlen, &lexres );
+}
+
+const mb_kernel_t mb_klex_kernels[] = {
+    { "picoklex_lexLookup", klex_inputs_count, klex_run },
+    { 0, 0, 0 }
+};
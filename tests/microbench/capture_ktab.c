@@ -0,0 +1,46 @@
+/*
+ * capture_ktab: picoktab_graphOffset() of picoktab.c, with the graphemes of
+ * picopr.c
+ */
+#include <string.h>
+
+#define picoktab_graphOffset picoktab_graphOffset_impl
+#include "picoktab.c"
+#undef picoktab_graphOffset
+
+#include "microbench.h"
+
+typedef struct {
+    picoktab_Graphs     graphs;
+    picobase_utf8char   graph;
+} ktab_input_t;
+
+static ktab_input_t ktab_inputs[ MB_MAX_INPUTS ];
+static unsigned int ktab_count;
+
+picoos_uint32 picoktab_graphOffset (const picoktab_Graphs this, picoos_uchar * utf8graph)
+{
+    if (mb_capturing && ktab_count < MB_MAX_INPUTS) {
+        ktab_input_t * in = &ktab_inputs[ ktab_count++ ];
+        picoos_uint8 len = picobase_det_utf8_length( utf8graph[0] );
+        in->graphs = this;
+        memcpy( in->graph, utf8graph, len );
+        in->graph[ len ] = 0;
+    }
+    return picoktab_graphOffset_impl( this, utf8graph );
+}
+
+static unsigned int ktab_inputs_count( void ) { return ktab_count; }
+
+static void ktab_run( void )
+{
+    unsigned int i;
+
+    for ( i = 0; i < ktab_count; i++ )
+        picoktab_graphOffset_impl( ktab_inputs[ i ].graphs, ktab_inputs[ i ].graph );
+}
+
+const mb_kernel_t mb_ktab_kernels[] = {
+    { "picoktab_graphOffset", ktab_inputs_count, ktab_run },
+    { 0, 0, 0 }
+};
@@ -0,0 +1,126 @@
+/*
+ * capture_os: picoos_allocate() and picoos_deallocate() of picoos.c, in the
+ * order of an engine's life: the memory managers made while
+ * mb_capturing_alloc is set and the calls on them.
+ */
+#include <stdlib.h>
+
+#define picoos_newMemoryManager picoos_newMemoryManager_impl
+#define picoos_allocate picoos_allocate_impl
+#define picoos_deallocate picoos_deallocate_impl
+#include "picoos.c"
+#undef picoos_newMemoryManager
+#undef picoos_allocate
+#undef picoos_deallocate
+
+#include "microbench.h"
+
+#define OS_MAX_MMS      8
+#define OS_MAX_OPS      (16 * MB_MAX_INPUTS)
+
+typedef struct {
+    picoos_MemoryManager    mm;         /* captured */
+    picoos_objsize_t        size;
+    void *                  raw;        /* of the replay */
+} os_mm_t;
+
+typedef struct {
+    picoos_uint8        mm;             /* index in os_mms */
+    picoos_uint8        allocate;       /* or deallocate */
+    picoos_uint32       id;             /* of the object */
+    picoos_objsize_t    size;
+} os_op_t;
+
+static os_mm_t os_mms[ OS_MAX_MMS ];
+static unsigned int os_mm_count;
+static os_op_t os_ops[ OS_MAX_OPS ];
+static unsigned int os_op_count;
+static void * os_live[ OS_MAX_OPS ];    /* object of an id, while captured */
+static unsigned int os_ids;
+
+static int os_find_mm( picoos_MemoryManager mm )
+{
+    unsigned int i;
+    for ( i = 0; i < os_mm_count; i++ )
+        if (os_mms[ i ].mm == mm)
+            return i;
+    return -1;
+}
+
+picoos_MemoryManager picoos_newMemoryManager(
+        void *raw_memory,
+        picoos_objsize_t size,
+        picoos_bool enableMemProt)
+{
+    picoos_MemoryManager mm = picoos_newMemoryManager_impl( raw_memory, size, enableMemProt );
+    if (mb_capturing_alloc && mm && os_mm_count < OS_MAX_MMS) {
+        os_mms[ os_mm_count ].mm = mm;
+        os_mms[ os_mm_count ].size = size;
+        os_mm_count++;
+    }
+    return mm;
+}
+
+void * picoos_allocate(picoos_MemoryManager this,
+        picoos_objsize_t byteSize)
+{
+    void * adr = picoos_allocate_impl( this, byteSize );
+    int mm;
+
+    if (mb_capturing_alloc && adr && os_op_count < OS_MAX_OPS && (mm = os_find_mm( this )) >= 0) {
+        os_op_t * op = &os_ops[ os_op_count++ ];
+        op->mm = mm;
+        op->allocate = TRUE;
+        op->id = os_ids;
+        op->size = byteSize;
+        os_live[ os_ids++ ] = adr;
+    }
+    return adr;
+}
+
+void picoos_deallocate(picoos_MemoryManager this, void * * adr)
+{
+    int mm;
+
+    if (mb_capturing_alloc && *adr && os_op_count < OS_MAX_OPS && (mm = os_find_mm( this )) >= 0) {
+        unsigned int id;
+        for ( id = 0; id < os_ids; id++ ) {
+            if (os_live[ id ] == *adr) {
+                os_op_t * op = &os_ops[ os_op_count++ ];
+                op->mm = mm;
+                op->allocate = FALSE;
+                op->id = id;
+                os_live[ id ] = NULL;
+                break;
+            }
+        }
+    }
+    picoos_deallocate_impl( this, adr );
+}
+
+static unsigned int os_inputs_count( void ) { return os_op_count; }
+
+/* the calls on fresh memory managers of the same sizes */
+static void os_run( void )
+{
+    static picoos_MemoryManager mms[ OS_MAX_MMS ];
+    unsigned int i;
+
+    for ( i = 0; i < os_mm_count; i++ ) {
+        if (!os_mms[ i ].raw && !(os_mms[ i ].raw = malloc( os_mms[ i ].size )))
+            return;
+        mms[ i ] = picoos_newMemoryManager_impl( os_mms[ i ].raw, os_mms[ i ].size, FALSE );
+    }
+    for ( i = 0; i < os_op_count; i++ ) {
+        os_op_t * op = &os_ops[ i ];
+        if (op->allocate)
+            os_live[ op->id ] = picoos_allocate_impl( mms[ op->mm ], op->size );
+        else if (os_live[ op->id ])
+            picoos_deallocate_impl( mms[ op->mm ], &os_live[ op->id ] );
+    }
+}
+
+const mb_kernel_t mb_os_kernels[] = {
+    { "picoos_allocate+deallocate", os_inputs_count, os_run },
+    { 0, 0, 0 }
+};
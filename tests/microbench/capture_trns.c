@@ -0,0 +1,73 @@
+/*
+ * capture_trns: picotrns_transduce() of picotrns.c, with the phone
+ * sequences and transducers of picosa.c and picospho.c
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#define picotrns_transduce picotrns_transduce_impl
+#include "picotrns.c"
+#undef picotrns_transduce
+
+#include "microbench.h"
+
+typedef struct {
+    picokfst_FST                fst;
+    picoos_bool                 firstSolOnly;
+    picotrns_printSolutionFct * printSolution;
+    picotrns_possym_t *         inSeq;
+    picoos_uint16               inSeqLen;
+    picoos_uint16               maxOutSeqLen;
+    picotrns_AltDesc            altDescBuf;     /* of the unit, scratch */
+    picoos_uint16               maxAltDescLen;
+} trns_input_t;
+
+static trns_input_t trns_inputs[ MB_MAX_INPUTS ];
+static unsigned int trns_count;
+
+pico_status_t picotrns_transduce (picokfst_FST fst, picoos_bool firstSolOnly,
+                                         picotrns_printSolutionFct printSolution,
+                                         const picotrns_possym_t inSeq[], picoos_uint16 inSeqLen,
+                                         picotrns_possym_t outSeq[], picoos_uint16 * outSeqLen, picoos_uint16 maxOutSeqLen,
+                                         picotrns_AltDesc altDescBuf, picoos_uint16 maxAltDescLen,
+                                         picoos_uint32 *nrSteps)
+{
+    if (mb_capturing && trns_count < MB_MAX_INPUTS) {
+        trns_input_t * in = &trns_inputs[ trns_count ];
+        in->inSeq = (picotrns_possym_t *) malloc( (inSeqLen + 1) * sizeof(picotrns_possym_t) );
+        if (in->inSeq) {
+            memcpy( in->inSeq, inSeq, inSeqLen * sizeof(picotrns_possym_t) );
+            in->fst = fst;
+            in->firstSolOnly = firstSolOnly;
+            in->printSolution = printSolution;
+            in->inSeqLen = inSeqLen;
+            in->maxOutSeqLen = maxOutSeqLen;
+            in->altDescBuf = altDescBuf;
+            in->maxAltDescLen = maxAltDescLen;
+            trns_count++;
+        }
+    }
+    return picotrns_transduce_impl( fst, firstSolOnly, printSolution, inSeq, inSeqLen,
+                                    outSeq, outSeqLen, maxOutSeqLen, altDescBuf, maxAltDescLen, nrSteps );
+}
+
+static unsigned int trns_inputs_count( void ) { return trns_count; }
+
+static void trns_run( void )
+{
+    static picotrns_possym_t outSeq[ 4 * PICOTRNS_MAX_NUM_POSSYM ];     /* the largest, of picospho.c */
+    picoos_uint16 outSeqLen;
+    picoos_uint32 nrSteps;
+    unsigned int i;
+
+    for ( i = 0; i < trns_count; i++ ) {
+        trns_input_t * in = &trns_inputs[ i ];
+        picotrns_transduce_impl( in->fst, in->firstSolOnly, in->printSolution, in->inSeq, in->inSeqLen,
+                                 outSeq, &outSeqLen, in->maxOutSeqLen, in->altDescBuf, in->maxAltDescLen, &nrSteps );
+    }
+}
+
+const mb_kernel_t mb_trns_kernels[] = {
+    { "picotrns_transduce", trns_inputs_count, trns_run },
+    { 0, 0, 0 }
+};
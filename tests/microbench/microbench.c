@@ -0,0 +1,321 @@
+/*
+ * microbench: times the hot kernels of svoxpico in isolation, see microbench.h
+ *
+ * usage: microbench [-l langdir] [-v voice] [-t text file] [--filter name]
+ *                   [--save file.json] [--compare file.json]
+ *
+ * The kernels' inputs are captured while the text (tests/corpus/<voice>.txt
+ * by default) is synthesized. Each kernel then runs over all its inputs
+ * again and again: SAMPLES samples of at least SAMPLE_NS, after a warmup.
+ * The times are ns per call. --compare reads a file of --save and marks
+ * the changes of the median beyond 3 standard deviations.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <glob.h>
+
+#include "picoapi.h"
+#include "microbench.h"
+
+#define MEM_SIZE        (8 * 1024 * 1024)  /* the lingware and an engine */
+#define VOICE_NAME      "microbench"
+#define SAMPLES         21
+#define SAMPLE_NS       2000000.0
+#define MAX_KERNELS     32
+
+int mb_capturing;
+int mb_capturing_alloc;
+
+typedef struct {
+    const mb_kernel_t * kernel;
+    unsigned int        calls;
+    double              median, mean, stddev, min;     /* ns per call */
+} result_t;
+
+static const mb_kernel_t * kernel_tables[] = {
+    mb_fft_kernels, mb_kdt_kernels, mb_klex_kernels, mb_ktab_kernels,
+    mb_trns_kernels, mb_os_kernels, mb_data_kernels, mb_cep_kernels, 0
+};
+
+static pico_System system_;
+static char memory[ MEM_SIZE ];
+
+static double now_ns( void )
+{
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+static int check( pico_Status status, const char * what )
+{
+    pico_Retstring message;
+    if ( status == PICO_OK )
+        return 1;
+    pico_getSystemStatusMessage( system_, status, message );
+    fprintf( stderr, "microbench: %s: %s\n", what, message );
+    return 0;
+}
+
+static char * read_text( const char * filename )
+{
+    FILE * fp = fopen( filename, "rb" );
+    char * text;
+    long size;
+
+    if ( !fp ) {
+        fprintf( stderr, "microbench: cannot open \"%s\"\n", filename );
+        return 0;
+    }
+    fseek( fp, 0, SEEK_END );
+    size = ftell( fp );
+    fseek( fp, 0, SEEK_SET );
+    text = (char *) malloc( size + 1 );
+    if ( text ) {
+        size = fread( text, 1, size, fp );
+        text[ size ] = 0;
+    }
+    fclose( fp );
+    return text;
+}
+
+/* loads <voice>_ta.bin and <voice>_*_sg.bin of langdir */
+static int load_voice( const char * langdir, const char * voice )
+{
+    char filename[ 1024 ];
+    pico_Retstring name;
+    pico_Resource resource;
+    glob_t sg;
+    int i;
+
+    if ( !check( pico_createVoiceDefinition( system_, (const pico_Char *) VOICE_NAME ), "voice" ) )
+        return 0;
+
+    snprintf( filename, sizeof(filename), "%s/%s_*_sg.bin", langdir, voice );
+    if ( glob( filename, 0, 0, &sg ) != 0 ) {
+        fprintf( stderr, "microbench: no \"%s\"\n", filename );
+        return 0;
+    }
+    for ( i = 0; i < 2; i++ ) {
+        if ( i == 0 )
+            snprintf( filename, sizeof(filename), "%s/%s_ta.bin", langdir, voice );
+        else
+            snprintf( filename, sizeof(filename), "%s", sg.gl_pathv[0] );
+        if ( !check( pico_loadResource( system_, (const pico_Char *) filename, &resource ), filename )
+                || !check( pico_getResourceName( system_, resource, name ), filename )
+                || !check( pico_addResourceToVoiceDefinition( system_, (const pico_Char *) VOICE_NAME,
+                                                              (const pico_Char *) name ), filename ) ) {
+            globfree( &sg );
+            return 0;
+        }
+    }
+    globfree( &sg );
+    return 1;
+}
+
+static int synthesize( pico_Engine engine, const char * text )
+{
+    const pico_Char * inp = (const pico_Char *) text;
+    pico_Int16 remaining = 0, sent, received, type;
+    long left = strlen( text ) + 1;     /* the 0 flushes */
+    short samples[ 512 ];
+    pico_Status status;
+
+    while ( left > 0 ) {
+        remaining = left > 32767 ? 32767 : left;
+        if ( !check( pico_putTextUtf8( engine, inp, remaining, &sent ), "put text" ) )
+            return 0;
+        inp += sent;
+        left -= sent;
+        do {
+            status = pico_getData( engine, samples, sizeof(samples), &received, &type );
+        } while ( status == PICO_STEP_BUSY );
+        if ( status != PICO_STEP_IDLE )
+            return check( status, "get data" );
+    }
+    return 1;
+}
+
+static int compare_double( const void * a, const void * b )
+{
+    double x = *(const double *) a, y = *(const double *) b;
+    return x < y ? -1 : x > y;
+}
+
+static void measure( const mb_kernel_t * kernel, result_t * r )
+{
+    double samples[ SAMPLES ], start, elapsed;
+    unsigned int reps = 1, i, j;
+
+    r->kernel = kernel;
+    r->calls = kernel->inputs();
+
+    /* passes per sample; the first time is a warmup */
+    for ( ;; ) {
+        start = now_ns();
+        for ( j = 0; j < reps; j++ )
+            kernel->run();
+        elapsed = now_ns() - start;
+        if ( elapsed >= SAMPLE_NS )
+            break;
+        reps *= elapsed > 0 && SAMPLE_NS / elapsed < 10 ? 2 : 10;
+    }
+
+    r->mean = 0;
+    for ( i = 0; i < SAMPLES; i++ ) {
+        start = now_ns();
+        for ( j = 0; j < reps; j++ )
+            kernel->run();
+        samples[ i ] = (now_ns() - start) / ((double) reps * r->calls);
+        r->mean += samples[ i ];
+    }
+    r->mean /= SAMPLES;
+
+    r->stddev = 0;
+    for ( i = 0; i < SAMPLES; i++ )
+        r->stddev += (samples[ i ] - r->mean) * (samples[ i ] - r->mean);
+    r->stddev = sqrt( r->stddev / (SAMPLES - 1) );
+
+    qsort( samples, SAMPLES, sizeof(double), compare_double );
+    r->median = samples[ SAMPLES / 2 ];
+    r->min = samples[ 0 ];
+}
+
+static int save( const char * filename, const result_t * results, int count )
+{
+    FILE * fp = fopen( filename, "w" );
+    int i;
+
+    if ( !fp ) {
+        fprintf( stderr, "microbench: cannot write \"%s\"\n", filename );
+        return 0;
+    }
+    fprintf( fp, "{\n  \"kernels\": {\n" );
+    for ( i = 0; i < count; i++ )
+        fprintf( fp, "    \"%s\": {\"calls\": %u, \"median_ns\": %.2f, \"mean_ns\": %.2f, \"stddev_ns\": %.2f, \"min_ns\": %.2f}%s\n",
+                 results[ i ].kernel->name, results[ i ].calls, results[ i ].median, results[ i ].mean,
+                 results[ i ].stddev, results[ i ].min, i + 1 < count ? "," : "" );
+    fprintf( fp, "  }\n}\n" );
+    fclose( fp );
+    printf( "saved %s\n", filename );
+    return 1;
+}
+
+/* the results of a file of save(), one kernel per line */
+static int compare( const char * filename, const result_t * results, int count )
+{
+    FILE * fp = fopen( filename, "r" );
+    char line[ 512 ], name[ 128 ];
+    int i, changed = 0;
+
+    if ( !fp ) {
+        fprintf( stderr, "microbench: cannot open \"%s\"\n", filename );
+        return 0;
+    }
+    printf( "\n%-32s %12s %12s %8s\n", "compared to", "base ns", "ns", "change" );
+    while ( fgets( line, sizeof(line), fp ) ) {
+        unsigned int calls;
+        double median, mean, stddev, min;
+
+        if ( sscanf( line, " \"%127[^\"]\": {\"calls\": %u, \"median_ns\": %lf, \"mean_ns\": %lf, \"stddev_ns\": %lf, \"min_ns\": %lf",
+                     name, &calls, &median, &mean, &stddev, &min ) != 6 )
+            continue;
+        for ( i = 0; i < count && strcmp( results[ i ].kernel->name, name ); i++ )
+            ;
+        if ( i == count )
+            continue;
+
+        const result_t * r = &results[ i ];
+        double delta = r->median - median;
+        int significant = fabs( delta ) > 3 * sqrt( stddev * stddev + r->stddev * r->stddev );
+        changed += significant;
+        printf( "%-32s %12.1f %12.1f %+7.1f%%%s\n", name, median, r->median,
+                median > 0 ? 100 * delta / median : 0, significant ? (delta < 0 ? "  faster" : "  SLOWER") : "" );
+    }
+    fclose( fp );
+    printf( "%d kernel(s) changed beyond 3 standard deviations\n", changed );
+    return 1;
+}
+
+int main( int argc, char ** argv )
+{
+    const char * langdir = "lang", * voice = "en-US", * textfile = 0, * filter = 0;
+    const char * savefile = 0, * comparefile = 0;
+    char corpus[ 1024 ];
+    result_t results[ MAX_KERNELS ];
+    pico_Engine engine;
+    char * text;
+    int i, j, count = 0;
+
+    for ( i = 1; i < argc; i++ ) {
+        if ( i + 1 < argc && !strcmp( argv[i], "-l" ) )
+            langdir = argv[ ++i ];
+        else if ( i + 1 < argc && !strcmp( argv[i], "-v" ) )
+            voice = argv[ ++i ];
+        else if ( i + 1 < argc && !strcmp( argv[i], "-t" ) )
+            textfile = argv[ ++i ];
+        else if ( i + 1 < argc && !strcmp( argv[i], "--filter" ) )
+            filter = argv[ ++i ];
+        else if ( i + 1 < argc && !strcmp( argv[i], "--save" ) )
+            savefile = argv[ ++i ];
+        else if ( i + 1 < argc && !strcmp( argv[i], "--compare" ) )
+            comparefile = argv[ ++i ];
+        else {
+            fprintf( stderr, "usage: microbench [-l langdir] [-v voice] [-t text file] [--filter name]\n"
+                             "                  [--save file.json] [--compare file.json]\n" );
+            return 2;
+        }
+    }
+    if ( !textfile ) {
+        snprintf( corpus, sizeof(corpus), "tests/corpus/%s.txt", voice );
+        textfile = corpus;
+    }
+
+    if ( !(text = read_text( textfile ))
+            || !check( pico_initialize( memory, MEM_SIZE, &system_ ), "initialize" )
+            || !load_voice( langdir, voice ) )
+        return 1;
+
+    /* the memory managers of an engine, from its start to its end */
+    mb_capturing_alloc = 1;
+    if ( !check( pico_newEngine( system_, (const pico_Char *) VOICE_NAME, &engine ), "engine" )
+            || !synthesize( engine, text )
+            || !check( pico_disposeEngine( system_, &engine ), "engine" ) )
+        return 1;
+    mb_capturing_alloc = 0;
+
+    /* the others on an engine that stays, their inputs point into it */
+    if ( !check( pico_newEngine( system_, (const pico_Char *) VOICE_NAME, &engine ), "engine" ) )
+        return 1;
+    mb_capturing = 1;
+    if ( !synthesize( engine, text ) )
+        return 1;
+    mb_capturing = 0;
+
+    printf( "%-32s %8s %12s %12s %12s %12s\n", "kernel", "calls", "median ns", "mean ns", "stddev", "min ns" );
+    for ( i = 0; kernel_tables[ i ]; i++ ) {
+        for ( j = 0; kernel_tables[ i ][ j ].name && count < MAX_KERNELS; j++ ) {
+            const mb_kernel_t * kernel = &kernel_tables[ i ][ j ];
+            if ( filter && !strstr( kernel->name, filter ) )
+                continue;
+            if ( !kernel->inputs() ) {
+                printf( "%-32s %8s\n", kernel->name, "none" );
+                continue;
+            }
+            result_t * r = &results[ count++ ];
+            measure( kernel, r );
+            printf( "%-32s %8u %12.1f %12.1f %12.1f %12.1f\n", kernel->name, r->calls, r->median, r->mean,
+                    r->stddev, r->min );
+            fflush( stdout );
+        }
+    }
+
+    if ( savefile && !save( savefile, results, count ) )
+        return 1;
+    if ( comparefile && !compare( comparefile, results, count ) )
+        return 1;
+    return 0;
+}
@@ -0,0 +1,42 @@
+/*
+ * microbench: the hot kernels of svoxpico, timed one at a time
+ *
+ * The inputs are real: every capture_*.c compiles one svoxpico source with
+ * a wrapper around its kernels, which keeps a copy of the arguments while
+ * microbench.c synthesizes a text. The kernels are then called again with
+ * those arguments, in a loop and in isolation. A capture file defines all
+ * symbols of its source, so the copy in libttspico.a isn't linked.
+ */
+#ifndef MICROBENCH_H_
+#define MICROBENCH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MB_MAX_INPUTS 4096          /* captured per kernel, the first ones */
+
+extern int mb_capturing;            /* the kernels' arguments are kept */
+extern int mb_capturing_alloc;      /* the memory manager calls are kept */
+
+typedef struct {
+    const char *    name;
+    unsigned int    (*inputs)(void);    /* calls captured */
+    void            (*run)(void);       /* makes all of them again */
+} mb_kernel_t;
+
+/* the kernels of each capture file, ending with an empty name */
+extern const mb_kernel_t mb_fft_kernels[];
+extern const mb_kernel_t mb_kdt_kernels[];
+extern const mb_kernel_t mb_klex_kernels[];
+extern const mb_kernel_t mb_ktab_kernels[];
+extern const mb_kernel_t mb_trns_kernels[];
+extern const mb_kernel_t mb_os_kernels[];
+extern const mb_kernel_t mb_data_kernels[];
+extern const mb_kernel_t mb_cep_kernels[];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MICROBENCH_H_ */
@@ -0,0 +1,60 @@
+/*
+ * snr: signal to noise ratio of a 16-bit PCM file against a reference
+ *
+ * usage: snr <reference.raw> <test.raw> <min dB>
+ * prints the ratio; exits 1 if it is below min dB or the lengths differ
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+static short * read_pcm( const char * filename, long * count )
+{
+    FILE * fp = fopen( filename, "rb" );
+    short * samples;
+    long size;
+
+    if ( !fp ) {
+        fprintf( stderr, "snr: cannot open \"%s\"\n", filename );
+        return 0;
+    }
+    fseek( fp, 0, SEEK_END );
+    size = ftell( fp );
+    fseek( fp, 0, SEEK_SET );
+
+    samples = (short *) malloc( size + 1 );
+    *count = fread( samples, 1, size, fp ) / 2;
+    fclose( fp );
+    return samples;
+}
+
+int main( int argc, char ** argv )
+{
+    short * ref, * test;
+    long ref_count, test_count, i;
+    double signal = 0, noise = 0, db;
+
+    if ( argc != 4 ) {
+        fprintf( stderr, "usage: snr <reference.raw> <test.raw> <min dB>\n" );
+        return 2;
+    }
+    if ( !(ref = read_pcm( argv[1], &ref_count )) || !(test = read_pcm( argv[2], &test_count )) )
+        return 2;
+
+    if ( ref_count != test_count ) {
+        printf( "length %ld, expected %ld\n", test_count, ref_count );
+        return 1;
+    }
+
+    for ( i = 0; i < ref_count; i++ ) {
+        double r = ref[i], d = test[i] - ref[i];
+        signal += r * r;
+        noise += d * d;
+    }
+    db = noise > 0 ? 10 * log10( signal / noise ) : INFINITY;
+    printf( "%.1f dB\n", db );
+
+    free( ref );
+    free( test );
+    return db < atof( argv[3] ) ? 1 : 0;
+}